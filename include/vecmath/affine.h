@@ -0,0 +1,405 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+
+namespace vm {
+    /**
+     * An affine transformation of S dimensional space. It is represented by the upper S rows of the corresponding
+     * (S+1)x(S+1) transformation matrix, whose last row is always (0, ..., 0, 1) and is therefore not stored. For three
+     * dimensional space, this is a 3x4 matrix. Compared to a 4x4 matrix, it uses a quarter less memory, and applying it
+     * to a point or composing it with another affine transformation needs a quarter fewer multiplications.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     */
+    template <typename T, std::size_t S>
+    class affine {
+    public:
+        using type = T;
+        using column_type = vec<T,S>;
+        static const std::size_t rows = S;
+        static const std::size_t cols = S+1;
+
+        /**
+         * The matrix components in column major format. The first S columns contain the linear part, and the last
+         * column contains the translation.
+         */
+        column_type v[S+1];
+    public:
+        /* ========== constructors and assignment operators ========== */
+
+        /**
+         * Creates a new identity transformation.
+         */
+        constexpr affine() : v{} {
+            for (std::size_t c = 0; c < S; ++c) {
+                v[c][c] = static_cast<T>(1.0);
+            }
+        }
+
+        // Copy and move constructors
+        affine(const affine<T,S>& other) = default;
+        affine(affine<T,S>&& other) noexcept = default;
+
+        // Assignment operators
+        affine<T,S>& operator=(const affine<T,S>& other) = default;
+        affine<T,S>& operator=(affine<T,S>&& other) noexcept = default;
+
+        /**
+         * Creates a transformation which applies the given linear transformation followed by the given translation.
+         *
+         * @param linear the linear part
+         * @param translation the translation
+         */
+        constexpr affine(const mat<T,S,S>& linear, const vec<T,S>& translation) : v{} {
+            for (std::size_t c = 0; c < S; ++c) {
+                v[c] = linear[c];
+            }
+            v[S] = translation;
+        }
+
+        /**
+         * Creates a transformation from the given matrix. The given matrix must be affine, that is, its last row must
+         * be (0, ..., 0, 1). This is only checked in debug builds.
+         *
+         * @param m the matrix
+         */
+        constexpr explicit affine(const mat<T,S+1,S+1>& m) : v{} {
+            assert(is_affine(m));
+            for (std::size_t c = 0; c < S+1; ++c) {
+                for (std::size_t r = 0; r < S; ++r) {
+                    v[c][r] = m[c][r];
+                }
+            }
+        }
+
+        /**
+         * Creates a transformation with the components initialized to the values of the corresponding components of
+         * the given transformation. If the given transformation has a different component type, its components are
+         * converted using static_cast.
+         *
+         * @tparam U the component type of the given transformation
+         * @param other the transformation to copy
+         */
+        template <typename U>
+        constexpr explicit affine(const affine<U,S>& other) : v{} {
+            for (std::size_t c = 0; c < S+1; ++c) {
+                v[c] = vec<T,S>(other[c]);
+            }
+        }
+    public:
+        /* ========== accessors ========== */
+
+        /**
+         * Returns the column at the given index. The column at index S is the translation.
+         *
+         * @param index the index of the column to return
+         * @return the column at the given index
+         */
+        constexpr vec<T,S>& operator[](const std::size_t index) {
+            assert(index < S+1);
+            return v[index];
+        }
+
+        /**
+         * Returns the column at the given index. The column at index S is the translation.
+         *
+         * @param index the index of the column to return
+         * @return the column at the given index
+         */
+        constexpr const vec<T,S>& operator[](const std::size_t index) const {
+            assert(index < S+1);
+            return v[index];
+        }
+
+        /**
+         * Returns the linear part of this transformation.
+         *
+         * @return a matrix containing the linear part
+         */
+        constexpr mat<T,S,S> linear() const {
+            mat<T,S,S> result;
+            for (std::size_t c = 0; c < S; ++c) {
+                result[c] = v[c];
+            }
+            return result;
+        }
+
+        /**
+         * Returns the translation of this transformation.
+         *
+         * @return the translation
+         */
+        constexpr const vec<T,S>& translation() const {
+            return v[S];
+        }
+
+        /**
+         * Returns the (S+1)x(S+1) matrix that represents this transformation.
+         *
+         * @return the matrix
+         */
+        constexpr mat<T,S+1,S+1> to_matrix() const {
+            mat<T,S+1,S+1> result;
+            for (std::size_t c = 0; c < S+1; ++c) {
+                for (std::size_t r = 0; r < S; ++r) {
+                    result[c][r] = v[c][r];
+                }
+            }
+            return result;
+        }
+    public:
+        /* ========== factory methods ========== */
+
+        /**
+         * Returns the identity transformation.
+         */
+        static constexpr affine<T,S> identity() {
+            return affine<T,S>();
+        }
+    };
+
+    /* ========== comparison operators ========== */
+
+    /**
+     * Compares the given two transformations column wise.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first transformation
+     * @param rhs the second transformation
+     * @param epsilon the epsilon value
+     * @return a negative value if there is a column in the left transformation that compares less than its
+     * corresponding column of the right transformation, a positive value in the opposite case, and 0 if all columns
+     * compare equal
+     */
+    template <typename T, std::size_t S>
+    constexpr int compare(const affine<T,S>& lhs, const affine<T,S>& rhs, const T epsilon = static_cast<T>(0.0)) {
+        for (std::size_t c = 0; c < S+1; ++c) {
+            const auto cmp = compare(lhs[c], rhs[c], epsilon);
+            if (cmp != 0) {
+                return cmp;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Checks whether the given transformations have equal components.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first transformation
+     * @param rhs the second transformation
+     * @param epsilon the epsilon value
+     * @return true if all components of the given transformations are equal, and false otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool is_equal(const affine<T,S>& lhs, const affine<T,S>& rhs, const T epsilon) {
+        return compare(lhs, rhs, epsilon) == 0;
+    }
+
+    /**
+     * Checks whether the given transformations have identical components.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first transformation
+     * @param rhs the second transformation
+     * @return true if all components of the given transformations are equal, and false otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool operator==(const affine<T,S>& lhs, const affine<T,S>& rhs) {
+        return compare(lhs, rhs) == 0;
+    }
+
+    /**
+     * Checks whether the given transformations have identical components.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first transformation
+     * @param rhs the second transformation
+     * @return false if all components of the given transformations are equal, and true otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool operator!=(const affine<T,S>& lhs, const affine<T,S>& rhs) {
+        return compare(lhs, rhs) != 0;
+    }
+
+    /* ========== arithmetic operators ========== */
+
+    /**
+     * Composes the given transformations. The resulting transformation first applies the right transformation and
+     * then the left transformation. The result equals the product of the corresponding matrices up to rounding, since
+     * the compiler may contract the products and sums into fused multiply-add instructions differently.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the transformation to apply second
+     * @param rhs the transformation to apply first
+     * @return the composed transformation
+     */
+    template <typename T, std::size_t S>
+    constexpr affine<T,S> operator*(const affine<T,S>& lhs, const affine<T,S>& rhs) {
+        affine<T,S> result;
+        for (std::size_t c = 0; c < S+1; ++c) {
+            for (std::size_t r = 0; r < S; ++r) {
+                auto sum = static_cast<T>(0.0);
+                for (std::size_t i = 0; i < S; ++i) {
+                    sum += lhs[i][r] * rhs[c][i];
+                }
+                result[c][r] = c == S ? sum + lhs[S][r] : sum;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Applies the given transformation to the given point. The result equals the product of the corresponding matrix
+     * and the point up to rounding, since the compiler may contract the products and sums into fused multiply-add
+     * instructions differently.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the transformation
+     * @param rhs the point
+     * @return the transformed point
+     */
+    template <typename T, std::size_t S>
+    constexpr vec<T,S> operator*(const affine<T,S>& lhs, const vec<T,S>& rhs) {
+        return transform_point(lhs, rhs);
+    }
+
+    /* ========== transformations ========== */
+
+    /**
+     * Applies the given transformation to the given point. The result equals the product of the corresponding matrix
+     * and the point up to rounding, since the compiler may contract the products and sums into fused multiply-add
+     * instructions differently.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param t the transformation
+     * @param p the point
+     * @return the transformed point
+     */
+    template <typename T, std::size_t S>
+    constexpr vec<T,S> transform_point(const affine<T,S>& t, const vec<T,S>& p) {
+        vec<T,S> result;
+        for (std::size_t r = 0; r < S; ++r) {
+            for (std::size_t c = 0; c < S; ++c) {
+                result[r] += t[c][r] * p[c];
+            }
+            result[r] += t[S][r];
+        }
+        return result;
+    }
+
+    /**
+     * Applies the linear part of the given transformation to the given vector. The translation is not applied.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param t the transformation
+     * @param v the vector
+     * @return the transformed vector
+     */
+    template <typename T, std::size_t S>
+    constexpr vec<T,S> transform_vector(const affine<T,S>& t, const vec<T,S>& v) {
+        vec<T,S> result;
+        for (std::size_t r = 0; r < S; ++r) {
+            for (std::size_t c = 0; c < S; ++c) {
+                result[r] += t[c][r] * v[c];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Applies the given transformation to the given surface normal, that is, multiplies the normal with the inverse
+     * transpose of the linear part of the transformation. Unlike transform_vector, this keeps the normal perpendicular
+     * to the transformed surface if the transformation contains non-uniform scaling or shearing. The result is not
+     * normalized.
+     *
+     * The linear part of the given transformation must be invertible.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param t the transformation
+     * @param n the normal
+     * @return the transformed normal
+     */
+    template <typename T, std::size_t S>
+    constexpr vec<T,S> transform_normal(const affine<T,S>& t, const vec<T,S>& n) {
+        const auto linear = t.linear();
+        const auto det = compute_determinant(linear);
+        assert(det != static_cast<T>(0.0));
+
+        // the transpose of the adjugate is det times the inverse transpose
+        return (transpose(compute_adjugate(linear)) * n) / det;
+    }
+
+    /**
+     * Inverts the given transformation if possible. The linear part is inverted, and the inverse translation is
+     * obtained by applying the inverted linear part to the negated translation. The linear part is considered not
+     * invertible under the same conditions as in invert for matrices.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param t the transformation to invert
+     * @return a pair of a boolean and a transformation such that the boolean indicates whether the transformation is
+     * invertible, and if so, the transformation is the inverse of the given transformation
+     */
+    template <typename T, std::size_t S>
+    constexpr std::tuple<bool, affine<T,S>> invert(const affine<T,S>& t) {
+        const auto linear = invert(t.linear());
+        if (!std::get<0>(linear)) {
+            return std::make_tuple(false, affine<T,S>::identity());
+        }
+
+        const auto& linearInverse = std::get<1>(linear);
+        return std::make_tuple(true, affine<T,S>(linearInverse, -(linearInverse * t.translation())));
+    }
+
+    /**
+     * Inverts the given rigid transformation, that is, a transformation that only rotates and translates. The inverse
+     * of the linear part is its transpose.
+     *
+     * The linear part of the given transformation must be orthonormal. This is only checked in debug builds.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param t the transformation to invert
+     * @return the inverted transformation
+     */
+    template <typename T, std::size_t S>
+    constexpr affine<T,S> invert_rigid(const affine<T,S>& t) {
+        const auto linearInverse = transpose(t.linear());
+        assert(is_equal(linearInverse * t.linear(), mat<T,S,S>::identity(), constants<T>::almost_zero()));
+        return affine<T,S>(linearInverse, -(linearInverse * t.translation()));
+    }
+}
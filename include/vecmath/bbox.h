@@ -20,6 +20,7 @@
 
 #include "vec.h"
 #include "mat.h"
+#include "affine.h"
 #include "quat.h"
 #include "scalar.h"
 
@@ -451,10 +452,19 @@ namespace vm {
          * Transforms this bounding box by applying the given transformation to each corner vertex. The result is the
          * smallest bounding box that contains the transformed vertices.
          *
+         * If the given matrix is affine, the result is computed directly from the matrix elements without
+         * transforming the vertices, see transform_affine. Otherwise, the vertices are transformed individually. The
+         * two methods may round differently, so the result can differ from the bounds of the transformed vertices by
+         * a few units in the last place.
+         *
          * @param transform the transformation
          * @return the transformed bounding box
          */
         constexpr bbox<T,S> transform(const mat<T,S+1,S+1>& transform) const {
+            if (is_affine(transform)) {
+                return transform_affine(transform);
+            }
+
             builder builder;
             const auto vertices = this->vertices();
             for (const auto& vertex : vertices) {
@@ -463,6 +473,46 @@ namespace vm {
             return builder.bounds();
         }
 
+        /**
+         * Transforms this bounding box by applying the given affine transformation to each corner vertex. The result is
+         * the smallest bounding box that contains the transformed vertices, up to rounding. It is computed directly from
+         * the elements of the transformation, see transform_affine.
+         *
+         * @param transform the transformation
+         * @return the transformed bounding box
+         */
+        constexpr bbox<T,S> transform(const affine<T,S>& transform) const {
+            return transform_affine(transform);
+        }
+    private:
+        /**
+         * Computes the bounds of the transformed vertices using Arvo's method. Each component of a transformed vertex
+         * is a sum of one product per axis plus the translation, and every product takes its smallest and largest
+         * value at the min or max of the box along that axis. Summing the smaller and the larger products yields the
+         * bounds of all 2^S transformed vertices without transforming them. The results match transforming the
+         * vertices only up to rounding, since the compiler may contract either computation into fused multiply-add
+         * instructions differently.
+         *
+         * @tparam M the type of the transformation, which must provide its columns via operator[]
+         * @param transform the transformation, where column S is the translation
+         * @return the transformed bounding box
+         */
+        template <typename M>
+        constexpr bbox<T,S> transform_affine(const M& transform) const {
+            bbox<T,S> result;
+            for (size_t r = 0; r < S; ++r) {
+                for (size_t c = 0; c < S; ++c) {
+                    const auto a = transform[c][r] * min[c];
+                    const auto b = transform[c][r] * max[c];
+                    result.min[r] += a < b ? a : b;
+                    result.max[r] += a < b ? b : a;
+                }
+                result.min[r] += transform[S][r];
+                result.max[r] += transform[S][r];
+            }
+            return result;
+        }
+    public:
         /**
          * Executes the given operation on every face of this bounding box. For each face, its four vertices
          * are passed to the given operation in a clock wise manner.
@@ -0,0 +1,353 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "scalar.h"
+#include "simd.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A sequence of bounding boxes that is stored as a structure of arrays, that is, each component of the min and
+     * max points of the boxes is stored in a separate contiguous array. This layout allows the functions declared
+     * below to test one query box against several stored boxes at once using SIMD instructions.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     */
+    template <typename T, std::size_t S>
+    class bbox_soa {
+    private:
+        std::vector<T> m_min[S];
+        std::vector<T> m_max[S];
+    public:
+        /**
+         * Creates a new empty sequence.
+         */
+        bbox_soa() = default;
+
+        /**
+         * Creates a new sequence containing the bounding boxes in the given range. Optionally accepts a
+         * transformation that is applied to each element of the range.
+         *
+         * @tparam I the range iterator type
+         * @tparam G the type of the transformation
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param get the transformation
+         */
+        template <typename I, typename G = identity, typename = decltype(*std::declval<I>())>
+        bbox_soa(I cur, I end, const G& get = G()) {
+            while (cur != end) {
+                push_back(get(*cur));
+                ++cur;
+            }
+        }
+
+        /**
+         * Returns the number of bounding boxes in this sequence.
+         */
+        std::size_t size() const {
+            return m_min[0].size();
+        }
+
+        /**
+         * Indicates whether this sequence is empty.
+         */
+        bool empty() const {
+            return size() == 0u;
+        }
+
+        /**
+         * Reserves storage for the given number of bounding boxes.
+         */
+        void reserve(const std::size_t count) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                m_min[c].reserve(count);
+                m_max[c].reserve(count);
+            }
+        }
+
+        /**
+         * Removes all bounding boxes from this sequence.
+         */
+        void clear() {
+            for (std::size_t c = 0u; c < S; ++c) {
+                m_min[c].clear();
+                m_max[c].clear();
+            }
+        }
+
+        /**
+         * Appends the given bounding box to this sequence.
+         */
+        void push_back(const bbox<T,S>& b) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                m_min[c].push_back(b.min[c]);
+                m_max[c].push_back(b.max[c]);
+            }
+        }
+
+        /**
+         * Replaces the bounding box at the given index.
+         */
+        void set(const std::size_t i, const bbox<T,S>& b) {
+            assert(i < size());
+            for (std::size_t c = 0u; c < S; ++c) {
+                m_min[c][i] = b.min[c];
+                m_max[c][i] = b.max[c];
+            }
+        }
+
+        /**
+         * Returns a copy of the bounding box at the given index.
+         */
+        bbox<T,S> operator[](const std::size_t i) const {
+            assert(i < size());
+            bbox<T,S> result;
+            for (std::size_t c = 0u; c < S; ++c) {
+                result.min[c] = m_min[c][i];
+                result.max[c] = m_max[c][i];
+            }
+            return result;
+        }
+
+        /**
+         * Returns a pointer to the contiguous array that stores the given component of the min points of all boxes.
+         */
+        const T* min_data(const std::size_t c) const {
+            assert(c < S);
+            return m_min[c].data();
+        }
+
+        /**
+         * Returns a pointer to the contiguous array that stores the given component of the max points of all boxes.
+         */
+        const T* max_data(const std::size_t c) const {
+            assert(c < S);
+            return m_max[c].data();
+        }
+    };
+
+    namespace detail {
+        /**
+         * Returns the number of trailing zero bits of the given non zero value.
+         */
+        constexpr unsigned count_trailing_zeros(std::uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctz(x));
+#else
+            unsigned result = 0u;
+            while ((x & 1u) == 0u) {
+                x >>= 1u;
+                ++result;
+            }
+            return result;
+#endif
+        }
+
+        /**
+         * Tests the given query box against every box of the given sequence, pack<T>::width boxes at a time. A box
+         * fails the test if, for any axis, the given rejection predicate holds. The predicates mirror the negated
+         * conditions of the corresponding member functions of bbox, so that NaN values are handled identically.
+         *
+         * The given operation is called once per pack with the index of its first box and a bit mask where bit l is
+         * set if the box at index i + l passes the test.
+         *
+         * @tparam T the component type
+         * @tparam S the number of dimensions
+         * @tparam R the type of the rejection predicate, which is passed the packs of the min and max components of
+         * the boxes and of the query and returns a pack mask
+         * @tparam Op the type of the operation
+         * @param query the query box
+         * @param boxes the boxes to test
+         * @param reject the rejection predicate
+         * @param op the operation
+         */
+        template <typename T, std::size_t S, typename R, typename Op>
+        void bbox_soa_test(const bbox<T,S>& query, const bbox_soa<T,S>& boxes, const R& reject, const Op& op) {
+            pack<T> queryMin[S];
+            pack<T> queryMax[S];
+            for (std::size_t c = 0u; c < S; ++c) {
+                queryMin[c] = pack<T>::broadcast(query.min[c]);
+                queryMax[c] = pack<T>::broadcast(query.max[c]);
+            }
+
+            for_each_pack<T>(boxes.size(), [&](const std::size_t i, const std::size_t n) {
+                auto rejected = reject(load_pack(boxes.min_data(0u) + i, n), load_pack(boxes.max_data(0u) + i, n), queryMin[0], queryMax[0]);
+                for (std::size_t c = 1u; c < S; ++c) {
+                    rejected = rejected | reject(load_pack(boxes.min_data(c) + i, n), load_pack(boxes.max_data(c) + i, n), queryMin[c], queryMax[c]);
+                }
+                op(i, (!rejected).bits() & ((1u << n) - 1u));
+            });
+        }
+
+        /**
+         * Collects the results of bbox_soa_test into a list of the indices of the boxes that pass the test.
+         */
+        template <typename T, std::size_t S, typename R>
+        std::vector<std::size_t> bbox_soa_find(const bbox<T,S>& query, const bbox_soa<T,S>& boxes, const R& reject) {
+            std::vector<std::size_t> result;
+            bbox_soa_test(query, boxes, reject, [&](const std::size_t i, unsigned bits) {
+                while (bits != 0u) {
+                    result.push_back(i + count_trailing_zeros(bits));
+                    bits &= bits - 1u;
+                }
+            });
+            return result;
+        }
+
+        /**
+         * Collects the results of bbox_soa_test into a bit mask where bit i % 64 of word i / 64 is set if the box at
+         * index i passes the test. Since the pack width divides 64, the bits of a pack never span two words.
+         */
+        template <typename T, std::size_t S, typename R>
+        std::vector<std::uint64_t> bbox_soa_mask(const bbox<T,S>& query, const bbox_soa<T,S>& boxes, const R& reject) {
+            static_assert(64u % pack<T>::width == 0u, "pack width must divide 64");
+            std::vector<std::uint64_t> result((boxes.size() + 63u) / 64u, 0u);
+            bbox_soa_test(query, boxes, reject, [&](const std::size_t i, const unsigned bits) {
+                result[i / 64u] |= static_cast<std::uint64_t>(bits) << (i % 64u);
+            });
+            return result;
+        }
+
+        struct bbox_soa_reject_intersects {
+            template <typename P>
+            auto operator()(const P& min, const P& max, const P& queryMin, const P& queryMax) const {
+                return (max < queryMin) | (min > queryMax);
+            }
+        };
+
+        struct bbox_soa_reject_contains {
+            template <typename P>
+            auto operator()(const P& min, const P& max, const P& queryMin, const P& queryMax) const {
+                return (min < queryMin) | (max > queryMax);
+            }
+        };
+
+        struct bbox_soa_reject_encloses {
+            template <typename P>
+            auto operator()(const P& min, const P& max, const P& queryMin, const P& queryMax) const {
+                return (min <= queryMin) | (max >= queryMax);
+            }
+        };
+    }
+
+    /**
+     * Returns the indices of the boxes in the given sequence which intersect the given query box, in ascending order.
+     * The result is identical to testing query.intersects(boxes[i]) for every index i.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the indices of the intersecting boxes
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::size_t> find_intersecting(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        return detail::bbox_soa_find(query, boxes, detail::bbox_soa_reject_intersects());
+    }
+
+    /**
+     * Returns the indices of the boxes in the given sequence which are contained in the given query box, in ascending
+     * order. The result is identical to testing query.contains(boxes[i]) for every index i.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the indices of the contained boxes
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::size_t> find_contained(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        assert(query.is_valid());
+        return detail::bbox_soa_find(query, boxes, detail::bbox_soa_reject_contains());
+    }
+
+    /**
+     * Returns the indices of the boxes in the given sequence which are enclosed in the given query box, in ascending
+     * order. The result is identical to testing query.encloses(boxes[i]) for every index i.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the indices of the enclosed boxes
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::size_t> find_enclosed(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        assert(query.is_valid());
+        return detail::bbox_soa_find(query, boxes, detail::bbox_soa_reject_encloses());
+    }
+
+    /**
+     * Returns a bit mask where bit i % 64 of word i / 64 is set if the box at index i in the given sequence intersects
+     * the given query box. The mask has one word per 64 boxes, and the bits of the last word which do not correspond
+     * to a box are not set.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the bit mask
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::uint64_t> intersecting_mask(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        return detail::bbox_soa_mask(query, boxes, detail::bbox_soa_reject_intersects());
+    }
+
+    /**
+     * Returns a bit mask where bit i % 64 of word i / 64 is set if the box at index i in the given sequence is
+     * contained in the given query box. See intersecting_mask for the layout of the mask.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the bit mask
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::uint64_t> contained_mask(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        assert(query.is_valid());
+        return detail::bbox_soa_mask(query, boxes, detail::bbox_soa_reject_contains());
+    }
+
+    /**
+     * Returns a bit mask where bit i % 64 of word i / 64 is set if the box at index i in the given sequence is
+     * enclosed in the given query box. See intersecting_mask for the layout of the mask.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param query the query box
+     * @param boxes the boxes to test
+     * @return the bit mask
+     */
+    template <typename T, std::size_t S>
+    std::vector<std::uint64_t> enclosed_mask(const bbox<T,S>& query, const bbox_soa<T,S>& boxes) {
+        assert(query.is_valid());
+        return detail::bbox_soa_mask(query, boxes, detail::bbox_soa_reject_encloses());
+    }
+}
@@ -0,0 +1,769 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "ray.h"
+#include "intersection.h"
+#include "scalar.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A dynamic bounding volume tree over a changing set of bounding boxes, used to find the boxes that overlap a
+     * given box, each other or a given ray. Unlike bvh, boxes can be inserted, removed and moved at any time without
+     * rebuilding the tree.
+     *
+     * Each box is stored in a leaf whose bounds are fattened by a margin, so that small movements do not require any
+     * change to the tree. If a box leaves its fat bounds, its leaf is removed and reinserted at the position with the
+     * lowest surface area cost. After each change, the ancestors of the affected leaf are updated using two kinds of
+     * tree rotations: rotations that reduce the surface area of the nodes, which keep queries fast as the tree
+     * changes, and AVL rotations, which keep the height of the tree logarithmic in the number of leaves.
+     *
+     * Every box is identified by a proxy id, which remains valid and unchanged until the box is removed, after which
+     * it may be reused. All nodes are taken from an internal pool that grows geometrically and keeps released nodes
+     * in a free list, so inserting and removing boxes does not allocate memory per node.
+     *
+     * Queries report the fat bounds, so they may report boxes that do not overlap the query by up to the margin.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam U the type of the user data stored with each box, must be default constructible
+     */
+    template <typename T, std::size_t S, typename U>
+    class bbox_tree {
+    public:
+        /**
+         * The id that is never assigned to a box. It is returned by queries that do not find any box.
+         */
+        static constexpr std::size_t invalid_id = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * The maximum height of the tree. Since the tree is kept balanced, this is never reached, but it bounds the
+         * size of the traversal stack.
+         */
+        static constexpr std::size_t max_height = 128u;
+    private:
+
+        struct node {
+            bbox<T,S> bounds;
+            /** The parent of this node, or the next node in the free list if this node is free. */
+            std::size_t parent = invalid_id;
+            std::size_t child1 = invalid_id;
+            std::size_t child2 = invalid_id;
+            /** 0 for leaves and -1 for free nodes. */
+            int height = -1;
+            U data = U();
+
+            bool is_leaf() const {
+                return child1 == invalid_id;
+            }
+        };
+
+        std::vector<node> m_nodes;
+        std::size_t m_root;
+        std::size_t m_freeList;
+        std::size_t m_size;
+        T m_margin;
+    public:
+        /**
+         * Creates an empty tree.
+         *
+         * @param margin the distance by which the bounds of each box are fattened
+         */
+        explicit bbox_tree(const T margin = T(0.0)) :
+        m_root(invalid_id),
+        m_freeList(invalid_id),
+        m_size(0u),
+        m_margin(margin) {
+            assert(margin >= T(0.0));
+        }
+
+        /**
+         * Indicates whether this tree contains any boxes.
+         */
+        bool empty() const {
+            return m_size == 0u;
+        }
+
+        /**
+         * Returns the number of boxes in this tree.
+         */
+        std::size_t size() const {
+            return m_size;
+        }
+
+        /**
+         * Returns the height of this tree, which is 0 if the tree is empty or contains a single box.
+         */
+        std::size_t height() const {
+            return m_root == invalid_id ? 0u : static_cast<std::size_t>(m_nodes[m_root].height);
+        }
+
+        /**
+         * Returns the margin by which the bounds of each box are fattened.
+         */
+        T margin() const {
+            return m_margin;
+        }
+
+        /**
+         * Returns the bounding box of the fat bounds of all boxes. The tree must not be empty.
+         */
+        const bbox<T,S>& bounds() const {
+            assert(!empty());
+            return m_nodes[m_root].bounds;
+        }
+
+        /**
+         * Removes all boxes. The node pool is kept for reuse.
+         */
+        void clear() {
+            m_nodes.clear();
+            m_root = invalid_id;
+            m_freeList = invalid_id;
+            m_size = 0u;
+        }
+
+        /**
+         * Inserts a box with the given bounds and user data.
+         *
+         * @param bounds the bounds of the box
+         * @param data the user data
+         * @return the proxy id of the box
+         */
+        std::size_t insert(const bbox<T,S>& bounds, U data = U()) {
+            const auto id = allocate_node();
+            auto& leaf = m_nodes[id];
+            leaf.bounds = bounds.expand(m_margin);
+            leaf.height = 0;
+            leaf.data = std::move(data);
+
+            insert_leaf(id);
+            ++m_size;
+            return id;
+        }
+
+        /**
+         * Removes the box with the given proxy id. The id becomes invalid and may be reused by later insertions.
+         *
+         * @param id the proxy id
+         */
+        void remove(const std::size_t id) {
+            assert(is_valid(id));
+            remove_leaf(id);
+            free_node(id);
+            --m_size;
+        }
+
+        /**
+         * Updates the bounds of the box with the given proxy id. If the fat bounds of the box still contain the given
+         * bounds and are not much larger than necessary, the tree remains unchanged. Otherwise, the box is reinserted
+         * with new fat bounds, which are additionally extended by the given displacement to anticipate further
+         * movement in the same direction.
+         *
+         * @param id the proxy id
+         * @param bounds the new bounds of the box
+         * @param displacement the expected displacement of the box until its next update
+         * @return true if the box was reinserted and false otherwise
+         */
+        bool move(const std::size_t id, const bbox<T,S>& bounds, const vec<T,S>& displacement = vec<T,S>::zero()) {
+            assert(is_valid(id));
+
+            auto fatBounds = bounds.expand(m_margin);
+            for (std::size_t i = 0u; i < S; ++i) {
+                if (displacement[i] < T(0.0)) {
+                    fatBounds.min[i] += displacement[i];
+                } else {
+                    fatBounds.max[i] += displacement[i];
+                }
+            }
+
+            const auto& treeBounds = m_nodes[id].bounds;
+            if (treeBounds.contains(bounds)) {
+                // keep the leaf unless its bounds are much larger than the new fat bounds, e.g. after a large
+                // displacement was anticipated
+                const auto hugeBounds = fatBounds.expand(T(4.0) * m_margin);
+                if (hugeBounds.contains(treeBounds)) {
+                    return false;
+                }
+            }
+
+            remove_leaf(id);
+            m_nodes[id].bounds = fatBounds;
+            insert_leaf(id);
+            return true;
+        }
+
+        /**
+         * Returns the fat bounds of the box with the given proxy id.
+         */
+        const bbox<T,S>& fat_bounds(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_nodes[id].bounds;
+        }
+
+        /**
+         * Returns the user data of the box with the given proxy id.
+         */
+        const U& data(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_nodes[id].data;
+        }
+
+        /**
+         * Returns the user data of the box with the given proxy id.
+         */
+        U& data(const std::size_t id) {
+            assert(is_valid(id));
+            return m_nodes[id].data;
+        }
+
+        /**
+         * Indicates whether the given proxy id refers to a box in this tree.
+         */
+        bool is_valid(const std::size_t id) const {
+            return id < m_nodes.size() && m_nodes[id].height == 0;
+        }
+
+        /**
+         * Calls the given function with the proxy id of each box whose fat bounds intersect the given bounding box.
+         * The function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param b the bounding box
+         * @param visit the function
+         */
+        template <typename F>
+        void query(const bbox<T,S>& b, F&& visit) const {
+            if (m_root == invalid_id) {
+                return;
+            }
+
+            assert(height() < max_height);
+            std::size_t stack[max_height + 1u];
+            std::size_t stackSize = 0u;
+            stack[stackSize++] = m_root;
+
+            while (stackSize > 0u) {
+                const auto& n = m_nodes[stack[--stackSize]];
+                if (!n.bounds.intersects(b)) {
+                    continue;
+                }
+
+                if (n.is_leaf()) {
+                    if (!visit(static_cast<std::size_t>(&n - m_nodes.data()))) {
+                        return;
+                    }
+                } else {
+                    stack[stackSize++] = n.child1;
+                    stack[stackSize++] = n.child2;
+                }
+            }
+        }
+
+        /**
+         * Calls the given function once for each pair of boxes whose fat bounds intersect each other, passing the
+         * proxy ids of both boxes with the smaller id first.
+         *
+         * @tparam F the type of the function
+         * @param visit the function
+         */
+        template <typename F>
+        void query_pairs(F&& visit) const {
+            for (std::size_t id = 0u; id < m_nodes.size(); ++id) {
+                if (m_nodes[id].height == 0) {
+                    query(m_nodes[id].bounds, [&](const std::size_t other) {
+                        if (id < other) {
+                            visit(id, other);
+                        }
+                        return true;
+                    });
+                }
+            }
+        }
+
+        /**
+         * Finds the closest box hit by the given ray. The given function is called with the proxy id of each box whose
+         * fat bounds are hit by the ray and that may be closer than the closest hit found so far. It must return the
+         * distance from the ray origin to the point where the ray hits the object represented by the box, or NaN if
+         * the ray does not hit it. Children are visited closest first, and nodes farther away than the closest hit
+         * found so far are skipped.
+         *
+         * @tparam F the type of the intersection function
+         * @param r the ray
+         * @param intersect the intersection function
+         * @return a pair of the distance to the closest hit and the proxy id of the box hit there, or NaN and
+         * invalid_id if the ray does not hit anything
+         */
+        template <typename F>
+        std::tuple<T, std::size_t> intersect_closest(const ray<T,S>& r, F&& intersect) const {
+            auto closestDistance = std::numeric_limits<T>::infinity();
+            auto closestId = invalid_id;
+            traverse(r, closestDistance, [&](const std::size_t id) {
+                const auto distance = intersect(id);
+                if (distance >= T(0.0) && distance < closestDistance) {
+                    closestDistance = distance;
+                    closestId = id;
+                }
+                return false;
+            });
+
+            if (closestId == invalid_id) {
+                return std::make_tuple(nan<T>(), closestId);
+            } else {
+                return std::make_tuple(closestDistance, closestId);
+            }
+        }
+
+        /**
+         * Finds any box hit by the given ray within the given distance. The given function is called as described for
+         * intersect_closest, and the traversal stops at the first hit.
+         *
+         * @tparam F the type of the intersection function
+         * @param r the ray
+         * @param intersect the intersection function
+         * @param maxDistance the maximum distance from the ray origin
+         * @return a pair of a boolean indicating whether a box was hit and the proxy id of that box, or invalid_id
+         * if nothing was hit
+         */
+        template <typename F>
+        std::tuple<bool, std::size_t> intersect_any(const ray<T,S>& r, F&& intersect, const T maxDistance = std::numeric_limits<T>::infinity()) const {
+            auto hitId = invalid_id;
+            traverse(r, maxDistance, [&](const std::size_t id) {
+                const auto distance = intersect(id);
+                if (distance >= T(0.0) && distance <= maxDistance) {
+                    hitId = id;
+                    return true;
+                }
+                return false;
+            });
+            return std::make_tuple(hitId != invalid_id, hitId);
+        }
+    private:
+        /**
+         * Visits the leaves hit by the given ray closer than the given distance, which the visitor may reduce, in
+         * front to back order. Stops if the visitor returns true.
+         */
+        template <typename V>
+        void traverse(const ray<T,S>& r, const T& maxDistance, V&& visit) const {
+            if (m_root == invalid_id) {
+                return;
+            }
+
+            const auto precomputed = ray_precomputed<T,S>(r);
+            const auto entry = [&](const std::size_t index) {
+                const auto [near, far] = intersect_ray_bbox_interval(precomputed, m_nodes[index].bounds, T(0.0), maxDistance);
+                return near <= far ? near : nan<T>();
+            };
+
+            // each entry holds a node and the distance at which the ray enters it
+            assert(height() < max_height);
+            std::pair<std::size_t, T> stack[max_height + 1u];
+            std::size_t stackSize = 0u;
+
+            const auto rootDistance = entry(m_root);
+            if (rootDistance <= maxDistance) {
+                stack[stackSize++] = std::make_pair(m_root, rootDistance);
+            }
+
+            while (stackSize > 0u) {
+                const auto [current, distance] = stack[--stackSize];
+                // the closest hit may have moved closer since the node was pushed
+                if (!(distance <= maxDistance)) {
+                    continue;
+                }
+
+                const auto& n = m_nodes[current];
+                if (n.is_leaf()) {
+                    if (visit(current)) {
+                        return;
+                    }
+                } else {
+                    const auto distance1 = entry(n.child1);
+                    const auto distance2 = entry(n.child2);
+                    const auto hit1 = distance1 <= maxDistance;
+                    const auto hit2 = distance2 <= maxDistance;
+
+                    // push the farther child first so that the closer child is visited first
+                    if (hit1 && hit2 && distance2 < distance1) {
+                        stack[stackSize++] = std::make_pair(n.child1, distance1);
+                        stack[stackSize++] = std::make_pair(n.child2, distance2);
+                    } else {
+                        if (hit2) {
+                            stack[stackSize++] = std::make_pair(n.child2, distance2);
+                        }
+                        if (hit1) {
+                            stack[stackSize++] = std::make_pair(n.child1, distance1);
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Returns the cost of a node with the given bounds, which is proportional to its surface area.
+         */
+        static T cost(const bbox<T,S>& b) {
+            const auto s = b.size();
+            if constexpr (S == 1u) {
+                return s[0];
+            } else {
+                auto result = T(0.0);
+                for (std::size_t i = 0u; i < S; ++i) {
+                    auto face = T(1.0);
+                    for (std::size_t j = 0u; j < S; ++j) {
+                        if (j != i) {
+                            face *= s[j];
+                        }
+                    }
+                    result += face;
+                }
+                return result;
+            }
+        }
+
+        /**
+         * Takes a node from the free list, growing the pool if the free list is empty.
+         */
+        std::size_t allocate_node() {
+            if (m_freeList == invalid_id) {
+                const auto oldSize = m_nodes.size();
+                const auto newSize = std::max(std::size_t(16u), 2u * oldSize);
+                m_nodes.resize(newSize);
+                for (std::size_t i = oldSize; i < newSize - 1u; ++i) {
+                    m_nodes[i].parent = i + 1u;
+                }
+                m_nodes[newSize - 1u].parent = invalid_id;
+                m_freeList = oldSize;
+            }
+
+            const auto id = m_freeList;
+            auto& n = m_nodes[id];
+            m_freeList = n.parent;
+            n.parent = invalid_id;
+            n.child1 = invalid_id;
+            n.child2 = invalid_id;
+            n.height = 0;
+            return id;
+        }
+
+        /**
+         * Returns the given node to the free list.
+         */
+        void free_node(const std::size_t id) {
+            auto& n = m_nodes[id];
+            n.parent = m_freeList;
+            n.height = -1;
+            n.data = U();
+            m_freeList = id;
+        }
+
+        /**
+         * Recomputes the bounds and the height of the given inner node from its children.
+         */
+        void refit(const std::size_t index) {
+            auto& n = m_nodes[index];
+            const auto& child1 = m_nodes[n.child1];
+            const auto& child2 = m_nodes[n.child2];
+            n.bounds = merge(child1.bounds, child2.bounds);
+            n.height = 1 + std::max(child1.height, child2.height);
+        }
+
+        /**
+         * Replaces the given child of the given parent with the given node, or makes that node the root if the
+         * parent is invalid_id.
+         */
+        void replace_child(const std::size_t parent, const std::size_t oldChild, const std::size_t newChild) {
+            if (parent == invalid_id) {
+                m_root = newChild;
+            } else if (m_nodes[parent].child1 == oldChild) {
+                m_nodes[parent].child1 = newChild;
+            } else {
+                assert(m_nodes[parent].child2 == oldChild);
+                m_nodes[parent].child2 = newChild;
+            }
+        }
+
+        /**
+         * Finds the node which, when made the sibling of a new leaf with the given bounds, increases the total cost
+         * of the inner nodes the least. The cost of choosing a node consists of the cost of the new parent, which
+         * encloses the node and the leaf, and the increase in cost of all ancestors of the node.
+         *
+         * The search descends into the child with the lower bound on the cost of choosing any node in its subtree,
+         * and stops once neither child can improve on the best node found so far.
+         */
+        std::size_t find_best_sibling(const bbox<T,S>& leafBounds) const {
+            const auto leafCost = cost(leafBounds);
+
+            auto index = m_root;
+            auto nodeCost = cost(m_nodes[index].bounds);
+            auto directCost = cost(merge(m_nodes[index].bounds, leafBounds));
+            auto inheritedCost = T(0.0);
+
+            auto bestSibling = index;
+            auto bestCost = directCost;
+
+            while (!m_nodes[index].is_leaf()) {
+                const auto& n = m_nodes[index];
+
+                const auto siblingCost = directCost + inheritedCost;
+                if (siblingCost < bestCost) {
+                    bestSibling = index;
+                    bestCost = siblingCost;
+                }
+
+                // choosing a descendant enlarges this node
+                inheritedCost += directCost - nodeCost;
+
+                const auto& child1 = m_nodes[n.child1];
+                const auto& child2 = m_nodes[n.child2];
+                const auto directCost1 = cost(merge(child1.bounds, leafBounds));
+                const auto directCost2 = cost(merge(child2.bounds, leafBounds));
+                const auto cost1 = child1.is_leaf() ? directCost1 : cost(child1.bounds);
+                const auto cost2 = child2.is_leaf() ? directCost2 : cost(child2.bounds);
+
+                // for a leaf, this is the cost of choosing it, for an inner node, it is a lower bound of the cost of
+                // choosing it or any of its descendants, which is at least the cost of the new parent
+                auto lowerCost1 = directCost1 + inheritedCost;
+                auto lowerCost2 = directCost2 + inheritedCost;
+                if (child1.is_leaf()) {
+                    if (lowerCost1 < bestCost) {
+                        bestSibling = n.child1;
+                        bestCost = lowerCost1;
+                    }
+                    lowerCost1 = std::numeric_limits<T>::infinity();
+                } else {
+                    lowerCost1 = inheritedCost + directCost1 + std::min(leafCost - cost1, T(0.0));
+                }
+                if (child2.is_leaf()) {
+                    if (lowerCost2 < bestCost) {
+                        bestSibling = n.child2;
+                        bestCost = lowerCost2;
+                    }
+                    lowerCost2 = std::numeric_limits<T>::infinity();
+                } else {
+                    lowerCost2 = inheritedCost + directCost2 + std::min(leafCost - cost2, T(0.0));
+                }
+
+                if (bestCost <= lowerCost1 && bestCost <= lowerCost2) {
+                    break;
+                }
+
+                if (lowerCost1 <= lowerCost2) {
+                    index = n.child1;
+                    nodeCost = cost1;
+                    directCost = directCost1;
+                } else {
+                    index = n.child2;
+                    nodeCost = cost2;
+                    directCost = directCost2;
+                }
+            }
+
+            return bestSibling;
+        }
+
+        /**
+         * Inserts the given leaf as the sibling of the node found by find_best_sibling, then refits and rebalances its
+         * ancestors.
+         */
+        void insert_leaf(const std::size_t leaf) {
+            if (m_root == invalid_id) {
+                m_root = leaf;
+                m_nodes[leaf].parent = invalid_id;
+                return;
+            }
+
+            const auto leafBounds = m_nodes[leaf].bounds;
+
+            const auto sibling = find_best_sibling(leafBounds);
+
+            // create a new parent for the sibling and the leaf
+            const auto oldParent = m_nodes[sibling].parent;
+            const auto newParent = allocate_node();
+
+            auto& p = m_nodes[newParent];
+            p.parent = oldParent;
+            p.child1 = sibling;
+            p.child2 = leaf;
+            p.bounds = merge(leafBounds, m_nodes[sibling].bounds);
+            p.height = m_nodes[sibling].height + 1;
+
+            replace_child(oldParent, sibling, newParent);
+            m_nodes[sibling].parent = newParent;
+            m_nodes[leaf].parent = newParent;
+
+            // refit and rebalance the ancestors
+            auto index = m_nodes[leaf].parent;
+            while (index != invalid_id) {
+                index = balance(index);
+                rotate(index);
+                refit(index);
+                index = m_nodes[index].parent;
+            }
+        }
+
+        /**
+         * Removes the given leaf from the tree and replaces its parent by its sibling, then refits and rebalances the
+         * ancestors. The leaf itself is not freed.
+         */
+        void remove_leaf(const std::size_t leaf) {
+            if (leaf == m_root) {
+                m_root = invalid_id;
+                return;
+            }
+
+            const auto parent = m_nodes[leaf].parent;
+            const auto grandParent = m_nodes[parent].parent;
+            const auto sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+            replace_child(grandParent, parent, sibling);
+            m_nodes[sibling].parent = grandParent;
+            free_node(parent);
+
+            auto index = grandParent;
+            while (index != invalid_id) {
+                index = balance(index);
+                rotate(index);
+                refit(index);
+                index = m_nodes[index].parent;
+            }
+        }
+
+        /**
+         * Swaps a child of the given node with a grandchild on the other side if that reduces the cost of the child
+         * that receives the swapped node.
+         */
+        void rotate(const std::size_t iA) {
+            const auto& a = m_nodes[iA];
+            if (a.is_leaf()) {
+                return;
+            }
+
+            auto bestGain = T(0.0);
+            auto bestChild = invalid_id;
+            auto bestGrandChild = invalid_id;
+
+            const auto consider = [&](const std::size_t child, const std::size_t other) {
+                const auto& o = m_nodes[other];
+                if (o.is_leaf()) {
+                    return;
+                }
+
+                // swapping the child with one child of the other node makes the other node enclose the child and
+                // the remaining grand child
+                const auto& c = m_nodes[child];
+                const auto otherCost = cost(o.bounds);
+                const auto gain1 = otherCost - cost(merge(c.bounds, m_nodes[o.child2].bounds));
+                const auto gain2 = otherCost - cost(merge(c.bounds, m_nodes[o.child1].bounds));
+                if (gain1 > bestGain) {
+                    bestGain = gain1;
+                    bestChild = child;
+                    bestGrandChild = o.child1;
+                }
+                if (gain2 > bestGain) {
+                    bestGain = gain2;
+                    bestChild = child;
+                    bestGrandChild = o.child2;
+                }
+            };
+            consider(a.child1, a.child2);
+            consider(a.child2, a.child1);
+
+            if (bestChild != invalid_id) {
+                const auto other = m_nodes[bestGrandChild].parent;
+                replace_child(iA, bestChild, bestGrandChild);
+                replace_child(other, bestGrandChild, bestChild);
+                m_nodes[bestGrandChild].parent = iA;
+                m_nodes[bestChild].parent = other;
+                refit(other);
+            }
+        }
+
+        /**
+         * If the heights of the children of the given node differ by more than one, rotates the higher child up.
+         * Returns the index of the node that takes the place of the given node.
+         */
+        std::size_t balance(const std::size_t iA) {
+            auto& a = m_nodes[iA];
+            if (a.is_leaf() || a.height < 2) {
+                return iA;
+            }
+
+            const auto iB = a.child1;
+            const auto iC = a.child2;
+            const auto difference = m_nodes[iC].height - m_nodes[iB].height;
+
+            if (difference > 1) {
+                rotate_up(iA, iC, a.child2);
+                return iC;
+            } else if (difference < -1) {
+                rotate_up(iA, iB, a.child1);
+                return iB;
+            } else {
+                return iA;
+            }
+        }
+
+        /**
+         * Rotates the given child of node A up so that it takes the place of A. A adopts the lower child of the
+         * rotated node in the given child slot, and the rotated node adopts A in place of that child.
+         *
+         * @param iA the node to rotate down
+         * @param iX the child of A to rotate up
+         * @param slot the child slot of A that refers to X
+         */
+        void rotate_up(const std::size_t iA, const std::size_t iX, std::size_t& slot) {
+            auto& a = m_nodes[iA];
+            auto& x = m_nodes[iX];
+
+            const auto iF = x.child1;
+            const auto iG = x.child2;
+
+            // X takes the place of A
+            x.child1 = iA;
+            x.parent = a.parent;
+            a.parent = iX;
+            replace_child(x.parent, iA, iX);
+
+            // A adopts the lower child of X, and X keeps the higher one
+            if (m_nodes[iF].height > m_nodes[iG].height) {
+                x.child2 = iF;
+                slot = iG;
+                m_nodes[iG].parent = iA;
+            } else {
+                x.child2 = iG;
+                slot = iF;
+                m_nodes[iF].parent = iA;
+            }
+
+            refit(iA);
+            refit(iX);
+        }
+    };
+}
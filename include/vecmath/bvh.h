@@ -0,0 +1,553 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "ray.h"
+#include "intersection.h"
+#include "morton.h"
+#include "parallel.h"
+#include "scalar.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+namespace vm {
+    /**
+     * A bounding volume hierarchy over a set of primitives in three dimensional space, used to accelerate ray queries.
+     * The primitives are only known by their index in the range the hierarchy was built from and by their bounding
+     * boxes. Queries call back into user code to test a ray against a primitive.
+     *
+     * The hierarchy is a binary tree built top down by binning the primitive centroids and choosing the split with
+     * the lowest cost according to the surface area heuristic (SAH). The nodes are stored in a single array in depth
+     * first order, so the first child of an inner node immediately follows it, and only the index of the second child
+     * needs to be stored.
+     *
+     * For very large static scenes, build_linear creates a hierarchy with the same layout much faster, in parallel, by
+     * sorting the primitives along a Z-order curve instead of evaluating the SAH, at the cost of some query speed.
+     *
+     * @tparam T the component type
+     */
+    template <typename T>
+    class bvh {
+    public:
+        /**
+         * A node of the hierarchy. An inner node has count 0, its first child is the next node in the array, and
+         * offset is the index of its second child. A leaf node references count primitive indices, starting at
+         * offset in the array returned by primitives().
+         */
+        struct node {
+            bbox<T,3> bounds;
+            std::uint32_t offset;
+            std::uint32_t count;
+
+            /**
+             * Indicates whether this node is a leaf.
+             */
+            constexpr bool is_leaf() const {
+                return count > 0u;
+            }
+        };
+
+        /**
+         * The maximum depth of the hierarchy. Nodes at this depth become leaves regardless of their size. This bounds
+         * the size of the traversal stack.
+         */
+        static constexpr std::size_t max_depth = 64u;
+
+        /**
+         * The number of bins used to find the best split of a node.
+         */
+        static constexpr std::size_t bin_count = 16u;
+    private:
+        std::vector<node> m_nodes;
+        std::vector<std::size_t> m_primitives;
+    public:
+        /**
+         * Creates an empty hierarchy.
+         */
+        bvh() = default;
+
+        /**
+         * Creates a hierarchy over the primitives in the given range. The primitives are identified by their position
+         * in the range.
+         *
+         * @tparam I the range iterator type
+         * @tparam G the type of the function that returns the bounding box of a primitive
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param getBounds the function that returns the bounding box of a primitive
+         * @param maxLeafSize the maximum number of primitives in a leaf, unless the primitives cannot be separated
+         */
+        template <typename I, typename G>
+        bvh(I cur, I end, const G& getBounds, const std::size_t maxLeafSize = 4u) {
+            assert(maxLeafSize > 0u);
+
+            std::vector<bbox<T,3>> bounds;
+            std::vector<vec<T,3>> centers;
+            while (cur != end) {
+                bounds.push_back(getBounds(*cur));
+                centers.push_back(bounds.back().center());
+                m_primitives.push_back(m_primitives.size());
+                ++cur;
+            }
+
+            if (!m_primitives.empty()) {
+                m_nodes.reserve(2u * m_primitives.size() - 1u);
+                build(bounds, centers, 0u, m_primitives.size(), 0u, maxLeafSize);
+            }
+        }
+
+        /**
+         * Creates a linear bounding volume hierarchy (LBVH) over the primitives in the given range in parallel. The
+         * primitives are sorted by the 63 bit Morton codes of their centers, and the hierarchy is the binary radix
+         * tree over the sorted codes, which is built using the method by Karras, "Maximizing Parallelism in the
+         * Construction of BVHs, Octrees, and k-d Trees" (2012). Primitives with equal codes are separated by their
+         * position in the sorted order.
+         *
+         * The resulting hierarchy has the same layout as one built by the constructor and supports the same queries.
+         * The result does not depend on the number of threads.
+         *
+         * @tparam I the range iterator type, must be a random access iterator
+         * @tparam G the type of the function that returns the bounding box of a primitive, which must be safe to call
+         * from several threads at once
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param getBounds the function that returns the bounding box of a primitive
+         * @param maxLeafSize subtrees with at most this many primitives are collapsed into a leaf
+         * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+         * @return the hierarchy
+         */
+        template <typename I, typename G>
+        static bvh build_linear(I cur, I end, const G& getBounds, const std::size_t maxLeafSize = 1u, const std::size_t threadCount = 0u) {
+            using D = typename std::iterator_traits<I>::difference_type;
+            detail::assert_random_access<I>();
+            assert(maxLeafSize > 0u);
+
+            const auto count = static_cast<std::size_t>(end - cur);
+            assert(count <= std::numeric_limits<std::uint32_t>::max());
+
+            bvh result;
+            if (count == 0u) {
+                return result;
+            }
+
+            std::vector<bbox<T,3>> bounds(count);
+            std::vector<vec<T,3>> centers(count);
+            detail::parallel_for_blocks(count, threadCount, [&](const std::size_t begin, const std::size_t blockEnd) {
+                for (std::size_t i = begin; i < blockEnd; ++i) {
+                    bounds[i] = getBounds(*(cur + static_cast<D>(i)));
+                    centers[i] = bounds[i].center();
+                }
+            });
+
+            const auto centerBounds = parallel_merge_all(centers.data(), count, threadCount);
+            std::vector<std::uint64_t> codes(count);
+            std::vector<std::uint32_t> order(count);
+            detail::parallel_for_blocks(count, threadCount, [&](const std::size_t begin, const std::size_t blockEnd) {
+                for (std::size_t i = begin; i < blockEnd; ++i) {
+                    codes[i] = morton_code_63(centers[i], centerBounds);
+                    order[i] = static_cast<std::uint32_t>(i);
+                }
+            });
+            parallel_radix_sort(codes.data(), order.data(), count, threadCount);
+
+            // inner node i of the radix tree splits its range of sorted primitives after splits[i]
+            std::vector<std::uint32_t> splits(count - 1u);
+            detail::parallel_for_blocks(count - 1u, threadCount, [&](const std::size_t begin, const std::size_t blockEnd) {
+                for (std::size_t i = begin; i < blockEnd; ++i) {
+                    splits[i] = radix_split(codes, static_cast<std::ptrdiff_t>(i));
+                }
+            });
+
+            result.m_primitives.assign(order.begin(), order.end());
+            result.m_nodes.reserve(2u * count - 1u);
+            result.build_radix(bounds, splits, 0u, count - 1u, 0u, 0u, maxLeafSize);
+            return result;
+        }
+
+        /**
+         * Indicates whether this hierarchy contains any primitives.
+         */
+        bool empty() const {
+            return m_nodes.empty();
+        }
+
+        /**
+         * Returns the bounding box of all primitives. The hierarchy must not be empty.
+         */
+        const bbox<T,3>& bounds() const {
+            assert(!empty());
+            return m_nodes.front().bounds;
+        }
+
+        /**
+         * Returns the nodes in depth first order. The first node is the root.
+         */
+        const std::vector<node>& nodes() const {
+            return m_nodes;
+        }
+
+        /**
+         * Returns the primitive indices referenced by the leaf nodes.
+         */
+        const std::vector<std::size_t>& primitives() const {
+            return m_primitives;
+        }
+
+        /**
+         * Finds the closest primitive hit by the given ray. The given function is called with the index of each
+         * primitive whose leaf node is hit by the ray and that may be closer than the closest hit found so far. It
+         * must return the distance from the ray origin to the point where the ray hits the primitive, or NaN if the
+         * ray does not hit it. Children are visited closest first, and nodes farther away than the closest hit found
+         * so far are skipped.
+         *
+         * @tparam F the type of the intersection function
+         * @param r the ray
+         * @param intersect the intersection function
+         * @return a pair of the distance to the closest hit and the index of the primitive hit there, or NaN and the
+         * number of primitives if the ray does not hit any primitive
+         */
+        template <typename F>
+        std::tuple<T, std::size_t> intersect_closest(const ray<T,3>& r, F&& intersect) const {
+            auto closestDistance = std::numeric_limits<T>::infinity();
+            auto closestPrimitive = m_primitives.size();
+            traverse(r, closestDistance, [&](const std::size_t primitive) {
+                const auto distance = intersect(primitive);
+                if (distance >= T(0.0) && distance < closestDistance) {
+                    closestDistance = distance;
+                    closestPrimitive = primitive;
+                }
+                return false;
+            });
+
+            if (closestPrimitive == m_primitives.size()) {
+                return std::make_tuple(nan<T>(), closestPrimitive);
+            } else {
+                return std::make_tuple(closestDistance, closestPrimitive);
+            }
+        }
+
+        /**
+         * Finds any primitive hit by the given ray within the given distance, as needed for occlusion tests. The
+         * given function is called as described for intersect_closest, and the traversal stops at the first hit.
+         *
+         * @tparam F the type of the intersection function
+         * @param r the ray
+         * @param intersect the intersection function
+         * @param maxDistance the maximum distance from the ray origin
+         * @return a pair of a boolean indicating whether a primitive was hit and the index of that primitive, or the
+         * number of primitives if no primitive was hit
+         */
+        template <typename F>
+        std::tuple<bool, std::size_t> intersect_any(const ray<T,3>& r, F&& intersect, const T maxDistance = std::numeric_limits<T>::infinity()) const {
+            auto hitPrimitive = m_primitives.size();
+            traverse(r, maxDistance, [&](const std::size_t primitive) {
+                const auto distance = intersect(primitive);
+                if (distance >= T(0.0) && distance <= maxDistance) {
+                    hitPrimitive = primitive;
+                    return true;
+                }
+                return false;
+            });
+            return std::make_tuple(hitPrimitive != m_primitives.size(), hitPrimitive);
+        }
+    private:
+        /**
+         * Visits the leaves hit by the given ray closer than the given distance, which the visitor may reduce, in
+         * front to back order. Stops if the visitor returns true.
+         */
+        template <typename V>
+        void traverse(const ray<T,3>& r, const T& maxDistance, V&& visit) const {
+            if (m_nodes.empty()) {
+                return;
+            }
+
+            const auto precomputed = ray_precomputed<T,3>(r);
+            const auto entry = [&](const bbox<T,3>& b) {
+                const auto [near, far] = intersect_ray_bbox_interval(precomputed, b, T(0.0), maxDistance);
+                return near <= far ? near : nan<T>();
+            };
+
+            std::size_t stack[max_depth + 1u];
+            std::size_t stackSize = 0u;
+
+            std::size_t current = 0u;
+            if (!(entry(m_nodes[current].bounds) <= maxDistance)) {
+                return;
+            }
+
+            while (true) {
+                const auto& n = m_nodes[current];
+                if (n.is_leaf()) {
+                    for (std::size_t i = n.offset; i < n.offset + n.count; ++i) {
+                        if (visit(m_primitives[i])) {
+                            return;
+                        }
+                    }
+                } else {
+                    const auto first = current + 1u;
+                    const auto second = static_cast<std::size_t>(n.offset);
+                    const auto firstDistance = entry(m_nodes[first].bounds);
+                    const auto secondDistance = entry(m_nodes[second].bounds);
+                    const auto hitFirst = firstDistance <= maxDistance;
+                    const auto hitSecond = secondDistance <= maxDistance;
+
+                    if (hitFirst && hitSecond) {
+                        // visit the closer child first
+                        if (secondDistance < firstDistance) {
+                            stack[stackSize++] = first;
+                            current = second;
+                        } else {
+                            stack[stackSize++] = second;
+                            current = first;
+                        }
+                        continue;
+                    } else if (hitFirst) {
+                        current = first;
+                        continue;
+                    } else if (hitSecond) {
+                        current = second;
+                        continue;
+                    }
+                }
+
+                // the closest hit may have moved closer since a node was pushed, so test it again
+                do {
+                    if (stackSize == 0u) {
+                        return;
+                    }
+                    current = stack[--stackSize];
+                } while (!(entry(m_nodes[current].bounds) <= maxDistance));
+            }
+        }
+
+        static T surface_area(const bbox<T,3>& b) {
+            const auto s = b.size();
+            return T(2.0) * (s[0] * s[1] + s[1] * s[2] + s[2] * s[0]);
+        }
+
+        /**
+         * Builds the subtree for the primitives in [begin, end) of m_primitives and returns the index of its root.
+         */
+        std::size_t build(const std::vector<bbox<T,3>>& bounds, const std::vector<vec<T,3>>& centers, const std::size_t begin, const std::size_t end, const std::size_t depth, const std::size_t maxLeafSize) {
+            typename bbox<T,3>::builder nodeBounds;
+            typename bbox<T,3>::builder centerBounds;
+            for (std::size_t i = begin; i < end; ++i) {
+                nodeBounds.add(bounds[m_primitives[i]]);
+                centerBounds.add(centers[m_primitives[i]]);
+            }
+
+            const auto index = m_nodes.size();
+            m_nodes.push_back(node{ nodeBounds.bounds(), static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end - begin) });
+
+            const auto count = end - begin;
+            if (count == 1u || depth == max_depth) {
+                return index;
+            }
+
+            const auto mid = split(bounds, centers, begin, end, nodeBounds.bounds(), centerBounds.bounds(), maxLeafSize);
+            if (mid == begin || mid == end) {
+                return index;
+            }
+
+            m_nodes[index].count = 0u;
+            build(bounds, centers, begin, mid, depth + 1u, maxLeafSize);
+            const auto second = build(bounds, centers, mid, end, depth + 1u, maxLeafSize);
+            m_nodes[index].offset = static_cast<std::uint32_t>(second);
+            return index;
+        }
+
+        /**
+         * Returns the length of the common prefix of the sorted codes at positions i and j, or -1 if j is out of range.
+         * Equal codes are distinguished by their positions.
+         */
+        static int common_prefix(const std::vector<std::uint64_t>& codes, const std::ptrdiff_t i, const std::ptrdiff_t j) {
+            if (j < 0 || j >= static_cast<std::ptrdiff_t>(codes.size())) {
+                return -1;
+            }
+            const auto x = codes[static_cast<std::size_t>(i)] ^ codes[static_cast<std::size_t>(j)];
+            if (x != 0u) {
+                return static_cast<int>(detail::count_leading_zeros(x));
+            }
+            return 64 + static_cast<int>(detail::count_leading_zeros(static_cast<std::uint64_t>(i ^ j)));
+        }
+
+        /**
+         * Determines the range of sorted primitives covered by inner node i of the radix tree over the given codes,
+         * and returns the position of the last primitive of its first child.
+         */
+        static std::uint32_t radix_split(const std::vector<std::uint64_t>& codes, const std::ptrdiff_t i) {
+            // the range extends in the direction of the neighbor with the longer common prefix
+            const std::ptrdiff_t d = common_prefix(codes, i, i + 1) > common_prefix(codes, i, i - 1) ? 1 : -1;
+            const auto minPrefix = common_prefix(codes, i, i - d);
+
+            std::ptrdiff_t maxLength = 2;
+            while (common_prefix(codes, i, i + maxLength * d) > minPrefix) {
+                maxLength *= 2;
+            }
+
+            std::ptrdiff_t length = 0;
+            for (auto t = maxLength / 2; t > 0; t /= 2) {
+                if (common_prefix(codes, i, i + (length + t) * d) > minPrefix) {
+                    length += t;
+                }
+            }
+
+            // the split is after the last primitive that shares a longer prefix with i than the whole range does
+            const auto nodePrefix = common_prefix(codes, i, i + length * d);
+            std::ptrdiff_t split = 0;
+            auto t = length;
+            do {
+                t = (t + 1) / 2;
+                if (common_prefix(codes, i, i + (split + t) * d) > nodePrefix) {
+                    split += t;
+                }
+            } while (t > 1);
+
+            return static_cast<std::uint32_t>(i + split * d + std::min(d, std::ptrdiff_t(0)));
+        }
+
+        /**
+         * Creates the subtree for the sorted primitives in [first, last], which are covered by the given inner node of
+         * the radix tree, and returns the index of its root.
+         */
+        std::size_t build_radix(const std::vector<bbox<T,3>>& bounds, const std::vector<std::uint32_t>& splits, const std::size_t first, const std::size_t last, const std::size_t inner, const std::size_t depth, const std::size_t maxLeafSize) {
+            const auto index = m_nodes.size();
+            m_nodes.push_back(node{ bounds[m_primitives[first]], static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last - first + 1u) });
+
+            if (last - first + 1u <= maxLeafSize || depth == max_depth) {
+                for (auto i = first + 1u; i <= last; ++i) {
+                    m_nodes[index].bounds = merge(m_nodes[index].bounds, bounds[m_primitives[i]]);
+                }
+                return index;
+            }
+
+            const auto split = static_cast<std::size_t>(splits[inner]);
+            build_radix(bounds, splits, first, split, split, depth + 1u, maxLeafSize);
+            const auto second = build_radix(bounds, splits, split + 1u, last, split + 1u, depth + 1u, maxLeafSize);
+
+            m_nodes[index].bounds = merge(m_nodes[index + 1u].bounds, m_nodes[second].bounds);
+            m_nodes[index].offset = static_cast<std::uint32_t>(second);
+            m_nodes[index].count = 0u;
+            return index;
+        }
+
+        /**
+         * Partitions the primitives in [begin, end) of m_primitives using the split with the lowest SAH cost and
+         * returns the index of the first primitive of the second part. Returns begin if the primitives should remain
+         * in a leaf.
+         */
+        std::size_t split(const std::vector<bbox<T,3>>& bounds, const std::vector<vec<T,3>>& centers, const std::size_t begin, const std::size_t end, const bbox<T,3>& nodeBounds, const bbox<T,3>& centerBounds, const std::size_t maxLeafSize) {
+            const auto count = end - begin;
+            const auto extent = centerBounds.size();
+
+            auto bestCost = std::numeric_limits<T>::infinity();
+            auto bestAxis = std::size_t(0u);
+            auto bestSplit = std::size_t(0u);
+
+            for (std::size_t axis = 0u; axis < 3u; ++axis) {
+                if (!(extent[axis] > T(0.0))) {
+                    continue;
+                }
+
+                const auto scale = static_cast<T>(bin_count) / extent[axis];
+                const auto bin_of = [&](const std::size_t primitive) {
+                    const auto b = static_cast<std::size_t>((centers[primitive][axis] - centerBounds.min[axis]) * scale);
+                    return std::min(b, bin_count - 1u);
+                };
+
+                typename bbox<T,3>::builder binBounds[bin_count];
+                std::size_t binCounts[bin_count] = {};
+                for (std::size_t i = begin; i < end; ++i) {
+                    const auto b = bin_of(m_primitives[i]);
+                    binBounds[b].add(bounds[m_primitives[i]]);
+                    ++binCounts[b];
+                }
+
+                // sweep from the right to compute the area and count of all suffixes of the bins
+                T rightAreas[bin_count];
+                std::size_t rightCounts[bin_count];
+                typename bbox<T,3>::builder right;
+                std::size_t rightCount = 0u;
+                for (std::size_t b = bin_count; b-- > 1u;) {
+                    if (binCounts[b] > 0u) {
+                        right.add(binBounds[b].bounds());
+                        rightCount += binCounts[b];
+                    }
+                    rightAreas[b] = right.initialized() ? surface_area(right.bounds()) : T(0.0);
+                    rightCounts[b] = rightCount;
+                }
+
+                // sweep from the left and evaluate the split before each bin
+                typename bbox<T,3>::builder left;
+                std::size_t leftCount = 0u;
+                for (std::size_t b = 1u; b < bin_count; ++b) {
+                    if (binCounts[b - 1u] > 0u) {
+                        left.add(binBounds[b - 1u].bounds());
+                        leftCount += binCounts[b - 1u];
+                    }
+                    if (leftCount == 0u || rightCounts[b] == 0u) {
+                        continue;
+                    }
+
+                    const auto cost = surface_area(left.bounds()) * static_cast<T>(leftCount) + rightAreas[b] * static_cast<T>(rightCounts[b]);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b;
+                    }
+                }
+            }
+
+            const auto first = m_primitives.begin() + static_cast<std::ptrdiff_t>(begin);
+            const auto last = m_primitives.begin() + static_cast<std::ptrdiff_t>(end);
+
+            if (bestCost == std::numeric_limits<T>::infinity()) {
+                // all centers coincide, so split in the middle if the leaf would be too large
+                if (count <= maxLeafSize) {
+                    return begin;
+                }
+                return begin + count / 2u;
+            }
+
+            // compare with the cost of a leaf, assuming that traversing a node costs as much as one primitive test
+            const auto nodeArea = surface_area(nodeBounds);
+            const auto leafCost = static_cast<T>(count);
+            const auto splitCost = T(1.0) + (nodeArea > T(0.0) ? bestCost / nodeArea : static_cast<T>(count));
+            if (count <= maxLeafSize && leafCost <= splitCost) {
+                return begin;
+            }
+
+            const auto scale = static_cast<T>(bin_count) / extent[bestAxis];
+            const auto middle = std::partition(first, last, [&](const std::size_t primitive) {
+                const auto b = static_cast<std::size_t>((centers[primitive][bestAxis] - centerBounds.min[bestAxis]) * scale);
+                return std::min(b, bin_count - 1u) < bestSplit;
+            });
+            return static_cast<std::size_t>(middle - m_primitives.begin());
+        }
+    };
+}
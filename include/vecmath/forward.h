@@ -57,6 +57,9 @@ namespace vm {
     using vec4s = vec<size_t,4>;
     using vec4b = vec<bool,4>;
 
+    template<typename T, size_t S>
+    class vec_soa;
+
     template<typename T, size_t R, size_t C>
     class mat;
 
@@ -67,6 +70,15 @@ namespace vm {
     using mat3x3d = mat<double,3,3>;
     using mat4x4d = mat<double,4,4>;
 
+    template<typename T, size_t S>
+    class lu_decomposition;
+
+    template<typename T, size_t S>
+    class affine;
+
+    using affine3f = affine<float,3>;
+    using affine3d = affine<double,3>;
+
     template<typename T>
     class quat;
 
@@ -83,6 +95,15 @@ namespace vm {
     using bbox3f = bbox<float,3>;
     using bbox3d = bbox<double,3>;
 
+    template<typename T, size_t S>
+    class bbox_soa;
+
+    template<typename T, size_t S>
+    class obb;
+
+    using obb3f = obb<float,3>;
+    using obb3d = obb<double,3>;
+
     template<typename T, size_t S>
     class line;
 
@@ -95,12 +116,30 @@ namespace vm {
     using plane3f = plane<float,3>;
     using plane3d = plane<double,3>;
 
+    template<typename T>
+    class frustum;
+
+    using frustumf = frustum<float>;
+    using frustumd = frustum<double>;
+
     template<typename T, size_t S>
     class ray;
 
     using ray3f = ray<float,3>;
     using ray3d = ray<double,3>;
 
+    template<typename T, size_t S>
+    class ray_precomputed;
+
+    using ray_precomputed3f = ray_precomputed<float,3>;
+    using ray_precomputed3d = ray_precomputed<double,3>;
+
+    template<typename T, size_t S, size_t N>
+    class ray_packet;
+
+    template<typename T, size_t S, size_t N>
+    class bbox_packet;
+
     template<typename T, size_t S>
     class segment;
 
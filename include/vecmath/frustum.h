@@ -0,0 +1,263 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+#include "bbox.h"
+#include "plane.h"
+#include "simd.h"
+#include "util.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace vm {
+    /**
+     * A view frustum, represented as six planes whose normals point into the frustum, used to cull bounding boxes
+     * and spheres that cannot be visible. The planes are stored in the order left, right, bottom, top, near, far.
+     *
+     * A frustum can be extracted from any view projection matrix, i.e., the product of a projection and a view
+     * matrix, using the method by Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+     * World-View-Projection Matrix" (2001). The extracted frustum is in the world space of the view matrix.
+     *
+     * @tparam T the component type
+     */
+    template <typename T>
+    class frustum {
+    public:
+        /**
+         * The number of planes of a frustum.
+         */
+        static constexpr std::size_t plane_count = 6u;
+
+        /**
+         * A plane mask with a bit set for every plane.
+         */
+        static constexpr std::uint8_t all_planes = 0x3Fu;
+
+        plane<T,3> planes[plane_count];
+
+        /**
+         * Creates a frustum with all planes set to 0, which contains every point.
+         */
+        constexpr frustum() = default;
+
+        /**
+         * Creates a frustum with the given planes, whose normals must point into the frustum.
+         */
+        constexpr frustum(const plane<T,3>& left, const plane<T,3>& right, const plane<T,3>& bottom, const plane<T,3>& top, const plane<T,3>& nearPlane, const plane<T,3>& farPlane) :
+        planes{ left, right, bottom, top, nearPlane, farPlane } {}
+
+        /**
+         * Extracts the frustum of the given view projection matrix, which maps the frustum to the clip space cube
+         * [-w, w] in all three axes, as the matrices returned by perspective_matrix and ortho_matrix do. The normals
+         * of the planes are normalized, so point_distance returns Euclidean distances.
+         *
+         * @param m the view projection matrix
+         */
+        constexpr explicit frustum(const mat<T,4,4>& m) {
+            const auto row = [&](const std::size_t r) {
+                return vec<T,4>(m[0][r], m[1][r], m[2][r], m[3][r]);
+            };
+            const auto make_plane = [](const vec<T,4>& p) {
+                // the plane a*x + b*y + c*z + d = 0 with the inside where the left side is positive
+                const auto n = vec<T,3>(p[0], p[1], p[2]);
+                const auto l = length_c(n);
+                return plane<T,3>(-p[3] / l, n / l);
+            };
+
+            const auto w = row(3u);
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                planes[2u * i]      = make_plane(w + row(i));
+                planes[2u * i + 1u] = make_plane(w - row(i));
+            }
+        }
+
+        /**
+         * Indicates whether the given point is inside of this frustum or on its boundary.
+         */
+        constexpr bool contains(const vec<T,3>& point) const {
+            for (const auto& p : planes) {
+                if (p.point_distance(point) < T(0.0)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Classifies the given bounding box with respect to this frustum. For each plane, only the corner of the box
+         * farthest along the plane normal (the p-vertex) and the opposite corner (the n-vertex) are tested. A box is
+         * outside if it is entirely behind one of the planes, which may classify boxes near the edges of the frustum
+         * as intersecting even though they are outside.
+         *
+         * @param b the bounding box
+         * @return the classification
+         */
+        constexpr frustum_status classify(const bbox<T,3>& b) const {
+            auto mask = all_planes;
+            return classify(b, mask);
+        }
+
+        /**
+         * Classifies the given bounding box like classify(const bbox<T,3>&), but only tests the planes whose bits
+         * are set in the given mask. On return, the mask contains the planes that the box intersects, so the children
+         * of the box in a bounding volume hierarchy only need to be tested against these planes. If the box is
+         * outside, the mask is left unchanged.
+         *
+         * @param b the bounding box
+         * @param mask the planes to test, and on return, the planes that the box intersects
+         * @return the classification
+         */
+        constexpr frustum_status classify(const bbox<T,3>& b, std::uint8_t& mask) const {
+            std::uint8_t intersected = 0u;
+            for (std::size_t i = 0u; i < plane_count; ++i) {
+                if ((mask & (1u << i)) != 0u) {
+                    const auto& p = planes[i];
+                    vec<T,3> positive, negative;
+                    for (std::size_t j = 0u; j < 3u; ++j) {
+                        positive[j] = p.normal[j] >= T(0.0) ? b.max[j] : b.min[j];
+                        negative[j] = p.normal[j] >= T(0.0) ? b.min[j] : b.max[j];
+                    }
+
+                    if (p.point_distance(positive) < T(0.0)) {
+                        return frustum_status::outside;
+                    } else if (p.point_distance(negative) < T(0.0)) {
+                        intersected = static_cast<std::uint8_t>(intersected | (1u << i));
+                    }
+                }
+            }
+
+            mask = intersected;
+            return intersected == 0u ? frustum_status::inside : frustum_status::intersecting;
+        }
+
+        /**
+         * Classifies the sphere with the given center and radius with respect to this frustum. As for boxes, a
+         * sphere is only classified as outside if it is entirely behind one of the planes.
+         *
+         * @param center the center of the sphere
+         * @param radius the radius of the sphere
+         * @return the classification
+         */
+        constexpr frustum_status classify(const vec<T,3>& center, const T radius) const {
+            auto result = frustum_status::inside;
+            for (const auto& p : planes) {
+                const auto distance = p.point_distance(center);
+                if (distance < -radius) {
+                    return frustum_status::outside;
+                } else if (distance < radius) {
+                    result = frustum_status::intersecting;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Classifies each of the given bounding boxes like classify(const bbox<T,3>&, std::uint8_t&), using SIMD
+         * instructions to test several boxes at once. The results are identical to those of classifying each box
+         * individually.
+         *
+         * If plane masks are given, each box is only tested against the planes whose bits are set in its mask, and
+         * on return, the masks of the boxes that are not outside contain the planes that they intersect. A plane is
+         * skipped entirely for a group of boxes if none of them needs to be tested against it. Otherwise, all planes
+         * are tested.
+         *
+         * @param boxes the bounding boxes
+         * @param count the number of bounding boxes
+         * @param results the classification of each box
+         * @param masks the plane masks of the boxes, or nullptr to test all planes
+         */
+        void classify(const bbox<T,3>* boxes, const std::size_t count, frustum_status* results, std::uint8_t* masks = nullptr) const {
+            using pack = detail::pack<T>;
+            constexpr auto width = pack::width;
+            constexpr auto allLanes = (1u << width) - 1u;
+            static_assert(sizeof(bbox<T,3>) == 6u * sizeof(T), "bounding boxes must be tightly packed");
+
+            std::size_t i = 0u;
+            for (; i + width <= count; i += width) {
+                const auto* values = reinterpret_cast<const T*>(boxes + i);
+                pack min[3], max[3];
+                for (std::size_t j = 0u; j < 3u; ++j) {
+                    min[j] = pack::load_strided(values + j, 6u);
+                    max[j] = pack::load_strided(values + 3u + j, 6u);
+                }
+
+                unsigned outside = 0u;
+                unsigned intersected[plane_count] = {};
+                for (std::size_t k = 0u; k < plane_count && outside != allLanes; ++k) {
+                    auto lanes = allLanes;
+                    if (masks != nullptr) {
+                        lanes = 0u;
+                        for (std::size_t l = 0u; l < width; ++l) {
+                            lanes |= ((masks[i + l] >> k) & 1u) << l;
+                        }
+                        if (lanes == 0u) {
+                            continue;
+                        }
+                    }
+
+                    // the same operations as in plane::point_distance, so that the results are identical
+                    const auto& p = planes[k];
+                    const auto zero = pack::broadcast(T(0.0));
+                    auto positive = zero;
+                    auto negative = zero;
+                    for (std::size_t j = 0u; j < 3u; ++j) {
+                        const auto n = pack::broadcast(p.normal[j]);
+                        positive = positive + (p.normal[j] >= T(0.0) ? max[j] : min[j]) * n;
+                        negative = negative + (p.normal[j] >= T(0.0) ? min[j] : max[j]) * n;
+                    }
+                    const auto distance = pack::broadcast(p.distance);
+                    positive = positive - distance;
+                    negative = negative - distance;
+
+                    const auto behind = (positive < zero).bits() & lanes;
+                    outside |= behind;
+                    intersected[k] = (negative < zero).bits() & lanes & ~behind;
+                }
+
+                for (std::size_t l = 0u; l < width; ++l) {
+                    if ((outside & (1u << l)) != 0u) {
+                        results[i + l] = frustum_status::outside;
+                        continue;
+                    }
+
+                    std::uint8_t mask = 0u;
+                    for (std::size_t k = 0u; k < plane_count; ++k) {
+                        mask = static_cast<std::uint8_t>(mask | (((intersected[k] >> l) & 1u) << k));
+                    }
+                    results[i + l] = mask == 0u ? frustum_status::inside : frustum_status::intersecting;
+                    if (masks != nullptr) {
+                        masks[i + l] = mask;
+                    }
+                }
+            }
+
+            for (; i < count; ++i) {
+                if (masks != nullptr) {
+                    results[i] = classify(boxes[i], masks[i]);
+                } else {
+                    results[i] = classify(boxes[i]);
+                }
+            }
+        }
+    };
+}
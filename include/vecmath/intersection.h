@@ -22,10 +22,17 @@
 #include "ray.h"
 #include "bbox.h"
 #include "line.h"
+#include "obb.h"
 #include "plane.h"
 #include "scalar.h"
+#include "simd.h"
 #include "util.h"
 
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+
 namespace vm {
 
     namespace detail {
@@ -396,6 +403,314 @@ namespace vm {
         return distances[bestPlane];
     }
 
+    /**
+     * Computes the point of intersection between the given ray and the given oriented bounding box, and returns the
+     * distance on the given ray from the ray's origin to that point. The ray is transformed into the local coordinate
+     * system of the box, where the box is axis aligned and centered at the origin, and intersected with the
+     * corresponding bounding box. Since the orientation of the box is orthonormal, the distance in the local
+     * coordinate system equals the distance in world space.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param r the ray
+     * @param b the oriented bounding box
+     * @return the distance to the closest intersection point, or NaN if the ray does not intersect the box
+     */
+    template <typename T, size_t S>
+    constexpr T intersect_ray_obb(const ray<T,S>& r, const obb<T,S>& b) {
+        vec<T,S> localDirection;
+        for (size_t i = 0; i < S; ++i) {
+            localDirection[i] = dot(r.direction, b.orientation[i]);
+        }
+        const auto localRay = ray<T,S>(b.to_local(r.origin), localDirection);
+        return intersect_ray_bbox(localRay, bbox<T,S>(-b.half_extents, b.half_extents));
+    }
+
+    /**
+     * A ray prepared for repeated slab tests against bounding boxes. The reciprocal of the direction and the signs
+     * of its components are computed once, so that each test needs neither divisions nor branches.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     */
+    template <typename T, size_t S>
+    class ray_precomputed {
+    public:
+        vec<T,S> origin;
+        vec<T,S> inverse_direction;
+        /** For each component, whether the ray travels towards negative infinity along that axis. */
+        bool sign[S];
+
+        /**
+         * Prepares the given ray. Components of the direction that are zero produce an infinite inverse direction,
+         * which the slab test handles. Since dividing by zero is not a constant expression, such rays can only be
+         * prepared at runtime.
+         *
+         * @param r the ray
+         */
+        constexpr explicit ray_precomputed(const ray<T,S>& r) :
+        origin(r.origin),
+        inverse_direction(),
+        sign{} {
+            for (size_t i = 0; i < S; ++i) {
+                inverse_direction[i] = static_cast<T>(1.0) / r.direction[i];
+                sign[i] = inverse_direction[i] < static_cast<T>(0.0);
+            }
+        }
+    };
+
+    /**
+     * Intersects the given prepared ray with the given bounding box using the slab method and returns the interval of
+     * distances for which the ray is inside of the box, clipped to the given interval. The ray hits the box if and
+     * only if the returned near distance is not greater than the returned far distance.
+     *
+     * If the origin of the ray lies on a boundary of the box and the ray is parallel to that boundary, the
+     * corresponding slab is ignored, so that rays which graze a face of the box count as hits.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param r the prepared ray
+     * @param b the bounding box
+     * @param tmin the smallest distance to consider
+     * @param tmax the largest distance to consider
+     * @return a tuple containing the near and the far distance
+     */
+    template <typename T, size_t S>
+    constexpr std::tuple<T,T> intersect_ray_bbox_interval(const ray_precomputed<T,S>& r, const bbox<T,S>& b, const T tmin = static_cast<T>(0.0), const T tmax = std::numeric_limits<T>::infinity()) {
+        auto near = tmin;
+        auto far = tmax;
+        for (size_t i = 0; i < S; ++i) {
+            const auto t0 = ((r.sign[i] ? b.max[i] : b.min[i]) - r.origin[i]) * r.inverse_direction[i];
+            const auto t1 = ((r.sign[i] ? b.min[i] : b.max[i]) - r.origin[i]) * r.inverse_direction[i];
+
+            // comparisons with NaN are false, so NaN distances leave the interval unchanged
+            near = t0 > near ? t0 : near;
+            far = t1 < far ? t1 : far;
+        }
+        return std::make_tuple(near, far);
+    }
+
+    /**
+     * N bounding boxes stored as a structure of arrays, so that a ray can be tested against all of them at once.
+     * Lanes without a box hold an empty box which no ray hits.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam N the number of boxes
+     */
+    template <typename T, size_t S, size_t N>
+    class bbox_packet {
+    public:
+        static constexpr size_t width = N;
+
+        T min[S][N];
+        T max[S][N];
+
+        /**
+         * Creates a packet in which all lanes are empty.
+         */
+        constexpr bbox_packet() :
+        min{},
+        max{} {
+            for (size_t i = 0; i < S; ++i) {
+                for (size_t j = 0; j < N; ++j) {
+                    min[i][j] = std::numeric_limits<T>::infinity();
+                    max[i][j] = -std::numeric_limits<T>::infinity();
+                }
+            }
+        }
+
+        /**
+         * Creates a packet containing the given boxes. The remaining lanes are empty.
+         *
+         * @param boxes the boxes
+         * @param count the number of boxes, at most N
+         */
+        constexpr bbox_packet(const bbox<T,S>* boxes, const size_t count) :
+        bbox_packet() {
+            assert(count <= N);
+            for (size_t j = 0; j < count; ++j) {
+                set(j, boxes[j]);
+            }
+        }
+
+        /**
+         * Stores the given box in the given lane.
+         */
+        constexpr void set(const size_t lane, const bbox<T,S>& b) {
+            assert(lane < N);
+            for (size_t i = 0; i < S; ++i) {
+                min[i][lane] = b.min[i];
+                max[i][lane] = b.max[i];
+            }
+        }
+
+        /**
+         * Returns the box stored in the given lane.
+         */
+        constexpr bbox<T,S> get(const size_t lane) const {
+            assert(lane < N);
+            bbox<T,S> result;
+            for (size_t i = 0; i < S; ++i) {
+                result.min[i] = min[i][lane];
+                result.max[i] = max[i][lane];
+            }
+            return result;
+        }
+    };
+
+    /**
+     * N prepared rays stored as a structure of arrays, so that they can be tested against a bounding box at once.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam N the number of rays
+     */
+    template <typename T, size_t S, size_t N>
+    class ray_packet {
+    public:
+        static constexpr size_t width = N;
+
+        T origin[S][N];
+        T inverse_direction[S][N];
+
+        /**
+         * Prepares the given N rays.
+         *
+         * @param rays the rays, must point to N rays
+         */
+        constexpr explicit ray_packet(const ray<T,S>* rays) :
+        origin{},
+        inverse_direction{} {
+            for (size_t j = 0; j < N; ++j) {
+                set(j, rays[j]);
+            }
+        }
+
+        /**
+         * Prepares the given ray and stores it in the given lane.
+         */
+        constexpr void set(const size_t lane, const ray<T,S>& r) {
+            assert(lane < N);
+            for (size_t i = 0; i < S; ++i) {
+                origin[i][lane] = r.origin[i];
+                inverse_direction[i][lane] = static_cast<T>(1.0) / r.direction[i];
+            }
+        }
+
+        /**
+         * Returns the prepared ray stored in the given lane.
+         */
+        constexpr ray_precomputed<T,S> get(const size_t lane) const {
+            assert(lane < N);
+            auto result = ray_precomputed<T,S>(ray<T,S>());
+            for (size_t i = 0; i < S; ++i) {
+                result.origin[i] = origin[i][lane];
+                result.inverse_direction[i] = inverse_direction[i][lane];
+                result.sign[i] = inverse_direction[i][lane] < static_cast<T>(0.0);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Intersects the given prepared ray with each box of the given packet. For each lane, the distance at which the
+     * ray enters the box is written to the given array, and the corresponding bit of the returned mask is set if the
+     * ray hits the box. The results are identical to those of intersect_ray_bbox_interval.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam N the number of boxes
+     * @param r the prepared ray
+     * @param boxes the boxes
+     * @param tmin the smallest distance to consider
+     * @param tmax the largest distance to consider
+     * @param near receives the entry distance for each lane, which is only meaningful for lanes that were hit
+     * @return a mask whose bit j is set if the ray hits the box in lane j
+     */
+    template <typename T, size_t S, size_t N>
+    unsigned intersect_ray_bbox_packet(const ray_precomputed<T,S>& r, const bbox_packet<T,S,N>& boxes, const T tmin, const T tmax, T (&near)[N]) {
+        static_assert(N <= sizeof(unsigned) * 8u, "too many lanes for the result mask");
+        using pack = detail::pack<T>;
+
+        unsigned result = 0u;
+        size_t j = 0;
+        for (; j + pack::width <= N; j += pack::width) {
+            auto n = pack::broadcast(tmin);
+            auto f = pack::broadcast(tmax);
+            for (size_t i = 0; i < S; ++i) {
+                // the signs are the same for all lanes, so the slab boundaries can be chosen up front
+                const auto* lo = r.sign[i] ? boxes.max[i] : boxes.min[i];
+                const auto* hi = r.sign[i] ? boxes.min[i] : boxes.max[i];
+                const auto o = pack::broadcast(r.origin[i]);
+                const auto d = pack::broadcast(r.inverse_direction[i]);
+                const auto t0 = (pack::load(lo + j) - o) * d;
+                const auto t1 = (pack::load(hi + j) - o) * d;
+                n = select(t0 > n, t0, n);
+                f = select(t1 < f, t1, f);
+            }
+            n.store(near + j);
+            result |= (n <= f).bits() << j;
+        }
+
+        for (; j < N; ++j) {
+            const auto [n, f] = intersect_ray_bbox_interval(r, boxes.get(j), tmin, tmax);
+            near[j] = n;
+            result |= static_cast<unsigned>(n <= f) << j;
+        }
+        return result;
+    }
+
+    /**
+     * Intersects each ray of the given packet with the given box. For each lane, the distance at which the ray enters
+     * the box is written to the given array, and the corresponding bit of the returned mask is set if the ray hits the
+     * box. The results are identical to those of intersect_ray_bbox_interval.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam N the number of rays
+     * @param rays the rays
+     * @param b the box
+     * @param tmin the smallest distance to consider
+     * @param tmax the largest distance to consider
+     * @param near receives the entry distance for each lane, which is only meaningful for lanes that hit the box
+     * @return a mask whose bit j is set if the ray in lane j hits the box
+     */
+    template <typename T, size_t S, size_t N>
+    unsigned intersect_ray_bbox_packet(const ray_packet<T,S,N>& rays, const bbox<T,S>& b, const T tmin, const T tmax, T (&near)[N]) {
+        static_assert(N <= sizeof(unsigned) * 8u, "too many lanes for the result mask");
+        using pack = detail::pack<T>;
+
+        const auto zero = pack::broadcast(static_cast<T>(0.0));
+
+        unsigned result = 0u;
+        size_t j = 0;
+        for (; j + pack::width <= N; j += pack::width) {
+            auto n = pack::broadcast(tmin);
+            auto f = pack::broadcast(tmax);
+            for (size_t i = 0; i < S; ++i) {
+                const auto o = pack::load(rays.origin[i] + j);
+                const auto d = pack::load(rays.inverse_direction[i] + j);
+                const auto negative = d < zero;
+                const auto bmin = pack::broadcast(b.min[i]);
+                const auto bmax = pack::broadcast(b.max[i]);
+                const auto t0 = (select(negative, bmax, bmin) - o) * d;
+                const auto t1 = (select(negative, bmin, bmax) - o) * d;
+                n = select(t0 > n, t0, n);
+                f = select(t1 < f, t1, f);
+            }
+            n.store(near + j);
+            result |= (n <= f).bits() << j;
+        }
+
+        for (; j < N; ++j) {
+            const auto [n, f] = intersect_ray_bbox_interval(rays.get(j), b, tmin, tmax);
+            near[j] = n;
+            result |= static_cast<unsigned>(n <= f) << j;
+        }
+        return result;
+    }
+
     /**
      * Computes the point of intersection between the given ray and a sphere centered at the given position and with the
      * given radius.
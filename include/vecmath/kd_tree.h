@@ -0,0 +1,379 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "distance.h"
+#include "intersection.h"
+#include "ray.h"
+#include "scalar.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A static kd-tree over a set of points, used to find the points closest to a point or a ray, or within a radius
+     * of a point. The points are only known by their index in the range the tree was built from.
+     *
+     * The tree is built top down by splitting the points at the median of the axis along which they have the largest
+     * extent, which is found using std::nth_element, so the tree is balanced and built in O(n log n) time. The tree is
+     * implicit: the points are stored in a single array in which the points of each node occupy a contiguous range,
+     * with the median in the middle, the points of the first child before and the points of the second child after
+     * it. Only the split axis of every inner node is stored in addition to the points. Ranges of at most leaf_size
+     * points are not split any further.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     */
+    template <typename T, std::size_t S>
+    class kd_tree {
+    public:
+        /**
+         * The maximum number of points in a leaf.
+         */
+        static constexpr std::size_t leaf_size = 8u;
+    private:
+        struct entry {
+            vec<T,S> point;
+            std::size_t index;
+        };
+
+        std::vector<entry> m_entries;
+        /** The split axis of the inner node whose median is at the same position in m_entries. */
+        std::vector<std::uint8_t> m_axes;
+        bbox<T,S> m_bounds;
+    public:
+        /**
+         * Creates an empty tree.
+         */
+        kd_tree() = default;
+
+        /**
+         * Creates a tree over the points obtained from the given range. The points are identified by their position
+         * in the range.
+         *
+         * @tparam I the range iterator type
+         * @tparam G the type of the function that returns the point of a range element
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param get the function that returns the point of a range element
+         */
+        template <typename I, typename G = identity>
+        kd_tree(I cur, I end, const G& get = G()) {
+            while (cur != end) {
+                m_entries.push_back(entry{ get(*cur), m_entries.size() });
+                ++cur;
+            }
+
+            if (!m_entries.empty()) {
+                m_axes.resize(m_entries.size());
+                m_bounds = build(0u, m_entries.size());
+            }
+        }
+
+        /**
+         * Indicates whether this tree contains any points.
+         */
+        bool empty() const {
+            return m_entries.empty();
+        }
+
+        /**
+         * Returns the number of points.
+         */
+        std::size_t size() const {
+            return m_entries.size();
+        }
+
+        /**
+         * Returns the bounding box of all points. The tree must not be empty.
+         */
+        const bbox<T,S>& bounds() const {
+            assert(!empty());
+            return m_bounds;
+        }
+
+        /**
+         * Finds the point closest to the given point. Of several points at the same distance, the one with the
+         * smallest index is found.
+         *
+         * @param p the point
+         * @param maxDistance the maximum distance to consider
+         * @return a pair of the distance to the closest point and its index, or NaN and the number of points if there
+         * is no point within the given distance
+         */
+        std::tuple<T, std::size_t> find_nearest(const vec<T,S>& p, const T maxDistance = std::numeric_limits<T>::infinity()) const {
+            auto bestDistance2 = maxDistance * maxDistance;
+            auto bestIndex = size();
+            if (!empty()) {
+                visit_nearest(0u, m_entries.size(), p, [&]() { return bestDistance2; }, [&](const std::size_t position, const T distance2) {
+                    const auto index = m_entries[position].index;
+                    if (distance2 < bestDistance2 || (distance2 == bestDistance2 && index < bestIndex)) {
+                        bestDistance2 = distance2;
+                        bestIndex = index;
+                    }
+                });
+            }
+
+            if (bestIndex == size()) {
+                return std::make_tuple(nan<T>(), bestIndex);
+            } else {
+                return std::make_tuple(sqrt(bestDistance2), bestIndex);
+            }
+        }
+
+        /**
+         * Finds the k points closest to the given point. Points at equal distances are ordered by their index.
+         *
+         * @param p the point
+         * @param k the maximum number of points to find
+         * @param maxDistance the maximum distance to consider
+         * @return the indices of the closest points within the given distance, ordered by increasing distance
+         */
+        std::vector<std::size_t> find_k_nearest(const vec<T,S>& p, const std::size_t k, const T maxDistance = std::numeric_limits<T>::infinity()) const {
+            std::vector<std::size_t> result;
+            if (k == 0u || empty()) {
+                return result;
+            }
+
+            // a max heap of the best candidates, ordered by squared distance and position
+            std::priority_queue<std::tuple<T, std::size_t, std::size_t>> candidates;
+            const auto maxDistance2 = maxDistance * maxDistance;
+            const auto worst = [&]() {
+                return candidates.size() < k ? maxDistance2 : std::get<0>(candidates.top());
+            };
+
+            visit_nearest(0u, m_entries.size(), p, worst, [&](const std::size_t position, const T distance2) {
+                const auto candidate = std::make_tuple(distance2, m_entries[position].index, position);
+                if (distance2 <= maxDistance2 && (candidates.size() < k || candidate < candidates.top())) {
+                    candidates.push(candidate);
+                    if (candidates.size() > k) {
+                        candidates.pop();
+                    }
+                }
+            });
+
+            result.resize(candidates.size());
+            for (auto i = result.size(); i-- > 0u;) {
+                result[i] = std::get<1>(candidates.top());
+                candidates.pop();
+            }
+            return result;
+        }
+
+        /**
+         * Calls the given function with the index of each point within the given distance of the given point. The
+         * function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param center the point
+         * @param radius the distance
+         * @param visit the function
+         */
+        template <typename F>
+        void query_radius(const vec<T,S>& center, const T radius, F&& visit) const {
+            if (!empty()) {
+                visit_radius(0u, m_entries.size(), center, radius * radius, visit);
+            }
+        }
+
+        /**
+         * Finds the point closest to the given ray, as measured by distance(const ray<T,S>&, const vec<T,S>&). Points
+         * behind the origin of the ray are measured from the origin.
+         *
+         * @param r the ray
+         * @param maxDistance the maximum distance to consider
+         * @return a pair of the distance between the ray and the closest point and the index of the point, or NaN
+         * and the number of points if there is no point within the given distance
+         */
+        std::tuple<point_distance<T>, std::size_t> find_closest_to_ray(const ray<T,S>& r, const T maxDistance = std::numeric_limits<T>::infinity()) const {
+            auto bestDistance2 = maxDistance * maxDistance;
+            auto bestPosition = m_entries.size();
+            if (!empty()) {
+                const auto precomputed = ray_precomputed<T,S>(r);
+                visit_ray(0u, m_entries.size(), m_bounds, r, precomputed, bestDistance2, bestPosition);
+            }
+
+            if (bestPosition == m_entries.size()) {
+                return std::make_tuple(point_distance<T>(nan<T>(), nan<T>()), m_entries.size());
+            } else {
+                const auto& best = m_entries[bestPosition];
+                return std::make_tuple(vm::distance(r, best.point), best.index);
+            }
+        }
+    private:
+        /**
+         * Builds the subtree for the points in [begin, end) of m_entries and returns their bounds.
+         */
+        bbox<T,S> build(const std::size_t begin, const std::size_t end) {
+            typename bbox<T,S>::builder builder;
+            for (auto i = begin; i < end; ++i) {
+                builder.add(m_entries[i].point);
+            }
+            const auto bounds = builder.bounds();
+            if (end - begin <= leaf_size) {
+                return bounds;
+            }
+
+            const auto size = bounds.size();
+            std::size_t axis = 0u;
+            for (std::size_t i = 1u; i < S; ++i) {
+                if (size[i] > size[axis]) {
+                    axis = i;
+                }
+            }
+
+            const auto mid = begin + (end - begin) / 2u;
+            const auto first = m_entries.begin() + static_cast<std::ptrdiff_t>(begin);
+            std::nth_element(first, m_entries.begin() + static_cast<std::ptrdiff_t>(mid), m_entries.begin() + static_cast<std::ptrdiff_t>(end), [axis](const entry& lhs, const entry& rhs) {
+                return lhs.point[axis] < rhs.point[axis];
+            });
+            m_axes[mid] = static_cast<std::uint8_t>(axis);
+
+            build(begin, mid);
+            build(mid + 1u, end);
+            return bounds;
+        }
+
+        /**
+         * Calls visit(position, squared distance) for the points in [begin, end) of m_entries that may be closer to
+         * the given point than the value returned by worst, visiting the side of each split that contains the point
+         * first.
+         */
+        template <typename W, typename F>
+        void visit_nearest(const std::size_t begin, const std::size_t end, const vec<T,S>& p, const W& worst, const F& visit) const {
+            if (end - begin <= leaf_size) {
+                for (auto i = begin; i < end; ++i) {
+                    visit(i, squared_distance(p, m_entries[i].point));
+                }
+                return;
+            }
+
+            const auto mid = begin + (end - begin) / 2u;
+            const auto axis = m_axes[mid];
+            const auto d = p[axis] - m_entries[mid].point[axis];
+            if (d < T(0.0)) {
+                visit_nearest(begin, mid, p, worst, visit);
+                if (d * d <= worst()) {
+                    visit(mid, squared_distance(p, m_entries[mid].point));
+                    visit_nearest(mid + 1u, end, p, worst, visit);
+                }
+            } else {
+                visit_nearest(mid + 1u, end, p, worst, visit);
+                if (d * d <= worst()) {
+                    visit(mid, squared_distance(p, m_entries[mid].point));
+                    visit_nearest(begin, mid, p, worst, visit);
+                }
+            }
+        }
+
+        /**
+         * Visits the points in [begin, end) of m_entries within the given squared distance of the given point.
+         * Returns false if the query was stopped.
+         */
+        template <typename F>
+        bool visit_radius(const std::size_t begin, const std::size_t end, const vec<T,S>& center, const T radius2, F& visit) const {
+            if (end - begin <= leaf_size) {
+                for (auto i = begin; i < end; ++i) {
+                    if (squared_distance(center, m_entries[i].point) <= radius2 && !visit(m_entries[i].index)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const auto mid = begin + (end - begin) / 2u;
+            const auto axis = m_axes[mid];
+            const auto d = center[axis] - m_entries[mid].point[axis];
+            if (d <= T(0.0) || d * d <= radius2) {
+                if (!visit_radius(begin, mid, center, radius2, visit)) {
+                    return false;
+                }
+            }
+            if (squared_distance(center, m_entries[mid].point) <= radius2 && !visit(m_entries[mid].index)) {
+                return false;
+            }
+            if (d >= T(0.0) || d * d <= radius2) {
+                if (!visit_radius(mid + 1u, end, center, radius2, visit)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Updates the given best squared distance and position with the points in [begin, end) of m_entries, which
+         * are contained in the given bounds.
+         */
+        void visit_ray(const std::size_t begin, const std::size_t end, const bbox<T,S>& bounds, const ray<T,S>& r, const ray_precomputed<T,S>& precomputed, T& bestDistance2, std::size_t& bestPosition) const {
+            // all points are farther from the ray than the best distance unless it hits the bounds expanded by it
+            if (bestDistance2 < std::numeric_limits<T>::infinity()) {
+                const auto [near, far] = intersect_ray_bbox_interval(precomputed, bounds.expand(sqrt(bestDistance2)));
+                if (!(near <= far)) {
+                    return;
+                }
+            }
+
+            const auto test = [&](const std::size_t i) {
+                const auto distance2 = squared_distance(r, m_entries[i].point).distance;
+                if (distance2 < bestDistance2 || (distance2 == bestDistance2 && (bestPosition == m_entries.size() || m_entries[i].index < m_entries[bestPosition].index))) {
+                    bestDistance2 = distance2;
+                    bestPosition = i;
+                }
+            };
+
+            if (end - begin <= leaf_size) {
+                for (auto i = begin; i < end; ++i) {
+                    test(i);
+                }
+                return;
+            }
+
+            const auto mid = begin + (end - begin) / 2u;
+            const auto axis = m_axes[mid];
+            const auto split = m_entries[mid].point[axis];
+            auto firstBounds = bounds;
+            auto secondBounds = bounds;
+            firstBounds.max[axis] = split;
+            secondBounds.min[axis] = split;
+
+            test(mid);
+
+            // visit the side that the ray passes first
+            const auto firstNear = std::get<0>(intersect_ray_bbox_interval(precomputed, firstBounds));
+            const auto secondNear = std::get<0>(intersect_ray_bbox_interval(precomputed, secondBounds));
+            if (secondNear < firstNear) {
+                visit_ray(mid + 1u, end, secondBounds, r, precomputed, bestDistance2, bestPosition);
+                visit_ray(begin, mid, firstBounds, r, precomputed, bestDistance2, bestPosition);
+            } else {
+                visit_ray(begin, mid, firstBounds, r, precomputed, bestDistance2, bestPosition);
+                visit_ray(mid + 1u, end, secondBounds, r, precomputed, bestDistance2, bestPosition);
+            }
+        }
+    };
+}
@@ -0,0 +1,432 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "scalar.h"
+#include "spatial_hash.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A loose octree over bounding boxes, used to find the items within a box or a radius. Unlike spatial_hash, each
+     * item is stored exactly once, so the octree also works well for items of very different sizes.
+     *
+     * The octree subdivides a cube that is given on construction. An item is stored in the node of the deepest level
+     * whose cells are at least as large as the largest extent of the item, in the cell that contains its center. The
+     * bounds of each node are its cell expanded by half the cell size on every side, so they contain all of its items.
+     * Items that do not fit into the loose bounds of the root are kept in a separate list that every query checks.
+     *
+     * Nodes are identified by locational codes, which start with a 1 bit followed by three bits for each level that
+     * select the child cell, and are stored in a flat hash table keyed by these codes. Only the nodes on the paths to
+     * the items exist, and the nodes and the items are taken from pools that keep released elements in free lists.
+     *
+     * Items are identified by ids, which remain valid until the item is removed, after which they may be reused.
+     *
+     * @tparam T the component type
+     * @tparam U the type of the user data stored with each item, must be default constructible
+     */
+    template <typename T, typename U>
+    class loose_octree {
+    public:
+        /**
+         * The id that is never assigned to an item.
+         */
+        static constexpr std::size_t invalid_id = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * The maximum depth of the octree, which is limited by the size of the locational codes.
+         */
+        static constexpr std::size_t max_depth = 20u;
+    private:
+        static constexpr std::uint32_t no_index = detail::flat_hash_table::no_value;
+        /** The locational code of the root node. */
+        static constexpr std::uint64_t root_key = 1u;
+        /** The key of the items that do not fit into the root node. */
+        static constexpr std::uint64_t outside_key = 0u;
+
+        struct item {
+            bbox<T,3> bounds;
+            U data;
+            std::uint64_t node = outside_key;
+            std::uint32_t previous = no_index;
+            std::uint32_t next = no_index;
+            bool valid = false;
+        };
+
+        struct node {
+            std::uint32_t first = no_index;
+            std::uint8_t children = 0u;
+        };
+
+        using cell = std::array<std::uint64_t, 3>;
+
+        vec<T,3> m_origin;
+        T m_size;
+        std::size_t m_depth;
+        std::vector<item> m_items;
+        std::vector<std::size_t> m_freeItems;
+        std::size_t m_itemCount;
+        std::vector<node> m_nodes;
+        std::vector<std::uint32_t> m_freeNodes;
+        /** Maps the locational code of each node to its index in m_nodes. */
+        detail::flat_hash_table m_table;
+        std::uint32_t m_outside;
+    public:
+        /**
+         * Creates an empty octree that subdivides the smallest cube with the same minimum as the given bounds that
+         * contains them.
+         *
+         * Small items and points are stored in the nodes at the given depth. Since a query visits every node whose
+         * loose bounds it intersects, the depth should be chosen so that these nodes each hold a few items. For
+         * points, spatial_hash is usually faster.
+         *
+         * @param bounds the bounds to subdivide, must not be empty
+         * @param depth the depth of the octree, at most max_depth
+         */
+        explicit loose_octree(const bbox<T,3>& bounds, const std::size_t depth = 8u) :
+        m_origin(bounds.min),
+        m_size(vm::max(bounds.size()[0], bounds.size()[1], bounds.size()[2])),
+        m_depth(depth),
+        m_itemCount(0u),
+        m_outside(no_index) {
+            assert(m_size > T(0.0));
+            assert(depth <= max_depth);
+        }
+
+        /**
+         * Returns the cube subdivided by the octree.
+         */
+        bbox<T,3> bounds() const {
+            return bbox<T,3>(m_origin, m_origin + vec<T,3>::fill(m_size));
+        }
+
+        /**
+         * Indicates whether this octree contains any items.
+         */
+        bool empty() const {
+            return m_itemCount == 0u;
+        }
+
+        /**
+         * Returns the number of items.
+         */
+        std::size_t size() const {
+            return m_itemCount;
+        }
+
+        /**
+         * Returns the number of nodes.
+         */
+        std::size_t node_count() const {
+            return m_table.size();
+        }
+
+        /**
+         * Removes all items. The pools are kept for reuse.
+         */
+        void clear() {
+            m_items.clear();
+            m_freeItems.clear();
+            m_itemCount = 0u;
+            m_nodes.clear();
+            m_freeNodes.clear();
+            m_table.clear();
+            m_outside = no_index;
+        }
+
+        /**
+         * Inserts an item with the given bounds and user data.
+         *
+         * @param bounds the bounds of the item
+         * @param data the user data
+         * @return the id of the item
+         */
+        std::size_t insert(const bbox<T,3>& bounds, U data = U()) {
+            std::size_t id;
+            if (m_freeItems.empty()) {
+                assert(m_items.size() < no_index);
+                id = m_items.size();
+                m_items.emplace_back();
+            } else {
+                id = m_freeItems.back();
+                m_freeItems.pop_back();
+            }
+
+            const auto key = node_key(bounds);
+            auto& first = key == outside_key ? m_outside : m_nodes[find_or_create_node(key)].first;
+
+            auto& i = m_items[id];
+            i.bounds = bounds;
+            i.data = std::move(data);
+            i.node = key;
+            i.previous = no_index;
+            i.next = first;
+            i.valid = true;
+            if (first != no_index) {
+                m_items[first].previous = static_cast<std::uint32_t>(id);
+            }
+            first = static_cast<std::uint32_t>(id);
+
+            ++m_itemCount;
+            return id;
+        }
+
+        /**
+         * Inserts a point with the given user data.
+         *
+         * @param point the point
+         * @param data the user data
+         * @return the id of the item
+         */
+        std::size_t insert(const vec<T,3>& point, U data = U()) {
+            return insert(bbox<T,3>(point, point), std::move(data));
+        }
+
+        /**
+         * Removes the item with the given id. The id becomes invalid and may be reused by later insertions. Nodes
+         * that no longer lead to any item are removed.
+         *
+         * @param id the id of the item
+         */
+        void remove(const std::size_t id) {
+            assert(is_valid(id));
+
+            auto& i = m_items[id];
+            if (i.previous != no_index) {
+                m_items[i.previous].next = i.next;
+            } else if (i.node == outside_key) {
+                m_outside = i.next;
+            } else {
+                m_nodes[m_table.find(i.node)].first = i.next;
+            }
+            if (i.next != no_index) {
+                m_items[i.next].previous = i.previous;
+            }
+
+            remove_empty_nodes(i.node);
+
+            i.valid = false;
+            i.data = U();
+            m_freeItems.push_back(id);
+            --m_itemCount;
+        }
+
+        /**
+         * Returns the bounds of the item with the given id.
+         */
+        const bbox<T,3>& bounds(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_items[id].bounds;
+        }
+
+        /**
+         * Returns the user data of the item with the given id.
+         */
+        const U& data(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_items[id].data;
+        }
+
+        /**
+         * Returns the user data of the item with the given id.
+         */
+        U& data(const std::size_t id) {
+            assert(is_valid(id));
+            return m_items[id].data;
+        }
+
+        /**
+         * Indicates whether the given id refers to an item in this octree.
+         */
+        bool is_valid(const std::size_t id) const {
+            return id < m_items.size() && m_items[id].valid;
+        }
+
+        /**
+         * Calls the given function once with the id of each item whose bounds intersect the given bounding box. The
+         * function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param b the bounding box
+         * @param visit the function
+         */
+        template <typename F>
+        void query(const bbox<T,3>& b, F&& visit) const {
+            const auto test = [&](const bbox<T,3>& bounds) {
+                return bounds.intersects(b);
+            };
+            query_nodes(test, visit);
+        }
+
+        /**
+         * Calls the given function once with the id of each item whose bounds are within the given distance of the
+         * given point. The function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param center the point
+         * @param radius the distance
+         * @param visit the function
+         */
+        template <typename F>
+        void query_radius(const vec<T,3>& center, const T radius, F&& visit) const {
+            const auto test = [&](const bbox<T,3>& bounds) {
+                return detail::squared_distance_to_bbox(center, bounds) <= radius * radius;
+            };
+            query_nodes(test, visit);
+        }
+    private:
+        /**
+         * Returns the locational code of the node that stores an item with the given bounds, or outside_key if the
+         * item does not fit into the root node.
+         */
+        std::uint64_t node_key(const bbox<T,3>& bounds) const {
+            const auto extent = vm::max(bounds.size()[0], bounds.size()[1], bounds.size()[2]);
+            if (!(extent <= m_size)) {
+                return outside_key;
+            }
+
+            std::size_t depth = 0u;
+            auto cellSize = m_size;
+            while (depth < m_depth && extent <= cellSize * T(0.5)) {
+                cellSize *= T(0.5);
+                ++depth;
+            }
+
+            const auto cellCount = std::uint64_t(1u) << depth;
+            const auto center = bounds.center();
+            cell c;
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                const auto t = (center[i] - m_origin[i]) / cellSize;
+                if (!(t >= T(0.0) && t <= static_cast<T>(cellCount))) {
+                    return outside_key;
+                }
+                // a center on the maximum of the cube belongs to the last cell
+                c[i] = std::min(static_cast<std::uint64_t>(t), cellCount - 1u);
+            }
+
+            auto key = root_key;
+            for (auto level = depth; level-- > 0u;) {
+                key = (key << 3u) | (((c[0] >> level) & 1u) << 2u) | (((c[1] >> level) & 1u) << 1u) | ((c[2] >> level) & 1u);
+            }
+            return key;
+        }
+
+        std::uint32_t find_or_create_node(const std::uint64_t key) {
+            auto index = m_table.find(key);
+            if (index != no_index) {
+                return index;
+            }
+
+            if (m_freeNodes.empty()) {
+                assert(m_nodes.size() < no_index);
+                index = static_cast<std::uint32_t>(m_nodes.size());
+                m_nodes.emplace_back();
+            } else {
+                index = m_freeNodes.back();
+                m_freeNodes.pop_back();
+                m_nodes[index] = node();
+            }
+            m_table.insert(key, index);
+
+            if (key != root_key) {
+                const auto parent = find_or_create_node(key >> 3u);
+                m_nodes[parent].children = static_cast<std::uint8_t>(m_nodes[parent].children | (1u << (key & 7u)));
+            }
+            return index;
+        }
+
+        /**
+         * Removes the node with the given locational code and its ancestors as long as they have neither items nor
+         * children.
+         */
+        void remove_empty_nodes(std::uint64_t key) {
+            while (key != outside_key) {
+                const auto index = m_table.find(key);
+                if (m_nodes[index].first != no_index || m_nodes[index].children != 0u) {
+                    return;
+                }
+
+                m_table.erase(key);
+                m_freeNodes.push_back(index);
+
+                const auto parent = key >> 3u;
+                if (parent != outside_key) {
+                    auto& p = m_nodes[m_table.find(parent)];
+                    p.children = static_cast<std::uint8_t>(p.children & ~(1u << (key & 7u)));
+                }
+                key = parent;
+            }
+        }
+
+        template <typename P, typename F>
+        void query_nodes(const P& test, F& visit) const {
+            for (auto i = m_outside; i != no_index; i = m_items[i].next) {
+                if (test(m_items[i].bounds) && !visit(static_cast<std::size_t>(i))) {
+                    return;
+                }
+            }
+
+            if (m_table.size() > 0u) {
+                query_node(root_key, cell{ 0u, 0u, 0u }, m_size, test, visit);
+            }
+        }
+
+        /**
+         * Visits the items of the node with the given locational code and cell and its descendants that pass the given
+         * test. Returns false if the query was stopped.
+         */
+        template <typename P, typename F>
+        bool query_node(const std::uint64_t key, const cell& c, const T cellSize, const P& test, F& visit) const {
+            // half a cell, plus a tolerance for rounding errors in the placement of the items
+            const auto margin = vec<T,3>::fill(cellSize * T(0.5625));
+            const auto min = m_origin + vec<T,3>(static_cast<T>(c[0]), static_cast<T>(c[1]), static_cast<T>(c[2])) * cellSize;
+            if (!test(bbox<T,3>(min - margin, min + vec<T,3>::fill(cellSize) + margin))) {
+                return true;
+            }
+
+            // the node is only looked up once its bounds pass the test
+            const auto& n = m_nodes[m_table.find(key)];
+            for (auto i = n.first; i != no_index; i = m_items[i].next) {
+                if (test(m_items[i].bounds) && !visit(static_cast<std::size_t>(i))) {
+                    return false;
+                }
+            }
+
+            for (std::uint64_t child = 0u; child < 8u; ++child) {
+                if ((n.children & (1u << child)) != 0u) {
+                    const auto childKey = (key << 3u) | child;
+                    const auto childCell = cell{ 2u * c[0] + ((child >> 2u) & 1u), 2u * c[1] + ((child >> 1u) & 1u), 2u * c[2] + (child & 1u) };
+                    if (!query_node(childKey, childCell, cellSize * T(0.5), test, visit)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+}
@@ -20,9 +20,11 @@
 
 #include "vec.h"
 #include "constants.h"
+#include "simd.h"
 
 #include <cassert>
 #include <tuple>
+#include <type_traits>
 
 namespace vm {
     template <typename T, std::size_t R, std::size_t C>
@@ -399,6 +401,26 @@ namespace vm {
         return true;
     }
 
+    /**
+     * Checks whether the given square matrix represents an affine transformation, that is, whether its last row is
+     * exactly (0, ..., 0, 1). Applying such a matrix to a point in homogeneous coordinates never changes the
+     * homogeneous component, so the division by the homogeneous component can be omitted.
+     *
+     * @tparam T the element type
+     * @tparam S the number of rows and columns
+     * @param m the matrix to check
+     * @return true if the last row of the given matrix is (0, ..., 0, 1) and false otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool is_affine(const mat<T,S,S>& m) {
+        for (size_t c = 0; c < S-1; ++c) {
+            if (m[c][S-1] != static_cast<T>(0.0)) {
+                return false;
+            }
+        }
+        return m[S-1][S-1] == static_cast<T>(1.0);
+    }
+
     /**
      * Checks whether the given matrices have identical components.
      *
@@ -431,6 +453,110 @@ namespace vm {
 
     /* ========== arithmetic operators ========== */
 
+#if defined(VM_SIMD_DISPATCH)
+    namespace detail {
+        /**
+         * Computes the product of the given 4x4 float matrices using SSE or AVX instructions.
+         *
+         * Every column of the result is the sum of the columns of the left hand matrix, scaled by the corresponding
+         * components of the right hand matrix's column. The terms are added in the same order as in the generic
+         * implementation, so the results are bit identical unless the compiler contracts the generic implementation
+         * into fused multiply-add instructions.
+         *
+         * @param lhs the first matrix
+         * @param rhs the second matrix
+         * @return the product of the given matrices
+         */
+        inline mat<float,4,4> multiply_simd(const mat<float,4,4>& lhs, const mat<float,4,4>& rhs) {
+            mat<float,4,4> result;
+#if defined(VM_SIMD_AVX)
+            const auto load2 = [](const float* lo, const float* hi) {
+                return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+            };
+            const __m256 l0 = load2(lhs.v[0].v, lhs.v[0].v);
+            const __m256 l1 = load2(lhs.v[1].v, lhs.v[1].v);
+            const __m256 l2 = load2(lhs.v[2].v, lhs.v[2].v);
+            const __m256 l3 = load2(lhs.v[3].v, lhs.v[3].v);
+            for (std::size_t c = 0u; c < 4u; c += 2u) {
+                const __m256 r = load2(rhs.v[c].v, rhs.v[c + 1u].v);
+                __m256 acc = _mm256_setzero_ps();
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(l0, _mm256_permute_ps(r, _MM_SHUFFLE(0, 0, 0, 0))));
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(l1, _mm256_permute_ps(r, _MM_SHUFFLE(1, 1, 1, 1))));
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(l2, _mm256_permute_ps(r, _MM_SHUFFLE(2, 2, 2, 2))));
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(l3, _mm256_permute_ps(r, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm_storeu_ps(result.v[c].v, _mm256_castps256_ps128(acc));
+                _mm_storeu_ps(result.v[c + 1u].v, _mm256_extractf128_ps(acc, 1));
+            }
+#else
+            const __m128 l0 = _mm_loadu_ps(lhs.v[0].v);
+            const __m128 l1 = _mm_loadu_ps(lhs.v[1].v);
+            const __m128 l2 = _mm_loadu_ps(lhs.v[2].v);
+            const __m128 l3 = _mm_loadu_ps(lhs.v[3].v);
+            for (std::size_t c = 0u; c < 4u; ++c) {
+                const __m128 r = _mm_loadu_ps(rhs.v[c].v);
+                __m128 acc = _mm_setzero_ps();
+                acc = _mm_add_ps(acc, _mm_mul_ps(l0, _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0))));
+                acc = _mm_add_ps(acc, _mm_mul_ps(l1, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1))));
+                acc = _mm_add_ps(acc, _mm_mul_ps(l2, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2))));
+                acc = _mm_add_ps(acc, _mm_mul_ps(l3, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm_storeu_ps(result.v[c].v, acc);
+            }
+#endif
+            return result;
+        }
+
+        /**
+         * Computes the product of the given 4x4 float matrix and the given column vector using SSE instructions. The
+         * terms are added in the same order as in the generic implementation.
+         *
+         * @param lhs the matrix
+         * @param x the first component of the vector
+         * @param y the second component of the vector
+         * @param z the third component of the vector
+         * @param w the fourth component of the vector
+         * @return the product as an SSE register
+         */
+        inline __m128 multiply_simd(const mat<float,4,4>& lhs, const __m128 x, const __m128 y, const __m128 z, const __m128 w) {
+            __m128 acc = _mm_setzero_ps();
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(lhs.v[0].v), x));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(lhs.v[1].v), y));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(lhs.v[2].v), z));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(lhs.v[3].v), w));
+            return acc;
+        }
+
+        /**
+         * Computes the product of the given 4x4 float matrix and the given 4D vector using SSE instructions.
+         *
+         * @param lhs the matrix
+         * @param rhs the vector
+         * @return the product of the given matrix and vector
+         */
+        inline vec<float,4> multiply_simd(const mat<float,4,4>& lhs, const vec<float,4>& rhs) {
+            vec<float,4> result;
+            _mm_storeu_ps(result.v, multiply_simd(lhs,
+                _mm_set1_ps(rhs.v[0]), _mm_set1_ps(rhs.v[1]), _mm_set1_ps(rhs.v[2]), _mm_set1_ps(rhs.v[3])));
+            return result;
+        }
+
+        /**
+         * Computes the product of the given 4x4 float matrix and the given 3D point in homogeneous coordinates using
+         * SSE instructions. The result is converted back to cartesian coordinates by dividing by its last component.
+         *
+         * @param lhs the matrix
+         * @param rhs the point
+         * @return the product of the given matrix and point
+         */
+        inline vec<float,3> multiply_simd(const mat<float,4,4>& lhs, const vec<float,3>& rhs) {
+            const __m128 h = multiply_simd(lhs,
+                _mm_set1_ps(rhs.v[0]), _mm_set1_ps(rhs.v[1]), _mm_set1_ps(rhs.v[2]), _mm_set1_ps(1.0f));
+            float c[4];
+            _mm_storeu_ps(c, _mm_div_ps(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(3, 3, 3, 3))));
+            return vec<float,3>(c[0], c[1], c[2]);
+        }
+    }
+#endif
+
     /**
      * Returns a copy of the given matrix.
      *
@@ -498,6 +624,12 @@ namespace vm {
     /**
      * Computes the product of the given two matrices.
      *
+     * If SSE or AVX instructions are available, the product of two 4x4 float matrices is computed using these
+     * instructions when evaluated at runtime. Both implementations add the same four products in the same order, so
+     * their results are bit identical unless the compiler contracts the generic implementation into fused multiply-add
+     * instructions, e.g. with -ffp-contract=fast. In that case, each element may differ by a few units in the last place
+     * of the sum of the magnitudes of its products.
+     *
      * @tparam T the element type
      * @tparam R1 the number of rows of the first matrix
      * @tparam C1R2 the number of columns of the first matrix and the number of rows of the second matrix
@@ -508,6 +640,13 @@ namespace vm {
      */
     template <typename T, std::size_t R1, std::size_t C1R2, std::size_t C2>
     constexpr mat<T, R1, C2> operator*(const mat<T, R1, C1R2>& lhs, const mat<T, C1R2, C2>& rhs) {
+#if defined(VM_SIMD_DISPATCH)
+        if constexpr (std::is_same<T, float>::value && R1 == 4u && C1R2 == 4u && C2 == 4u) {
+            if (!detail::is_constant_evaluated()) {
+                return detail::multiply_simd(lhs, rhs);
+            }
+        }
+#endif
         auto result = mat<T, R1, C2>::zero();
         for (size_t c = 0; c < C2; c++) {
             for (size_t r = 0; r < R1; r++) {
@@ -594,6 +733,10 @@ namespace vm {
     /**
      * Multiplies the given vector by the given matrix.
      *
+     * If SSE instructions are available, the product of a 4x4 float matrix and a 4D vector is computed using these
+     * instructions when evaluated at runtime. The results may differ from those of the generic implementation by a few
+     * units in the last place if the compiler contracts the generic implementation into fused multiply-add instructions.
+     *
      * @tparam T the element type
      * @tparam R the number of rows
      * @tparam C the number of columns
@@ -603,6 +746,13 @@ namespace vm {
      */
     template <typename T, std::size_t R, std::size_t C>
     constexpr vec<T,R> operator*(const mat<T, R, C>& lhs, const vec<T,C>& rhs) {
+#if defined(VM_SIMD_DISPATCH)
+        if constexpr (std::is_same<T, float>::value && R == 4u && C == 4u) {
+            if (!detail::is_constant_evaluated()) {
+                return detail::multiply_simd(lhs, rhs);
+            }
+        }
+#endif
         vec<T,C> result;
         for (size_t r = 0; r < R; r++) {
             for (size_t c = 0; c < C; ++c) {
@@ -615,6 +765,10 @@ namespace vm {
     /**
      * Multiplies the given vector by the given matrix.
      *
+     * If SSE instructions are available, the product of a 4x4 float matrix and a 3D vector is computed using these
+     * instructions when evaluated at runtime. The results may differ from those of the generic implementation by a few
+     * units in the last place if the compiler contracts the generic implementation into fused multiply-add instructions.
+     *
      * @tparam T the element type
      * @tparam R the number of rows
      * @tparam C the number of columns
@@ -624,6 +778,13 @@ namespace vm {
      */
     template <typename T, std::size_t R, std::size_t C>
     constexpr vec<T, C-1> operator*(const mat<T, R, C>& lhs, const vec<T, C-1>& rhs) {
+#if defined(VM_SIMD_DISPATCH)
+        if constexpr (std::is_same<T, float>::value && R == 4u && C == 4u) {
+            if (!detail::is_constant_evaluated()) {
+                return detail::multiply_simd(lhs, rhs);
+            }
+        }
+#endif
         return to_cartesian_coords(lhs * to_homogeneous_coords(rhs));
     }
 
@@ -716,29 +877,361 @@ namespace vm {
     }
 
     namespace detail {
+        /**
+         * Finds an LUP decomposition of matrix a.
+         *
+         * Given A, finds P,L,U satisfying PA=LU where P is a permutation matrix,
+         * where L is lower-triangular with the diagonal elements set to 1,
+         * U is upper-triangular.
+         *
+         * The permutation matrix is returned in a compressed form where each element of the vector represents a row of
+         * the permutation matrix, and a value of `i` means the `i`th column of that row is set to 1.
+         *
+         * From "LUP-Decomposition", Introduction to Algorithms by Cormen et. al., 2nd. ed. p752.
+         *
+         * @tparam T the component type
+         * @tparam S the number of components
+         * @param a the matrix to decompose
+         * @return {true, L and U packed into a single matrix, compressed permutation matrix}
+         *         or {false, unspecified, unspecified} if a decomposition doesn't exist.
+         */
+        template <typename T, std::size_t S>
+        constexpr std::tuple<bool, mat<T,S,S>, vec<size_t,S>> lup_find_decomposition(mat<T,S,S> a) {
+            vec<size_t, S> pi;
+            for (std::size_t i = 0; i < S; ++i) {
+                pi[i] = i;
+            }
+            for (std::size_t k = 0; k < S; ++k) {
+                T p(0);
+                std::size_t kPrime = 0;
+                for (std::size_t i = k; i < S; ++i) {
+                    if (vm::abs(a[k][i]) > p) {
+                        p = vm::abs(a[k][i]);
+                        kPrime = i;
+                    }
+                }
+                if (p < 1.0e-15) {
+                    return { false, mat<T,S,S>(), vec<size_t,S>() };
+                }
+                swap(pi[k], pi[kPrime]);
+                for (std::size_t i = 0; i < S; ++i) {
+                    swap(a[i][k], a[i][kPrime]);
+                }
+                for (std::size_t i = k + 1; i < S; ++i) {
+                    a[k][i] = a[k][i] / a[k][k];
+                    for (std::size_t j = k + 1; j < S; ++j) {
+                        a[j][i] = a[j][i] - a[k][i] * a[j][k];
+                    }
+                }
+            }
+            return { true, a, pi };
+        }
+
+        /**
+         * Solves a system of equations given an LUP factorization.
+         *
+         * From "LUP-Solve", Introduction to Algorithms by Cormen et. al., 2nd. ed. p745.
+         *
+         * @tparam T the component type
+         * @tparam S the number of components
+         * @param lu the LU factorization packed into a single matrix; see lupDecomposition()
+         * @param pi the permutation matrix packed into a vector; see lupDecomposition()
+         * @param b the target value in the system of equations a*x=b
+         * @return the solution value x in the system of equations a*x=b
+         */
+        template <typename T, std::size_t S>
+        constexpr vec<T,S> lup_solve_internal(const mat<T,S,S>& lu, const vec<size_t,S>& pi, const vec<T,S>& b) {
+            vec<T, S> x;
+            vec<T, S> y;
+            for (std::size_t i = 0; i < S; ++i) {
+                T sum = T(0);
+                for (std::size_t j = 0; j + 1 <= i; ++j) {
+                    sum += lu[j][i] * y[j];
+                }
+                y[i] = b[pi[i]] - sum;
+            }
+            for (std::size_t i = S - 1; i < S; --i) {
+                T sum = T(0);
+                for (std::size_t j = i+1; j < S; ++j) {
+                    sum += lu[j][i] * x[j];
+                }
+                x[i] = (y[i] - sum) / lu[i][i];
+            }
+            return x;
+        }
+    }
+
+    /**
+     * An LUP decomposition PA=LU of a square matrix A. The decomposition is computed once and can then be used to
+     * solve the system of equations A*x=b for many right-hand sides b, and to compute the determinant and the inverse
+     * of A.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     */
+    template <typename T, std::size_t S>
+    class lu_decomposition {
+    private:
+        bool m_valid;
+        mat<T,S,S> m_lu;
+        vec<size_t,S> m_pi;
+    public:
+        /**
+         * Computes the LUP decomposition of the given matrix. If no decomposition exists because the matrix is
+         * singular, the decomposition is invalid.
+         *
+         * @param a the matrix to decompose
+         */
+        constexpr explicit lu_decomposition(const mat<T,S,S>& a) :
+        m_valid(false),
+        m_lu(),
+        m_pi() {
+            const auto decomp = detail::lup_find_decomposition(a);
+            m_valid = std::get<0>(decomp);
+            m_lu = std::get<1>(decomp);
+            m_pi = std::get<2>(decomp);
+        }
+
+        /**
+         * Indicates whether the decomposition exists. If it doesn't, the decomposed matrix is singular and none of the
+         * functions of this class except determinant may be called.
+         *
+         * @return true if the decomposition exists and false otherwise
+         */
+        constexpr bool is_valid() const {
+            return m_valid;
+        }
+
+        /**
+         * Returns L and U packed into a single matrix. The elements below the diagonal belong to L, whose diagonal
+         * elements are 1, and the remaining elements belong to U.
+         *
+         * @return L and U packed into a single matrix
+         */
+        constexpr const mat<T,S,S>& lu() const {
+            return m_lu;
+        }
+
+        /**
+         * Returns the permutation matrix P in a compressed form where each element of the vector represents a row of
+         * the permutation matrix, and a value of `i` means the `i`th column of that row is set to 1.
+         *
+         * @return the compressed permutation matrix
+         */
+        constexpr const vec<size_t,S>& permutation() const {
+            return m_pi;
+        }
+
+        /**
+         * Solves the system of equations A*x=b for the given b.
+         *
+         * @param b the right-hand side of the system of equations
+         * @return the solution x of the system of equations
+         */
+        constexpr vec<T,S> solve(const vec<T,S>& b) const {
+            assert(m_valid);
+            return detail::lup_solve_internal(m_lu, m_pi, b);
+        }
+
+        /**
+         * Solves the system of equations A*x=b for each b in the given range and writes the solutions to the given
+         * output iterator, which may point to the beginning of the given range.
+         *
+         * @tparam I the type of the input iterator
+         * @tparam O the type of the output iterator
+         * @param cur the start of the range of right-hand sides
+         * @param end the end of the range of right-hand sides
+         * @param out the output iterator
+         * @return the output iterator pointing past the last solution
+         */
+        template <typename I, typename O>
+        O solve_many(I cur, I end, O out) const {
+            assert(m_valid);
+            while (cur != end) {
+                *out = detail::lup_solve_internal(m_lu, m_pi, *cur);
+                ++cur;
+                ++out;
+            }
+            return out;
+        }
+
+        /**
+         * Computes the determinant of A. Since L has a unit diagonal, the determinant of A is the product of the
+         * diagonal elements of U, negated if P is an odd permutation. If the decomposition is invalid, 0 is returned.
+         *
+         * @return the determinant of A
+         */
+        constexpr T determinant() const {
+            if (!m_valid) {
+                return static_cast<T>(0.0);
+            }
+
+            auto result = static_cast<T>(1.0);
+            for (std::size_t i = 0; i < S; ++i) {
+                result *= m_lu[i][i];
+            }
+
+            // count the transpositions needed to sort the permutation
+            auto pi = m_pi;
+            auto transpositions = std::size_t(0);
+            for (std::size_t i = 0; i < S; ++i) {
+                while (pi[i] != i) {
+                    detail::swap(pi[i], pi[pi[i]]);
+                    ++transpositions;
+                }
+            }
+            return transpositions % 2 == 0 ? result : -result;
+        }
+
+        /**
+         * Computes the inverse of A by solving for each column of the identity matrix.
+         *
+         * Uses the technique from "Computing a matrix inverse from an LUP decomposition"
+         * Introduction to Algorithms by Cormen et. al., 2nd. ed. p755.
+         *
+         * @return the inverse of A
+         */
+        constexpr mat<T,S,S> inverse() const {
+            assert(m_valid);
+            mat<T,S,S> result;
+            for (std::size_t i = 0; i < S; ++i) {
+                vec<T,S> targetColumn; // ith column of the S by S identity matrix
+                targetColumn[i] = static_cast<T>(1);
+
+                result[i] = detail::lup_solve_internal(m_lu, m_pi, targetColumn);
+            }
+            return result;
+        }
+    };
+
+    namespace detail {
+        /**
+         * Computes the determinant of the given matrix by Gaussian elimination with partial pivoting. The determinant
+         * is the product of the pivots, negated for every row exchange. Unlike lup_find_decomposition, this function
+         * does not reject small pivots, so that the determinant of a matrix with tiny, but nonzero entries is not
+         * flushed to 0. Only a pivot that is exactly 0 makes the matrix singular.
+         *
+         * @tparam T the component type, must be a floating point type
+         * @tparam S the number of components
+         * @param a the matrix to compute the determinant of
+         * @return the determinant of the given matrix
+         */
+        template <typename T, std::size_t S>
+        constexpr T gaussian_determinant(mat<T,S,S> a) {
+            auto result = static_cast<T>(1.0);
+            for (std::size_t k = 0; k < S; ++k) {
+                std::size_t kPrime = k;
+                for (std::size_t i = k + 1; i < S; ++i) {
+                    if (vm::abs(a[k][i]) > vm::abs(a[k][kPrime])) {
+                        kPrime = i;
+                    }
+                }
+                if (a[k][kPrime] == static_cast<T>(0.0)) {
+                    return static_cast<T>(0.0);
+                }
+                if (kPrime != k) {
+                    for (std::size_t j = k; j < S; ++j) {
+                        swap(a[j][k], a[j][kPrime]);
+                    }
+                    result = -result;
+                }
+                result *= a[k][k];
+                for (std::size_t i = k + 1; i < S; ++i) {
+                    const auto f = a[k][i] / a[k][k];
+                    for (std::size_t j = k + 1; j < S; ++j) {
+                        a[j][i] = a[j][i] - f * a[j][k];
+                    }
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Computes the determinant of the given matrix using the fraction-free Bareiss algorithm. All divisions are
+         * exact, so the result is exact for integer matrices as long as no intermediate value overflows.
+         *
+         * @tparam T the component type
+         * @tparam S the number of components
+         * @param a the matrix to compute the determinant of
+         * @return the determinant of the given matrix
+         */
+        template <typename T, std::size_t S>
+        constexpr T bareiss_determinant(mat<T,S,S> a) {
+            auto sign = static_cast<T>(1);
+            auto previous = static_cast<T>(1);
+            for (std::size_t k = 0; k < S; ++k) {
+                std::size_t kPrime = k;
+                while (kPrime < S && a[k][kPrime] == static_cast<T>(0)) {
+                    ++kPrime;
+                }
+                if (kPrime == S) {
+                    return static_cast<T>(0);
+                }
+                if (kPrime != k) {
+                    for (std::size_t j = k; j < S; ++j) {
+                        swap(a[j][k], a[j][kPrime]);
+                    }
+                    sign = -sign;
+                }
+                for (std::size_t i = k + 1; i < S; ++i) {
+                    for (std::size_t j = k + 1; j < S; ++j) {
+                        a[j][i] = (a[j][i] * a[k][k] - a[k][i] * a[j][k]) / previous;
+                    }
+                }
+                previous = a[k][k];
+            }
+            return sign * a[S - 1][S - 1];
+        }
+
         /**
          * Helper struct to compute a matrix determinant. This struct implements a method that works for all S, but
          * there are partial specializations of this template for specific values of S for which faster algorithms exist.
          *
+         * For floating point types, the determinant is computed by Gaussian elimination, see gaussian_determinant. For
+         * other types, the Bareiss algorithm is used, see bareiss_determinant, so that integer matrices yield exact
+         * results.
+         *
          * @tparam T the component type
          * @tparam S the number of components
          */
         template <typename T, std::size_t S>
         struct matrix_determinant {
             constexpr T operator()(const mat<T, S, S>& m) const {
-                // Laplace after first col
-                matrix_determinant<T, S-1> determinant {};
-
-                auto result = static_cast<T>(0.0);
-                for (std::size_t r = 0; r < S; r++) {
-                    const auto f = static_cast<T>(r % 2 == 0 ? 1.0 : -1.0);
-                    result += f * m[0][r] * determinant(extract_minor(m, r, 0));
+                if constexpr (std::is_floating_point<T>::value) {
+                    return gaussian_determinant(m);
+                } else {
+                    return bareiss_determinant(m);
                 }
-                return result;
             }
         };
 
-        // TODO: implement faster block-matrix based method for NxN matrices where N = 2^n
+        /**
+         * Partial specialization to optimize for the case of a 4x4 matrix. Uses the Laplace expansion along the upper
+         * two and the lower two rows, which needs twelve 2x2 subdeterminants.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct matrix_determinant<T, 4> {
+            constexpr T operator() (const mat<T, 4, 4>& m) const {
+                const auto s0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                const auto s1 = m[0][0] * m[2][1] - m[0][1] * m[2][0];
+                const auto s2 = m[0][0] * m[3][1] - m[0][1] * m[3][0];
+                const auto s3 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+                const auto s4 = m[1][0] * m[3][1] - m[1][1] * m[3][0];
+                const auto s5 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+
+                const auto c5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+                const auto c4 = m[1][2] * m[3][3] - m[1][3] * m[3][2];
+                const auto c3 = m[1][2] * m[2][3] - m[1][3] * m[2][2];
+                const auto c2 = m[0][2] * m[3][3] - m[0][3] * m[3][2];
+                const auto c1 = m[0][2] * m[2][3] - m[0][3] * m[2][2];
+                const auto c0 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+
+                return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            }
+        };
+
         /**
          * Partial specialization to optimize for the case of a 3x3 matrix.
          *
@@ -815,118 +1308,198 @@ namespace vm {
         return result;
     }
 
+    /**
+     * Solves a system of equations expressed as a*x=b, using LU factorization with pivoting.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param a square matrix
+     * @param b column vector
+     * @return either {true, x such that a*x=b} or {false, unspecified} if no solution could be found
+     */
+    template <typename T, std::size_t S>
+    constexpr std::tuple<bool, vec<T,S>> lup_solve(const mat<T,S,S>& a, const vec<T,S>& b) {
+        const auto decomp = lu_decomposition<T,S>(a);
+        if (!decomp.is_valid()) {
+            return std::make_tuple(false, vec<T,S>());
+        }
+        return std::make_tuple(true, decomp.solve(b));
+    }
+
     namespace detail {
         /**
-         * Finds an LUP decomposition of matrix a.
-         *
-         * Given A, finds P,L,U satisfying PA=LU where P is a permutation matrix,
-         * where L is lower-triangular with the diagonal elements set to 1,
-         * U is upper-triangular.
-         *
-         * The permutation matrix is returned in a compressed form where each element of the vector represents a row of
-         * the permutation matrix, and a value of `i` means the `i`th column of that row is set to 1.
-         *
-         * From "LUP-Decomposition", Introduction to Algorithms by Cormen et. al., 2nd. ed. p752.
+         * Inverts the given matrix using an LUP decomposition. The matrix is considered not invertible if any pivot
+         * element of the decomposition is too close to zero.
          *
          * @tparam T the component type
          * @tparam S the number of components
-         * @param a the matrix to decompose
-         * @return {true, L and U packed into a single matrix, compressed permutation matrix}
-         *         or {false, unspecified, unspecified} if a decomposition doesn't exist.
+         * @param m the matrix to invert
+         * @return a pair of a boolean indicating whether the matrix is invertible and the inverted matrix
          */
         template <typename T, std::size_t S>
-        constexpr std::tuple<bool, mat<T,S,S>, vec<size_t,S>> lup_find_decomposition(mat<T,S,S> a) {
-            vec<size_t, S> pi;
-            for (std::size_t i = 0; i < S; ++i) {
-                pi[i] = i;
+        constexpr std::tuple<bool, mat<T,S,S>> invert_lu(const mat<T,S,S>& m) {
+            const auto decomp = lu_decomposition<T,S>(m);
+            if (!decomp.is_valid()) {
+                return std::make_tuple(false, mat<T, S, S>::identity());
             }
-            for (std::size_t k = 0; k < S; ++k) {
-                T p(0);
-                std::size_t kPrime = 0;
-                for (std::size_t i = k; i < S; ++i) {
-                    if (vm::abs(a[k][i]) > p) {
-                        p = vm::abs(a[k][i]);
-                        kPrime = i;
-                    }
-                }
-                if (p < 1.0e-15) {
-                    return { false, mat<T,S,S>(), vec<size_t,S>() };
-                }
-                swap(pi[k], pi[kPrime]);
-                for (std::size_t i = 0; i < S; ++i) {
-                    swap(a[i][k], a[i][kPrime]);
-                }
-                for (std::size_t i = k + 1; i < S; ++i) {
-                    a[k][i] = a[k][i] / a[k][k];
-                    for (std::size_t j = k + 1; j < S; ++j) {
-                        a[j][i] = a[j][i] - a[k][i] * a[j][k];
-                    }
-                }
-            }
-            return { true, a, pi };
+            return std::make_tuple(true, decomp.inverse());
         }
 
         /**
-         * Solves a system of equations given an LUP factorization.
-         *
-         * From "LUP-Solve", Introduction to Algorithms by Cormen et. al., 2nd. ed. p745.
+         * Helper struct to invert a matrix. This struct implements a method that works for all S using an LUP
+         * decomposition, but there are partial specializations of this template for specific values of S which use the
+         * closed form solution instead.
          *
          * @tparam T the component type
          * @tparam S the number of components
-         * @param lu the LU factorization packed into a single matrix; see lupDecomposition()
-         * @param pi the permutation matrix packed into a vector; see lupDecomposition()
-         * @param b the target value in the system of equations a*x=b
-         * @return the solution value x in the system of equations a*x=b
          */
         template <typename T, std::size_t S>
-        constexpr vec<T,S> lup_solve_internal(const mat<T,S,S>& lu, const vec<size_t,S>& pi, const vec<T,S>& b) {
-            vec<T, S> x;
-            vec<T, S> y;
-            for (std::size_t i = 0; i < S; ++i) {
-                T sum = T(0);
-                for (std::size_t j = 0; j + 1 <= i; ++j) {
-                    sum += lu[j][i] * y[j];
+        struct matrix_inverse {
+            constexpr std::tuple<bool, mat<T,S,S>> operator()(const mat<T,S,S>& m) const {
+                return invert_lu(m);
+            }
+        };
+
+        /**
+         * Checks whether the given determinant is too small for the closed form inverse to be used. The determinant is
+         * the product of the S pivot elements of the LUP decomposition, so it can fall below the threshold that is
+         * used for each pivot even though no pivot does, e.g. for a small uniform scale. Callers must then fall back
+         * to invert_lu, which decides whether the matrix is invertible.
+         *
+         * @tparam T the component type
+         * @param determinant the determinant to check
+         * @return true if the given determinant is too close to zero and false otherwise
+         */
+        template <typename T>
+        constexpr bool is_singular_determinant(const T determinant) {
+            return !(vm::abs(determinant) >= static_cast<T>(1.0e-15));
+        }
+
+        /**
+         * Partial specialization to optimize for the case of a 4x4 matrix. The inverse is computed as the adjugate
+         * divided by the determinant. The cofactors are computed from the 2x2 subdeterminants of the upper two and
+         * the lower two rows, as described in "The Laplace Expansion Theorem: Computing the Determinants and Inverses
+         * of Matrices" by David Eberly.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct matrix_inverse<T, 4> {
+            constexpr std::tuple<bool, mat<T,4,4>> operator()(const mat<T,4,4>& m) const {
+                // 2x2 subdeterminants of the upper two rows
+                const auto s0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                const auto s1 = m[0][0] * m[2][1] - m[0][1] * m[2][0];
+                const auto s2 = m[0][0] * m[3][1] - m[0][1] * m[3][0];
+                const auto s3 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+                const auto s4 = m[1][0] * m[3][1] - m[1][1] * m[3][0];
+                const auto s5 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+
+                // 2x2 subdeterminants of the lower two rows
+                const auto c5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+                const auto c4 = m[1][2] * m[3][3] - m[1][3] * m[3][2];
+                const auto c3 = m[1][2] * m[2][3] - m[1][3] * m[2][2];
+                const auto c2 = m[0][2] * m[3][3] - m[0][3] * m[3][2];
+                const auto c1 = m[0][2] * m[2][3] - m[0][3] * m[2][2];
+                const auto c0 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+
+                const auto det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+                if (is_singular_determinant(det)) {
+                    return invert_lu(m);
                 }
-                y[i] = b[pi[i]] - sum;
+
+                const auto f = static_cast<T>(1.0) / det;
+
+                mat<T,4,4> result;
+                result[0][0] = ( m[1][1] * c5 - m[2][1] * c4 + m[3][1] * c3) * f;
+                result[1][0] = (-m[1][0] * c5 + m[2][0] * c4 - m[3][0] * c3) * f;
+                result[2][0] = ( m[1][3] * s5 - m[2][3] * s4 + m[3][3] * s3) * f;
+                result[3][0] = (-m[1][2] * s5 + m[2][2] * s4 - m[3][2] * s3) * f;
+
+                result[0][1] = (-m[0][1] * c5 + m[2][1] * c2 - m[3][1] * c1) * f;
+                result[1][1] = ( m[0][0] * c5 - m[2][0] * c2 + m[3][0] * c1) * f;
+                result[2][1] = (-m[0][3] * s5 + m[2][3] * s2 - m[3][3] * s1) * f;
+                result[3][1] = ( m[0][2] * s5 - m[2][2] * s2 + m[3][2] * s1) * f;
+
+                result[0][2] = ( m[0][1] * c4 - m[1][1] * c2 + m[3][1] * c0) * f;
+                result[1][2] = (-m[0][0] * c4 + m[1][0] * c2 - m[3][0] * c0) * f;
+                result[2][2] = ( m[0][3] * s4 - m[1][3] * s2 + m[3][3] * s0) * f;
+                result[3][2] = (-m[0][2] * s4 + m[1][2] * s2 - m[3][2] * s0) * f;
+
+                result[0][3] = (-m[0][1] * c3 + m[1][1] * c1 - m[2][1] * c0) * f;
+                result[1][3] = ( m[0][0] * c3 - m[1][0] * c1 + m[2][0] * c0) * f;
+                result[2][3] = (-m[0][3] * s3 + m[1][3] * s1 - m[2][3] * s0) * f;
+                result[3][3] = ( m[0][2] * s3 - m[1][2] * s1 + m[2][2] * s0) * f;
+                return std::make_tuple(true, result);
             }
-            for (std::size_t i = S - 1; i < S; --i) {
-                T sum = T(0);
-                for (std::size_t j = i+1; j < S; ++j) {
-                    sum += lu[j][i] * x[j];
+        };
+
+        /**
+         * Partial specialization to optimize for the case of a 3x3 matrix. The inverse is computed as the adjugate
+         * divided by the determinant.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct matrix_inverse<T, 3> {
+            constexpr std::tuple<bool, mat<T,3,3>> operator()(const mat<T,3,3>& m) const {
+                // cofactors of the first column
+                const auto a00 = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+                const auto a10 = m[2][1] * m[0][2] - m[0][1] * m[2][2];
+                const auto a20 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+
+                const auto det = m[0][0] * a00 + m[1][0] * a10 + m[2][0] * a20;
+                if (is_singular_determinant(det)) {
+                    return invert_lu(m);
                 }
-                x[i] = (y[i] - sum) / lu[i][i];
+
+                const auto f = static_cast<T>(1.0) / det;
+
+                mat<T,3,3> result;
+                result[0][0] = a00 * f;
+                result[0][1] = a10 * f;
+                result[0][2] = a20 * f;
+                result[1][0] = (m[2][0] * m[1][2] - m[1][0] * m[2][2]) * f;
+                result[1][1] = (m[0][0] * m[2][2] - m[2][0] * m[0][2]) * f;
+                result[1][2] = (m[1][0] * m[0][2] - m[0][0] * m[1][2]) * f;
+                result[2][0] = (m[1][0] * m[2][1] - m[2][0] * m[1][1]) * f;
+                result[2][1] = (m[2][0] * m[0][1] - m[0][0] * m[2][1]) * f;
+                result[2][2] = (m[0][0] * m[1][1] - m[1][0] * m[0][1]) * f;
+                return std::make_tuple(true, result);
             }
-            return x;
-        }
-    }
+        };
 
-    /**
-     * Solves a system of equations expressed as a*x=b, using LU factorization with pivoting.
-     *
-     * @tparam T the component type
-     * @tparam S the number of components
-     * @param a square matrix
-     * @param b column vector
-     * @return either {true, x such that a*x=b} or {false, unspecified} if no solution could be found
-     */
-    template <typename T, std::size_t S>
-    constexpr std::tuple<bool, vec<T,S>> lup_solve(const mat<T,S,S>& a, const vec<T,S>& b) {
-        const auto decomp = detail::lup_find_decomposition(a);
-        const bool success = std::get<0>(decomp);
-        if (!success) {
-            return std::make_tuple(false, vec<T,S>());
-        }
+        /**
+         * Partial specialization to optimize for the case of a 2x2 matrix.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct matrix_inverse<T, 2> {
+            constexpr std::tuple<bool, mat<T,2,2>> operator()(const mat<T,2,2>& m) const {
+                const auto det = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+                if (is_singular_determinant(det)) {
+                    return invert_lu(m);
+                }
+
+                const auto f = static_cast<T>(1.0) / det;
 
-        const auto lu = std::get<1>(decomp);
-        const auto pi = std::get<2>(decomp);
-        return std::make_tuple(true, detail::lup_solve_internal(lu, pi, b));
+                mat<T,2,2> result;
+                result[0][0] =  m[1][1] * f;
+                result[0][1] = -m[0][1] * f;
+                result[1][0] = -m[1][0] * f;
+                result[1][1] =  m[0][0] * f;
+                return std::make_tuple(true, result);
+            }
+        };
     }
 
     /**
      * Inverts the given square matrix if possible.
      *
-     * Uses the technique from "Computing a matrix inverse from an LUP decomposition"
-     * Introduction to Algorithms by Cormen et. al., 2nd. ed. p755.
+     * Matrices with up to four rows and columns are inverted using the closed form solution, that is, by dividing the
+     * adjugate by the determinant. If the absolute value of the determinant is less than 1e-15, and for larger
+     * matrices, the matrix is inverted using an LUP decomposition instead. The matrix is considered not invertible if
+     * any pivot element of the decomposition is less than 1e-15.
      *
      * @tparam T the component type
      * @tparam S the number of components
@@ -936,23 +1509,6 @@ namespace vm {
      */
     template <typename T, std::size_t S>
     constexpr std::tuple<bool, mat<T,S,S>> invert(const mat<T,S,S>& m) {
-        const auto decomp = detail::lup_find_decomposition(m);
-        const bool success = std::get<0>(decomp);
-        if (!success) {
-            return std::make_tuple(false, mat<T, S, S>::identity());
-        }
-
-        const auto lu = std::get<1>(decomp);
-        const auto pi = std::get<2>(decomp);
-
-        mat<T, S, S> result;
-        for (std::size_t i = 0; i < S; ++i) {
-            vec<T,S> targetColumn; // ith column of the S by S identity matrix
-            targetColumn[i] = static_cast<T>(1);
-
-            result[i] = detail::lup_solve_internal(lu, pi, targetColumn);
-        }
-        return std::make_tuple(true, result);
+        return detail::matrix_inverse<T, S>()(m);
     }
 }
-
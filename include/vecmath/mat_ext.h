@@ -23,9 +23,13 @@
 #include "quat.h"
 #include "util.h"
 #include "bbox.h"
+#include "simd.h"
 
 #include <array>
+#include <cassert>
+#include <cstddef>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace vm {
@@ -189,6 +193,242 @@ namespace vm {
         return result;
     }
 
+    namespace detail {
+        enum class transform_kind {
+            point,
+            affine_point,
+            direction
+        };
+
+        /**
+         * Transforms the given vector by the given square matrix. For points, this is the product of the matrix and
+         * the point. Affine points skip the division by the homogeneous component, and directions are only multiplied
+         * with the upper left (S-1)x(S-1) part of the matrix.
+         *
+         * @tparam K the kind of transformation to apply
+         * @tparam T the component type
+         * @tparam S the number of rows and columns of the matrix
+         * @param m the transformation matrix
+         * @param v the vector to transform
+         * @return the transformed vector
+         */
+        template <transform_kind K, typename T, std::size_t S>
+        vec<T,S-1> transform_vector(const mat<T,S,S>& m, const vec<T,S-1>& v) {
+            if constexpr (K == transform_kind::point) {
+                return m * v;
+            } else {
+                vec<T,S-1> result;
+                for (std::size_t r = 0u; r < S-1; ++r) {
+                    for (std::size_t c = 0u; c < S-1; ++c) {
+                        result[r] += m[c][r] * v[c];
+                    }
+                    if constexpr (K == transform_kind::affine_point) {
+                        result[r] += m[S-1][r];
+                    }
+                }
+                return result;
+            }
+        }
+
+        /**
+         * Transforms the given contiguous vectors by the given square matrix. The vectors are processed in blocks of
+         * pack<T>::width vectors whose components are transposed into packs, so that each matrix element is multiplied
+         * with all vectors of a block at once. The remaining vectors are transformed one by one. Every lane performs
+         * the same operations in the same order as transform_vector, so the results are identical.
+         *
+         * @tparam K the kind of transformation to apply
+         * @tparam T the component type
+         * @tparam S the number of rows and columns of the matrix
+         * @param m the transformation matrix
+         * @param in the vectors to transform
+         * @param count the number of vectors to transform
+         * @param out the destination, may be identical to in
+         */
+        template <transform_kind K, typename T, std::size_t S>
+        void transform_vectors(const mat<T,S,S>& m, const vec<T,S-1>* in, const std::size_t count, vec<T,S-1>* out) {
+            static_assert(sizeof(vec<T,S-1>) == (S-1) * sizeof(T), "vectors must be tightly packed");
+
+            constexpr auto width = pack<T>::width;
+            constexpr auto rows = K == transform_kind::point ? S : S-1;
+
+            pack<T> elements[S][rows];
+            for (std::size_t c = 0u; c < S; ++c) {
+                for (std::size_t r = 0u; r < rows; ++r) {
+                    elements[c][r] = pack<T>::broadcast(m[c][r]);
+                }
+            }
+
+            std::size_t i = 0u;
+            for (; i + width <= count; i += width) {
+                pack<T> x[S-1];
+                load_interleaved(in[i].v, x);
+
+                const auto row = [&](const std::size_t r) {
+                    auto sum = pack<T>::broadcast(static_cast<T>(0.0));
+                    for (std::size_t c = 0u; c < S-1; ++c) {
+                        sum = sum + elements[c][r] * x[c];
+                    }
+                    if constexpr (K != transform_kind::direction) {
+                        sum = sum + elements[S-1][r];
+                    }
+                    return sum;
+                };
+
+                pack<T> y[S-1];
+                for (std::size_t r = 0u; r < S-1; ++r) {
+                    y[r] = row(r);
+                }
+                if constexpr (K == transform_kind::point) {
+                    const auto w = row(S-1);
+                    for (std::size_t r = 0u; r < S-1; ++r) {
+                        y[r] = y[r] / w;
+                    }
+                }
+                store_interleaved(y, out[i].v);
+            }
+
+            for (; i < count; ++i) {
+                out[i] = transform_vector<K>(m, in[i]);
+            }
+        }
+    }
+
+    /**
+     * Transforms the given points by the given matrix and writes the results to the given destination. Each result is
+     * identical to the product of the matrix and the corresponding point, but the points are transformed in blocks
+     * using SIMD instructions if available. If the given matrix is affine, the division by the homogeneous component
+     * is omitted. No memory is allocated.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @param m the transformation matrix
+     * @param points the points to transform
+     * @param count the number of points
+     * @param out the destination, must have room for the given number of points and may be identical to points
+     */
+    template <typename T, std::size_t S>
+    void transform_points(const mat<T,S,S>& m, const vec<T,S-1>* points, const std::size_t count, vec<T,S-1>* out) {
+        if (is_affine(m)) {
+            detail::transform_vectors<detail::transform_kind::affine_point>(m, points, count, out);
+        } else {
+            detail::transform_vectors<detail::transform_kind::point>(m, points, count, out);
+        }
+    }
+
+    /**
+     * Transforms the given points in place by the given matrix. See the overload with a destination for details.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @param m the transformation matrix
+     * @param points the points to transform
+     * @param count the number of points
+     */
+    template <typename T, std::size_t S>
+    void transform_points(const mat<T,S,S>& m, vec<T,S-1>* points, const std::size_t count) {
+        transform_points(m, points, count, points);
+    }
+
+    /**
+     * Transforms the points in the given range by the given matrix and writes the results to the given output
+     * iterator, which may point to the beginning of the given range. If both iterators are pointers, the points are
+     * transformed in blocks as described above. Otherwise, they are transformed one by one, omitting the division by
+     * the homogeneous component if the given matrix is affine.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @tparam I the type of the input iterator
+     * @tparam O the type of the output iterator
+     * @param m the transformation matrix
+     * @param cur the start of the range of points
+     * @param end the end of the range of points
+     * @param out the output iterator
+     * @return the output iterator pointing past the last transformed point
+     */
+    template <typename T, std::size_t S, typename I, typename O>
+    O transform_points(const mat<T,S,S>& m, I cur, I end, O out) {
+        if constexpr (std::is_pointer<I>::value && std::is_pointer<O>::value) {
+            const auto count = static_cast<std::size_t>(end - cur);
+            transform_points(m, cur, count, out);
+            return out + count;
+        } else {
+            const auto affine = is_affine(m);
+            while (cur != end) {
+                if (affine) {
+                    *out = detail::transform_vector<detail::transform_kind::affine_point>(m, *cur);
+                } else {
+                    *out = detail::transform_vector<detail::transform_kind::point>(m, *cur);
+                }
+                ++cur;
+                ++out;
+            }
+            return out;
+        }
+    }
+
+    /**
+     * Transforms the given directions by the given matrix and writes the results to the given destination. Only the
+     * upper left (S-1)x(S-1) part of the matrix is applied, so for an affine matrix, each result is identical to the
+     * product of strip_translation(m) and the corresponding direction. The directions are transformed in blocks using
+     * SIMD instructions if available. No memory is allocated.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @param m the transformation matrix
+     * @param directions the directions to transform
+     * @param count the number of directions
+     * @param out the destination, must have room for the given number of directions and may be identical to directions
+     */
+    template <typename T, std::size_t S>
+    void transform_directions(const mat<T,S,S>& m, const vec<T,S-1>* directions, const std::size_t count, vec<T,S-1>* out) {
+        detail::transform_vectors<detail::transform_kind::direction>(m, directions, count, out);
+    }
+
+    /**
+     * Transforms the given directions in place by the given matrix. See the overload with a destination for details.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @param m the transformation matrix
+     * @param directions the directions to transform
+     * @param count the number of directions
+     */
+    template <typename T, std::size_t S>
+    void transform_directions(const mat<T,S,S>& m, vec<T,S-1>* directions, const std::size_t count) {
+        transform_directions(m, directions, count, directions);
+    }
+
+    /**
+     * Transforms the directions in the given range by the given matrix and writes the results to the given output
+     * iterator, which may point to the beginning of the given range. If both iterators are pointers, the directions
+     * are transformed in blocks as described above. Otherwise, they are transformed one by one.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns of the matrix
+     * @tparam I the type of the input iterator
+     * @tparam O the type of the output iterator
+     * @param m the transformation matrix
+     * @param cur the start of the range of directions
+     * @param end the end of the range of directions
+     * @param out the output iterator
+     * @return the output iterator pointing past the last transformed direction
+     */
+    template <typename T, std::size_t S, typename I, typename O>
+    O transform_directions(const mat<T,S,S>& m, I cur, I end, O out) {
+        if constexpr (std::is_pointer<I>::value && std::is_pointer<O>::value) {
+            const auto count = static_cast<std::size_t>(end - cur);
+            transform_directions(m, cur, count, out);
+            return out + count;
+        } else {
+            while (cur != end) {
+                *out = detail::transform_vector<detail::transform_kind::direction>(m, *cur);
+                ++cur;
+                ++out;
+            }
+            return out;
+        }
+    }
+
     /**
      * Returns a perspective camera transformation with the given parameters. The returned matrix transforms from eye
      * coordinates to clip coordinates.
@@ -416,6 +656,222 @@ namespace vm {
             0,                       0,                       0,                       1);
     }
 
+    /**
+     * Returns a 3x3 rotation matrix that performs the same rotation as the given quaternion. This is the upper left
+     * 3x3 part of rotation_matrix(quat).
+     *
+     * @tparam T the component type
+     * @param quat the quaternion, expected to be normalized
+     * @return the rotation matrix
+     */
+    template <typename T>
+    constexpr mat<T, 3, 3> rotation_matrix_3x3(const quat<T>& quat) {
+        constexpr auto one = static_cast<T>(1);
+        constexpr auto two = static_cast<T>(2);
+
+        const auto x = quat.v[0];
+        const auto y = quat.v[1];
+        const auto z = quat.v[2];
+        const auto w = quat.r;
+
+        const auto x2 = x*x;
+        const auto y2 = y*y;
+        const auto z2 = z*z;
+
+        return mat<T, 3, 3>(
+            one - two * (y2  + z2),        two * (x*y - z*w),       two * (x*z + y*w),
+                  two * (x*y + z*w), one - two * (x2  + z2),        two * (y*z - x*w),
+                  two * (x*z - y*w),       two * (y*z + x*w), one - two * (x2  + y2));
+    }
+
+    /**
+     * Computes the 3x3 rotation matrices of the given quaternions and writes them to the given destination. Each
+     * result is computed with the same operations as rotation_matrix_3x3 of the corresponding quaternion, but the
+     * quaternions are converted in blocks using SIMD instructions if available. The results may differ by a few units
+     * in the last place if the compiler contracts either implementation into fused multiply-add instructions. No
+     * memory is allocated.
+     *
+     * @tparam T the component type
+     * @param quats the quaternions, expected to be normalized
+     * @param count the number of quaternions
+     * @param out the destination, must have room for the given number of matrices
+     */
+    template <typename T>
+    void rotation_matrix_3x3(const quat<T>* quats, const std::size_t count, mat<T, 3, 3>* out) {
+        static_assert(sizeof(quat<T>) == 4u * sizeof(T), "quaternions must be tightly packed");
+        static_assert(sizeof(mat<T, 3, 3>) == 9u * sizeof(T), "matrices must be tightly packed");
+        using pack = detail::pack<T>;
+
+        const auto one = pack::broadcast(static_cast<T>(1));
+        const auto two = pack::broadcast(static_cast<T>(2));
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            pack q[4];
+            detail::load_interleaved(reinterpret_cast<const T*>(quats + i), q);
+
+            const auto& w = q[0];
+            const auto& x = q[1];
+            const auto& y = q[2];
+            const auto& z = q[3];
+
+            const auto x2 = x*x;
+            const auto y2 = y*y;
+            const auto z2 = z*z;
+
+            // column major, same operations in the same order as the scalar version
+            const pack m[9] = {
+                one - two * (y2  + z2),       two * (x*y + z*w),       two * (x*z - y*w),
+                      two * (x*y - z*w), one - two * (x2  + z2),       two * (y*z + x*w),
+                      two * (x*z + y*w),       two * (y*z - x*w), one - two * (x2  + y2)
+            };
+            detail::store_interleaved(m, out[i][0].v);
+        }
+
+        for (; i < count; ++i) {
+            out[i] = rotation_matrix_3x3(quats[i]);
+        }
+    }
+
+    /**
+     * Returns a unit quaternion that performs the same rotation as the given rotation matrix. This uses Shepperd's
+     * method: of the four quaternion components, the one with the largest magnitude is computed from the diagonal,
+     * and the others are computed from the off diagonal elements divided by it. This avoids the loss of precision of
+     * the naive method when the rotation angle is close to 180 degrees.
+     *
+     * Since q and -q represent the same rotation, the sign of the result is unspecified.
+     *
+     * @tparam T the component type
+     * @param m the rotation matrix, expected to be orthonormal with determinant 1
+     * @return the quaternion
+     */
+    template <typename T>
+    quat<T> rotation_matrix_to_quat(const mat<T, 3, 3>& m) {
+        constexpr auto one = static_cast<T>(1);
+        constexpr auto two = static_cast<T>(2);
+        constexpr auto quarter = static_cast<T>(0.25);
+
+        // m[c][r] is the element in row r and column c
+        const auto m00 = m[0][0];
+        const auto m11 = m[1][1];
+        const auto m22 = m[2][2];
+        const auto trace = m00 + m11 + m22;
+
+        if (trace >= m00 && trace >= m11 && trace >= m22) {
+            const auto s = std::sqrt(one + trace) * two;
+            const auto f = one / s;
+            return quat<T>(s * quarter, vec<T,3>(
+                (m[1][2] - m[2][1]) * f,
+                (m[2][0] - m[0][2]) * f,
+                (m[0][1] - m[1][0]) * f));
+        } else if (m00 >= m11 && m00 >= m22) {
+            const auto s = std::sqrt(one + m00 - m11 - m22) * two;
+            const auto f = one / s;
+            return quat<T>((m[1][2] - m[2][1]) * f, vec<T,3>(
+                s * quarter,
+                (m[1][0] + m[0][1]) * f,
+                (m[2][0] + m[0][2]) * f));
+        } else if (m11 >= m22) {
+            const auto s = std::sqrt(one - m00 + m11 - m22) * two;
+            const auto f = one / s;
+            return quat<T>((m[2][0] - m[0][2]) * f, vec<T,3>(
+                (m[1][0] + m[0][1]) * f,
+                s * quarter,
+                (m[2][1] + m[1][2]) * f));
+        } else {
+            const auto s = std::sqrt(one - m00 - m11 + m22) * two;
+            const auto f = one / s;
+            return quat<T>((m[0][1] - m[1][0]) * f, vec<T,3>(
+                (m[2][0] + m[0][2]) * f,
+                (m[2][1] + m[1][2]) * f,
+                s * quarter));
+        }
+    }
+
+    /**
+     * Returns a unit quaternion that performs the same rotation as the upper left 3x3 part of the given matrix. See
+     * the 3x3 overload for details.
+     *
+     * @tparam T the component type
+     * @param m the rotation matrix
+     * @return the quaternion
+     */
+    template <typename T>
+    quat<T> rotation_matrix_to_quat(const mat<T, 4, 4>& m) {
+        return rotation_matrix_to_quat(extract_minor(m, 3u, 3u));
+    }
+
+    /**
+     * Converts the given rotation matrices to quaternions and writes them to the given destination. Each result is
+     * computed with the same operations as rotation_matrix_to_quat of the corresponding matrix, but the matrices are
+     * converted in blocks using SIMD instructions if available. Within a block, the branches of Shepperd's method are
+     * replaced by selecting the appropriate values in each lane. The results may differ by a few units in the last
+     * place if the compiler contracts either implementation into fused multiply-add instructions. No memory is
+     * allocated.
+     *
+     * @tparam T the component type
+     * @param matrices the rotation matrices
+     * @param count the number of matrices
+     * @param out the destination, must have room for the given number of quaternions
+     */
+    template <typename T>
+    void rotation_matrix_to_quat(const mat<T, 3, 3>* matrices, const std::size_t count, quat<T>* out) {
+        static_assert(sizeof(quat<T>) == 4u * sizeof(T), "quaternions must be tightly packed");
+        static_assert(sizeof(mat<T, 3, 3>) == 9u * sizeof(T), "matrices must be tightly packed");
+        using pack = detail::pack<T>;
+
+        const auto one = pack::broadcast(static_cast<T>(1));
+        const auto two = pack::broadcast(static_cast<T>(2));
+        const auto quarter = pack::broadcast(static_cast<T>(0.25));
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            // column major, so m[3 * c + r] is the element in row r and column c
+            pack m[9];
+            detail::load_interleaved(matrices[i][0].v, m);
+
+            const auto& m00 = m[0];
+            const auto& m11 = m[4];
+            const auto& m22 = m[8];
+            const auto trace = m00 + m11 + m22;
+
+            const auto isW = (trace >= m00) & (trace >= m11) & (trace >= m22);
+            const auto isX = (m00 >= m11) & (m00 >= m22);
+            const auto isY = m11 >= m22;
+
+            const auto pick = [&](const pack& w, const pack& x, const pack& y, const pack& z) {
+                return select(isW, w, select(isX, x, select(isY, y, z)));
+            };
+
+            const auto s = sqrt(pick(
+                one + trace,
+                one + m00 - m11 - m22,
+                one - m00 + m11 - m22,
+                one - m00 - m11 + m22)) * two;
+            const auto f = one / s;
+            const auto d = s * quarter;
+
+            const auto a = (m[5] - m[7]) * f;
+            const auto b = (m[6] - m[2]) * f;
+            const auto c = (m[1] - m[3]) * f;
+            const auto xy = (m[3] + m[1]) * f;
+            const auto xz = (m[6] + m[2]) * f;
+            const auto yz = (m[7] + m[5]) * f;
+
+            const pack q[4] = {
+                pick(d, a, b, c),
+                pick(a, d, xy, xz),
+                pick(b, xy, d, yz),
+                pick(c, xz, yz, d)
+            };
+            detail::store_interleaved(q, reinterpret_cast<T*>(out + i));
+        }
+
+        for (; i < count; ++i) {
+            out[i] = rotation_matrix_to_quat(matrices[i]);
+        }
+    }
+
     /**
      * Returns a matrix that will rotate the first given vector onto the second given vector about their perpendicular
      * axis. The vectors are expected to be normalized.
@@ -481,6 +937,211 @@ namespace vm {
         return result;
     }
 
+    namespace detail {
+        /**
+         * Checks whether the given square matrix represents a rigid transformation, that is, whether it is affine and
+         * its upper left (S-1)x(S-1) part is orthonormal.
+         *
+         * @tparam T the component type
+         * @tparam S the number of rows and columns
+         * @param m the matrix to check
+         * @param epsilon the epsilon value
+         * @return true if the given matrix represents a rigid transformation and false otherwise
+         */
+        template <typename T, std::size_t S>
+        constexpr bool is_rigid(const mat<T, S, S>& m, const T epsilon) {
+            if (!is_affine(m)) {
+                return false;
+            }
+            for (size_t i = 0; i < S-1; ++i) {
+                for (size_t j = i; j < S-1; ++j) {
+                    auto d = static_cast<T>(0.0);
+                    for (size_t k = 0; k < S-1; ++k) {
+                        d += m[i][k] * m[j][k];
+                    }
+                    if (!is_equal(d, static_cast<T>(i == j ? 1.0 : 0.0), epsilon)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    namespace detail {
+        /**
+         * Computes the inverse of the given affine transformation matrix from the given inverse of its upper left
+         * (S-1)x(S-1) part.
+         *
+         * @tparam T the component type
+         * @tparam S the number of rows and columns
+         * @param m the affine transformation matrix
+         * @param linear a pair of a boolean indicating whether the upper left part is invertible and its inverse
+         * @return a pair of a boolean indicating whether the matrix is invertible and the inverted matrix
+         */
+        template <typename T, std::size_t S>
+        constexpr std::tuple<bool, mat<T, S, S>> invert_affine_from_linear(const mat<T, S, S>& m, const std::tuple<bool, mat<T, S-1, S-1>>& linear) {
+            if (!std::get<0>(linear)) {
+                return std::make_tuple(false, mat<T, S, S>::identity());
+            }
+
+            const auto& linearInverse = std::get<1>(linear);
+            mat<T, S, S> result;
+            for (size_t r = 0; r < S-1; ++r) {
+                auto t = static_cast<T>(0.0);
+                for (size_t c = 0; c < S-1; ++c) {
+                    result[c][r] = linearInverse[c][r];
+                    t += linearInverse[c][r] * m[S-1][c];
+                }
+                result[S-1][r] = -t;
+            }
+            return std::make_tuple(true, result);
+        }
+
+        /**
+         * Helper struct to invert an affine transformation matrix. This struct implements a method that works for all
+         * S, but there is a partial specialization of this template for 4x4 matrices which computes the inverse of
+         * the upper left 3x3 part in place.
+         *
+         * @tparam T the component type
+         * @tparam S the number of rows and columns
+         */
+        template <typename T, std::size_t S>
+        struct affine_matrix_inverse {
+            constexpr std::tuple<bool, mat<T, S, S>> operator()(const mat<T, S, S>& m) const {
+                return invert_affine_from_linear(m, invert(extract_minor(m, S-1, S-1)));
+            }
+        };
+
+        /**
+         * Partial specialization to optimize for the case of a 4x4 matrix.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct affine_matrix_inverse<T, 4> {
+            constexpr std::tuple<bool, mat<T, 4, 4>> operator()(const mat<T, 4, 4>& m) const {
+                // cofactors of the first column of the upper left 3x3 part
+                const auto a00 = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+                const auto a10 = m[2][1] * m[0][2] - m[0][1] * m[2][2];
+                const auto a20 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+
+                const auto det = m[0][0] * a00 + m[1][0] * a10 + m[2][0] * a20;
+                if (is_singular_determinant(det)) {
+                    // let the LUP decomposition decide whether the upper left part is invertible, see matrix_inverse
+                    return invert_affine_from_linear(m, invert_lu(extract_minor(m, 3, 3)));
+                }
+
+                const auto f = static_cast<T>(1.0) / det;
+
+                mat<T, 4, 4> result;
+                result[0][0] = a00 * f;
+                result[0][1] = a10 * f;
+                result[0][2] = a20 * f;
+                result[1][0] = (m[2][0] * m[1][2] - m[1][0] * m[2][2]) * f;
+                result[1][1] = (m[0][0] * m[2][2] - m[2][0] * m[0][2]) * f;
+                result[1][2] = (m[1][0] * m[0][2] - m[0][0] * m[1][2]) * f;
+                result[2][0] = (m[1][0] * m[2][1] - m[2][0] * m[1][1]) * f;
+                result[2][1] = (m[2][0] * m[0][1] - m[0][0] * m[2][1]) * f;
+                result[2][2] = (m[0][0] * m[1][1] - m[1][0] * m[0][1]) * f;
+
+                result[3][0] = -(result[0][0] * m[3][0] + result[1][0] * m[3][1] + result[2][0] * m[3][2]);
+                result[3][1] = -(result[0][1] * m[3][0] + result[1][1] * m[3][1] + result[2][1] * m[3][2]);
+                result[3][2] = -(result[0][2] * m[3][0] + result[1][2] * m[3][1] + result[2][2] * m[3][2]);
+                return std::make_tuple(true, result);
+            }
+        };
+
+        /**
+         * Helper struct to invert a rigid transformation matrix. This struct implements a method that works for all
+         * S, but there is a partial specialization of this template for 4x4 matrices.
+         *
+         * @tparam T the component type
+         * @tparam S the number of rows and columns
+         */
+        template <typename T, std::size_t S>
+        struct rigid_matrix_inverse {
+            constexpr mat<T, S, S> operator()(const mat<T, S, S>& m) const {
+                mat<T, S, S> result;
+                for (size_t r = 0; r < S-1; ++r) {
+                    auto t = static_cast<T>(0.0);
+                    for (size_t c = 0; c < S-1; ++c) {
+                        result[c][r] = m[r][c];
+                        t += m[r][c] * m[S-1][c];
+                    }
+                    result[S-1][r] = -t;
+                }
+                return result;
+            }
+        };
+
+        /**
+         * Partial specialization to optimize for the case of a 4x4 matrix.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct rigid_matrix_inverse<T, 4> {
+            constexpr mat<T, 4, 4> operator()(const mat<T, 4, 4>& m) const {
+                mat<T, 4, 4> result;
+                result[0][0] = m[0][0];
+                result[0][1] = m[1][0];
+                result[0][2] = m[2][0];
+                result[1][0] = m[0][1];
+                result[1][1] = m[1][1];
+                result[1][2] = m[2][1];
+                result[2][0] = m[0][2];
+                result[2][1] = m[1][2];
+                result[2][2] = m[2][2];
+
+                result[3][0] = -(m[0][0] * m[3][0] + m[0][1] * m[3][1] + m[0][2] * m[3][2]);
+                result[3][1] = -(m[1][0] * m[3][0] + m[1][1] * m[3][1] + m[1][2] * m[3][2]);
+                result[3][2] = -(m[2][0] * m[3][0] + m[2][1] * m[3][1] + m[2][2] * m[3][2]);
+                return result;
+            }
+        };
+    }
+
+    /**
+     * Inverts the given affine transformation matrix if possible. Only the upper left (S-1)x(S-1) part of the matrix
+     * is inverted, and the inverse translation is obtained by applying that inverse to the negated translation. The
+     * upper left part is considered not invertible under the same conditions as in invert.
+     *
+     * The given matrix must be affine, that is, its last row must be (0, ..., 0, 1). This is only checked in debug
+     * builds.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns
+     * @param m the matrix to invert
+     * @return a pair of a boolean and a matrix such that the boolean indicates whether the
+     * matrix is invertible, and if so, the matrix is the inverted given matrix
+     */
+    template <typename T, std::size_t S>
+    constexpr std::tuple<bool, mat<T, S, S>> invert_affine(const mat<T, S, S>& m) {
+        assert(is_affine(m));
+        return detail::affine_matrix_inverse<T, S>()(m);
+    }
+
+    /**
+     * Inverts the given rigid transformation matrix, that is, a matrix that only rotates and translates. Since the
+     * upper left (S-1)x(S-1) part of such a matrix is orthonormal, its inverse is its transpose, and the inverse
+     * translation is obtained by applying that transpose to the negated translation. A rigid transformation is always
+     * invertible.
+     *
+     * The given matrix must be affine and its upper left (S-1)x(S-1) part must be orthonormal. This is only checked in
+     * debug builds.
+     *
+     * @tparam T the component type
+     * @tparam S the number of rows and columns
+     * @param m the matrix to invert
+     * @return the inverted matrix
+     */
+    template <typename T, std::size_t S>
+    constexpr mat<T, S, S> invert_rigid(const mat<T, S, S>& m) {
+        assert(detail::is_rigid(m, constants<T>::almost_zero()));
+        return detail::rigid_matrix_inverse<T, S>()(m);
+    }
+
     /**
      * Returns a scaling matrix with the given scaling factors.
      *
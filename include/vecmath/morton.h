@@ -0,0 +1,123 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "scalar.h"
+
+#include <cstdint>
+
+namespace vm {
+    namespace detail {
+        /**
+         * Returns the number of leading zero bits of the given non zero value.
+         */
+        constexpr unsigned count_leading_zeros(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_clzll(x));
+#else
+            unsigned result = 0u;
+            for (unsigned shift = 32u; shift > 0u; shift /= 2u) {
+                if ((x >> (64u - shift)) == 0u) {
+                    result += shift;
+                    x <<= shift;
+                }
+            }
+            return result;
+#endif
+        }
+
+        /**
+         * Inserts two zero bits before each of the lower 10 bits of the given value.
+         */
+        constexpr std::uint32_t spread_bits_10(std::uint32_t x) {
+            x &= 0x000003FFu;
+            x = (x | (x << 16u)) & 0x030000FFu;
+            x = (x | (x <<  8u)) & 0x0300F00Fu;
+            x = (x | (x <<  4u)) & 0x030C30C3u;
+            x = (x | (x <<  2u)) & 0x09249249u;
+            return x;
+        }
+
+        /**
+         * Inserts two zero bits before each of the lower 21 bits of the given value.
+         */
+        constexpr std::uint64_t spread_bits_21(std::uint64_t x) {
+            x &= 0x00000000001FFFFFu;
+            x = (x | (x << 32u)) & 0x001F00000000FFFFu;
+            x = (x | (x << 16u)) & 0x001F0000FF0000FFu;
+            x = (x | (x <<  8u)) & 0x100F00F00F00F00Fu;
+            x = (x | (x <<  4u)) & 0x10C30C30C30C30C3u;
+            x = (x | (x <<  2u)) & 0x1249249249249249u;
+            return x;
+        }
+
+        /**
+         * Maps the given value from [min, max] to an integer in [0, 2^bits - 1]. Values outside of the interval are
+         * clamped, and a degenerate interval maps everything to 0.
+         */
+        template <typename T>
+        constexpr std::uint64_t quantize(const T v, const T min, const T max, const unsigned bits) {
+            const auto cells = static_cast<T>(std::uint64_t(1u) << bits);
+            const auto extent = max - min;
+            const auto t = extent > T(0.0) ? clamp((v - min) / extent) : T(0.0);
+            const auto q = static_cast<std::uint64_t>(t * cells);
+            return q < (std::uint64_t(1u) << bits) ? q : (std::uint64_t(1u) << bits) - 1u;
+        }
+    }
+
+    /**
+     * Computes the 30 bit Morton code of the given point. The point is normalized to the given bounds and each of
+     * its components is quantized to 10 bits. The bits of the components are then interleaved, with the bits of the
+     * x component in the most significant position of each triple. Sorting points by their Morton codes orders them
+     * along a Z-order curve, so points that are close in the order are also close in space.
+     *
+     * Points outside of the given bounds are clamped to them.
+     *
+     * @tparam T the component type
+     * @param p the point
+     * @param bounds the bounds used to normalize the point
+     * @return the Morton code
+     */
+    template <typename T>
+    constexpr std::uint32_t morton_code_30(const vec<T,3>& p, const bbox<T,3>& bounds) {
+        const auto x = static_cast<std::uint32_t>(detail::quantize(p[0], bounds.min[0], bounds.max[0], 10u));
+        const auto y = static_cast<std::uint32_t>(detail::quantize(p[1], bounds.min[1], bounds.max[1], 10u));
+        const auto z = static_cast<std::uint32_t>(detail::quantize(p[2], bounds.min[2], bounds.max[2], 10u));
+        return (detail::spread_bits_10(x) << 2u) | (detail::spread_bits_10(y) << 1u) | detail::spread_bits_10(z);
+    }
+
+    /**
+     * Computes the 63 bit Morton code of the given point. This works like morton_code_30, but each component is
+     * quantized to 21 bits, which keeps points apart that are too close to be separated by a 30 bit code.
+     *
+     * @tparam T the component type
+     * @param p the point
+     * @param bounds the bounds used to normalize the point
+     * @return the Morton code
+     */
+    template <typename T>
+    constexpr std::uint64_t morton_code_63(const vec<T,3>& p, const bbox<T,3>& bounds) {
+        const auto x = detail::quantize(p[0], bounds.min[0], bounds.max[0], 21u);
+        const auto y = detail::quantize(p[1], bounds.min[1], bounds.max[1], 21u);
+        const auto z = detail::quantize(p[2], bounds.min[2], bounds.max[2], 21u);
+        return (detail::spread_bits_21(x) << 2u) | (detail::spread_bits_21(y) << 1u) | detail::spread_bits_21(z);
+    }
+}
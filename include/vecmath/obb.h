@@ -0,0 +1,518 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+#include "affine.h"
+#include "bbox.h"
+#include "constants.h"
+#include "scalar.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace vm {
+    namespace detail {
+        /**
+         * Computes the eigenvectors of the given symmetric matrix using the cyclic Jacobi method, which repeatedly
+         * applies plane rotations that annihilate one off-diagonal element at a time until the matrix is diagonal.
+         * The method is robust for the small matrices that occur when fitting bounding volumes and yields orthonormal
+         * eigenvectors even for repeated eigenvalues.
+         *
+         * The eigenvectors are sorted by descending eigenvalue.
+         *
+         * @tparam T the component type
+         * @tparam S the number of rows and columns
+         * @param a the symmetric matrix
+         * @return a matrix whose columns are the normalized eigenvectors
+         */
+        template <typename T, std::size_t S>
+        mat<T,S,S> symmetric_eigenvectors(mat<T,S,S> a) {
+            // a[c][r] is the element in row r and column c; a is symmetric, so a[p][q] == a[q][p]
+            auto vectors = mat<T,S,S>::identity();
+
+            constexpr std::size_t max_sweeps = 50u;
+            for (std::size_t sweep = 0u; sweep < max_sweeps; ++sweep) {
+                bool diagonal = true;
+                for (std::size_t p = 0u; p + 1u < S; ++p) {
+                    for (std::size_t q = p + 1u; q < S; ++q) {
+                        const auto apq = a[q][p];
+                        if (std::abs(apq) <= std::numeric_limits<T>::min()) {
+                            continue;
+                        }
+                        diagonal = false;
+
+                        // compute the rotation J that zeroes a[q][p] in J^T * A * J
+                        const auto theta = (a[q][q] - a[p][p]) / (static_cast<T>(2.0) * apq);
+                        auto t = static_cast<T>(1.0) / (std::abs(theta) + std::sqrt(theta * theta + static_cast<T>(1.0)));
+                        if (theta < static_cast<T>(0.0)) {
+                            t = -t;
+                        }
+                        const auto c = static_cast<T>(1.0) / std::sqrt(t * t + static_cast<T>(1.0));
+                        const auto s = t * c;
+
+                        for (std::size_t k = 0u; k < S; ++k) {
+                            // A * J, columns p and q
+                            const auto akp = a[p][k];
+                            const auto akq = a[q][k];
+                            a[p][k] = c * akp - s * akq;
+                            a[q][k] = s * akp + c * akq;
+                        }
+                        for (std::size_t k = 0u; k < S; ++k) {
+                            // J^T * (A * J), rows p and q
+                            const auto apk = a[k][p];
+                            const auto aqk = a[k][q];
+                            a[k][p] = c * apk - s * aqk;
+                            a[k][q] = s * apk + c * aqk;
+                        }
+                        a[q][p] = a[p][q] = static_cast<T>(0.0);
+
+                        for (std::size_t k = 0u; k < S; ++k) {
+                            const auto vkp = vectors[p][k];
+                            const auto vkq = vectors[q][k];
+                            vectors[p][k] = c * vkp - s * vkq;
+                            vectors[q][k] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+                if (diagonal) {
+                    break;
+                }
+            }
+
+            // selection sort by descending eigenvalue, S is tiny
+            for (std::size_t i = 0u; i + 1u < S; ++i) {
+                auto largest = i;
+                for (std::size_t j = i + 1u; j < S; ++j) {
+                    if (a[j][j] > a[largest][largest]) {
+                        largest = j;
+                    }
+                }
+                if (largest != i) {
+                    std::swap(a[i][i], a[largest][largest]);
+                    std::swap(vectors[i], vectors[largest]);
+                }
+            }
+            return vectors;
+        }
+    }
+
+    /**
+     * An oriented bounding box, represented by its center, an orthonormal orientation and its half extents along the
+     * axes of the orientation. The columns of the orientation matrix are the axes of the box, so a point p is
+     * contained in the box if |dot(p - center, orientation[i])| <= half_extents[i] for every axis i.
+     *
+     * Unlike a bbox, whose bounds grow when it is rotated, an oriented bounding box can be transformed by a rigid
+     * transformation without any loss of tightness. This makes it a better fit for rotated objects, at the cost of a
+     * more expensive overlap test.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     */
+    template <typename T, std::size_t S>
+    class obb {
+    public:
+        vec<T,S> center;
+        mat<T,S,S> orientation;
+        vec<T,S> half_extents;
+
+        /**
+         * Creates a new oriented bounding box at the origin with identity orientation and half extents set to 0.
+         */
+        constexpr obb() :
+        center(vec<T,S>::zero()),
+        orientation(mat<T,S,S>::identity()),
+        half_extents(vec<T,S>::zero()) {}
+
+        /**
+         * Creates a new oriented bounding box with the given center, orientation and half extents. The columns of the
+         * given orientation must be orthonormal, and the half extents must not be negative.
+         *
+         * @param i_center the center
+         * @param i_orientation the orientation, whose columns are the axes of the box
+         * @param i_halfExtents the half extents along the axes of the box
+         */
+        constexpr obb(const vec<T,S>& i_center, const mat<T,S,S>& i_orientation, const vec<T,S>& i_halfExtents) :
+        center(i_center),
+        orientation(i_orientation),
+        half_extents(i_halfExtents) {}
+
+        /**
+         * Creates a new oriented bounding box that covers the same volume as the given bounding box.
+         *
+         * @param bounds the bounding box
+         */
+        constexpr explicit obb(const bbox<T,S>& bounds) :
+        center(bounds.center()),
+        orientation(mat<T,S,S>::identity()),
+        half_extents(bounds.size() / static_cast<T>(2.0)) {}
+
+        /**
+         * Creates a new oriented bounding box that contains the given bounding box after applying the given affine
+         * transformation to it. See transform.
+         *
+         * @param bounds the bounding box
+         * @param transform the affine transformation
+         */
+        obb(const bbox<T,S>& bounds, const mat<T,S+1,S+1>& transform) :
+        obb(obb(bounds).transform(transform)) {}
+
+        /**
+         * Creates a new oriented bounding box that contains the given bounding box after applying the given affine
+         * transformation to it. See transform.
+         *
+         * @param bounds the bounding box
+         * @param transform the affine transformation
+         */
+        obb(const bbox<T,S>& bounds, const affine<T,S>& transform) :
+        obb(obb(bounds).transform(transform)) {}
+
+        /**
+         * Fits an oriented bounding box to the points in the given range using principal component analysis. The axes
+         * of the box are the eigenvectors of the covariance matrix of the points, which are the directions in which
+         * the points vary the most, and the extents are the smallest extents along these axes that contain all points.
+         * Optionally accepts a transformation that is applied to each element of the range. The given range must not
+         * be empty, and it is traversed three times.
+         *
+         * The fit takes linear time, but the result is not the smallest enclosing box. Since the covariance depends on
+         * the distribution of the points and not only on their convex hull, densely sampled regions pull the axes
+         * towards them. Fitting the vertices of a convex hull rather than of an arbitrary mesh gives better results.
+         *
+         * In three dimensions, the returned orientation is a rotation, i.e., its axes form a right handed system.
+         *
+         * @tparam I the range iterator type
+         * @tparam G type of the transformation
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param get the transformation
+         * @return the oriented bounding box
+         */
+        template <typename I, typename G = identity>
+        static obb<T,S> fit(I cur, I end, const G& get = G()) {
+            assert(cur != end);
+
+            auto mean = vec<T,S>::zero();
+            std::size_t count = 0u;
+            for (auto it = cur; it != end; ++it) {
+                mean = mean + vec<T,S>(get(*it));
+                ++count;
+            }
+            mean = mean / static_cast<T>(count);
+
+            auto covariance = mat<T,S,S>::zero();
+            for (auto it = cur; it != end; ++it) {
+                const auto d = vec<T,S>(get(*it)) - mean;
+                for (std::size_t c = 0u; c < S; ++c) {
+                    for (std::size_t r = c; r < S; ++r) {
+                        covariance[c][r] += d[r] * d[c];
+                    }
+                }
+            }
+            for (std::size_t c = 0u; c < S; ++c) {
+                for (std::size_t r = c + 1u; r < S; ++r) {
+                    covariance[r][c] = covariance[c][r];
+                }
+            }
+
+            auto axes = detail::symmetric_eigenvectors(covariance);
+            if constexpr (S == 3u) {
+                axes[2] = cross(axes[0], axes[1]);
+            }
+
+            // project the points relative to the mean to avoid losing precision for far away point sets
+            auto min = vec<T,S>::fill(std::numeric_limits<T>::max());
+            auto max = vec<T,S>::fill(std::numeric_limits<T>::lowest());
+            for (auto it = cur; it != end; ++it) {
+                const auto d = vec<T,S>(get(*it)) - mean;
+                for (std::size_t i = 0u; i < S; ++i) {
+                    const auto projected = dot(d, axes[i]);
+                    min[i] = projected < min[i] ? projected : min[i];
+                    max[i] = projected > max[i] ? projected : max[i];
+                }
+            }
+
+            auto center = mean;
+            for (std::size_t i = 0u; i < S; ++i) {
+                center = center + axes[i] * ((min[i] + max[i]) / static_cast<T>(2.0));
+            }
+            return obb<T,S>(center, axes, (max - min) / static_cast<T>(2.0));
+        }
+
+        /**
+         * Returns the smallest axis aligned bounding box that contains this oriented bounding box.
+         *
+         * @return the bounding box
+         */
+        constexpr bbox<T,S> bounds() const {
+            vec<T,S> extents;
+            for (std::size_t r = 0u; r < S; ++r) {
+                extents[r] = static_cast<T>(0.0);
+                for (std::size_t i = 0u; i < S; ++i) {
+                    extents[r] += abs(orientation[i][r]) * half_extents[i];
+                }
+            }
+            return bbox<T,S>(center - extents, center + extents);
+        }
+
+        /**
+         * Returns the volume of this oriented bounding box.
+         *
+         * @return the volume
+         */
+        constexpr T volume() const {
+            auto result = static_cast<T>(1.0);
+            for (std::size_t i = 0u; i < S; ++i) {
+                result *= static_cast<T>(2.0) * half_extents[i];
+            }
+            return result;
+        }
+
+        /**
+         * Transforms the given point into the local coordinate system of this oriented bounding box, whose origin is
+         * the center of the box and whose axes are the axes of the box.
+         *
+         * @param point the point to transform
+         * @return the transformed point
+         */
+        constexpr vec<T,S> to_local(const vec<T,S>& point) const {
+            const auto d = point - center;
+            vec<T,S> result;
+            for (std::size_t i = 0u; i < S; ++i) {
+                result[i] = dot(d, orientation[i]);
+            }
+            return result;
+        }
+
+        /**
+         * Checks whether the given point is contained in this oriented bounding box. Points on the boundary are
+         * contained.
+         *
+         * @param point the point to check
+         * @return true if the given point is contained in this oriented bounding box and false otherwise
+         */
+        constexpr bool contains(const vec<T,S>& point) const {
+            const auto local = to_local(point);
+            for (std::size_t i = 0u; i < S; ++i) {
+                if (abs(local[i]) > half_extents[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Checks whether this oriented bounding box and the given oriented bounding box overlap. Uses the separating
+         * axis test given by Ericson, "Real-Time Collision Detection", section 4.4.1, which tests the 3 axes of
+         * either box and the 9 cross products of an axis of this box with an axis of the other box.
+         *
+         * If two edges are nearly parallel, their cross product is almost zero and the projections onto it consist
+         * only of rounding errors. To prevent such an axis from separating overlapping boxes, the absolute values of
+         * the rotation between the boxes are enlarged by a small epsilon. Consequently, boxes that are separated by a
+         * very small gap relative to their extents may be reported as overlapping.
+         *
+         * @param other the other oriented bounding box
+         * @return true if the boxes overlap and false otherwise
+         */
+        constexpr bool intersects(const obb<T,S>& other) const {
+            static_assert(S == 3u, "separating axis test is only implemented for three dimensions");
+
+            const auto& a = *this;
+            const auto& b = other;
+            const auto& ea = a.half_extents;
+            const auto& eb = b.half_extents;
+
+            // translation between the centers expressed in the frame of a
+            const auto t = a.to_local(b.center);
+
+            // rotation of b expressed in the frame of a, R[i][j] = dot(a_i, b_j), computed one row per axis of a so
+            // that boxes which are separated by an axis of a, which is the common case, need only part of it
+            T R[3][3] {};
+            T absR[3][3] {};
+
+            // axes of a
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                for (std::size_t j = 0u; j < 3u; ++j) {
+                    R[i][j] = dot(a.orientation[i], b.orientation[j]);
+                    absR[i][j] = abs(R[i][j]) + constants<T>::colinear_epsilon();
+                }
+
+                const auto ra = ea[i];
+                const auto rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+                if (abs(t[i]) > ra + rb) {
+                    return false;
+                }
+            }
+
+            // axes of b
+            for (std::size_t j = 0u; j < 3u; ++j) {
+                const auto ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+                const auto rb = eb[j];
+                if (abs(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) > ra + rb) {
+                    return false;
+                }
+            }
+
+            // cross products a_i x b_j; with i1, i2 and j1, j2 being the other two axes in cyclic order
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                const auto i1 = (i + 1u) % 3u;
+                const auto i2 = (i + 2u) % 3u;
+                for (std::size_t j = 0u; j < 3u; ++j) {
+                    const auto j1 = (j + 1u) % 3u;
+                    const auto j2 = (j + 2u) % 3u;
+                    const auto ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+                    const auto rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+                    if (abs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * Transforms this oriented bounding box by applying the given affine transformation. See the overload that
+         * accepts an affine transformation.
+         *
+         * @param transform the transformation, which must be affine
+         * @return the transformed oriented bounding box
+         */
+        obb<T,S> transform(const mat<T,S+1,S+1>& transform) const {
+            assert(is_affine(transform));
+            return transform_affine(transform);
+        }
+
+        /**
+         * Transforms this oriented bounding box by applying the given affine transformation. If the linear part of the
+         * transformation consists only of rotations, reflections and scaling along the axes of this box, the result
+         * contains exactly the transformed box. Otherwise, i.e., if the transformation shears the box, the result is
+         * the box that contains the transformed box and whose axes are obtained by orthonormalizing the transformed
+         * axes of this box.
+         *
+         * @param transform the transformation
+         * @return the transformed oriented bounding box
+         */
+        obb<T,S> transform(const affine<T,S>& transform) const {
+            return transform_affine(transform);
+        }
+    private:
+        /**
+         * Transforms this box. The axes of the transformed box are computed from the transformed axes of this box
+         * using Gram-Schmidt orthonormalization. If a transformed axis degenerates because the transformation
+         * collapses it, a coordinate axis that is independent of the previous axes is used instead.
+         *
+         * @tparam M the type of the transformation, which must provide its columns via operator[]
+         * @param transform the transformation, where column S is the translation
+         * @return the transformed oriented bounding box
+         */
+        template <typename M>
+        obb<T,S> transform_affine(const M& transform) const {
+            const auto apply_linear = [&](const vec<T,S>& v) {
+                vec<T,S> result;
+                for (std::size_t r = 0u; r < S; ++r) {
+                    result[r] = static_cast<T>(0.0);
+                    for (std::size_t c = 0u; c < S; ++c) {
+                        result[r] += transform[c][r] * v[c];
+                    }
+                }
+                return result;
+            };
+
+            vec<T,S> transformedAxes[S];
+            for (std::size_t i = 0u; i < S; ++i) {
+                transformedAxes[i] = apply_linear(orientation[i]);
+            }
+
+            obb<T,S> result;
+            result.center = apply_linear(center);
+            for (std::size_t r = 0u; r < S; ++r) {
+                result.center[r] += transform[S][r];
+            }
+
+            for (std::size_t i = 0u; i < S; ++i) {
+                const auto orthogonalize = [&](vec<T,S> v) {
+                    for (std::size_t k = 0u; k < i; ++k) {
+                        v = v - result.orientation[k] * dot(v, result.orientation[k]);
+                    }
+                    return v;
+                };
+
+                auto axis = orthogonalize(transformedAxes[i]);
+                auto axisLength2 = squared_length(axis);
+                if (axisLength2 == static_cast<T>(0.0) || axisLength2 <= constants<T>::colinear_epsilon() * squared_length(transformedAxes[i])) {
+                    // the transformation collapses this axis, use the coordinate axis that is least aligned with the previous axes
+                    axisLength2 = static_cast<T>(0.0);
+                    for (std::size_t k = 0u; k < S; ++k) {
+                        const auto candidate = orthogonalize(vec<T,S>::axis(k));
+                        const auto candidateLength2 = squared_length(candidate);
+                        if (candidateLength2 > axisLength2) {
+                            axis = candidate;
+                            axisLength2 = candidateLength2;
+                        }
+                    }
+                }
+                result.orientation[i] = axis / std::sqrt(axisLength2);
+            }
+            if constexpr (S == 3u) {
+                // flips the last axis if the transformation is a reflection
+                result.orientation[2] = cross(result.orientation[0], result.orientation[1]);
+            }
+
+            for (std::size_t k = 0u; k < S; ++k) {
+                result.half_extents[k] = static_cast<T>(0.0);
+                for (std::size_t i = 0u; i < S; ++i) {
+                    result.half_extents[k] += abs(dot(result.orientation[k], transformedAxes[i])) * half_extents[i];
+                }
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Checks whether the two given oriented bounding boxes are identical.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first oriented bounding box
+     * @param rhs the second oriented bounding box
+     * @return true if the oriented bounding boxes are identical and false otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool operator==(const obb<T,S>& lhs, const obb<T,S>& rhs) {
+        return lhs.center == rhs.center && lhs.orientation == rhs.orientation && lhs.half_extents == rhs.half_extents;
+    }
+
+    /**
+     * Checks whether the two given oriented bounding boxes are not identical.
+     *
+     * @tparam T the component type
+     * @tparam S the number of dimensions
+     * @param lhs the first oriented bounding box
+     * @param rhs the second oriented bounding box
+     * @return false if the oriented bounding boxes are identical and true otherwise
+     */
+    template <typename T, std::size_t S>
+    constexpr bool operator!=(const obb<T,S>& lhs, const obb<T,S>& rhs) {
+        return !(lhs == rhs);
+    }
+}
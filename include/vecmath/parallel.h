@@ -0,0 +1,461 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "simd.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Parallel variants of reductions over large ranges of points and a parallel radix sort. The range is split into
+ * blocks of a fixed size, the blocks are distributed over a number of threads, and the per block results are combined
+ * in block order. Since the blocks do not depend on the number of threads, the results do not depend on it either.
+ *
+ * Ranges of tightly packed vectors given by pointers are processed using SIMD instructions within each block.
+ */
+
+namespace vm {
+    /**
+     * Returns the number of threads that the parallel algorithms use if no thread count is given, which is the number
+     * of concurrent threads supported by the hardware, or 1 if that number is unknown.
+     */
+    inline std::size_t default_thread_count() {
+        const auto count = std::thread::hardware_concurrency();
+        return count > 0u ? static_cast<std::size_t>(count) : 1u;
+    }
+
+    namespace detail {
+        /**
+         * The number of elements in each block processed by a single thread.
+         */
+        constexpr std::size_t parallel_block_size = 65536u;
+
+        /**
+         * Splits [0, count) into blocks of parallel_block_size elements and calls f(begin, end) for each block on up
+         * to the given number of threads, including the calling thread. If f throws, the remaining blocks are skipped
+         * and the first exception is rethrown once all threads have finished.
+         */
+        template <typename F>
+        void parallel_for_blocks(const std::size_t count, std::size_t threadCount, const F& f) {
+            const auto blockCount = (count + parallel_block_size - 1u) / parallel_block_size;
+
+            if (threadCount == 0u) {
+                threadCount = default_thread_count();
+            }
+            threadCount = std::min(threadCount, blockCount);
+
+            std::atomic<std::size_t> next(0u);
+            std::exception_ptr error;
+            std::mutex errorMutex;
+
+            const auto work = [&]() {
+                try {
+                    for (auto block = next++; block < blockCount; block = next++) {
+                        const auto begin = block * parallel_block_size;
+                        const auto end = std::min(begin + parallel_block_size, count);
+                        f(begin, end);
+                    }
+                } catch (...) {
+                    next = blockCount;
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (std::size_t i = 1u; i < threadCount; ++i) {
+                try {
+                    threads.emplace_back(work);
+                } catch (const std::system_error&) {
+                    // the blocks are handed out dynamically, so the threads that did start process all of them
+                    break;
+                }
+            }
+
+            work();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        /**
+         * Calls f(begin, end) for each block like parallel_for_blocks and returns the results in block order. Each
+         * thread writes the results of its blocks to separate elements, so R must not be bool, whose vector
+         * specialization packs several elements into one word.
+         */
+        template <typename R, typename F>
+        std::vector<R> parallel_blocks(const std::size_t count, const std::size_t threadCount, const F& f) {
+            static_assert(!std::is_same<R, bool>::value, "use parallel_for_blocks for blocks without results");
+            std::vector<R> results((count + parallel_block_size - 1u) / parallel_block_size);
+            parallel_for_blocks(count, threadCount, [&](const std::size_t begin, const std::size_t end) {
+                results[begin / parallel_block_size] = f(begin, end);
+            });
+            return results;
+        }
+
+        /**
+         * Computes the bounds of the given non empty block of points.
+         */
+        template <typename T, std::size_t S>
+        bbox<T,S> bounds_block(const vec<T,S>* points, const std::size_t count) {
+            static_assert(sizeof(vec<T,S>) == S * sizeof(T), "vectors must be tightly packed");
+            using pack = detail::pack<T>;
+            assert(count > 0u);
+
+            auto lo = points[0];
+            auto hi = points[0];
+
+            std::size_t i = 0u;
+            if (count >= pack::width) {
+                pack packMin[S];
+                load_interleaved(points[0].v, packMin);
+                pack packMax[S];
+                for (std::size_t c = 0u; c < S; ++c) {
+                    packMax[c] = packMin[c];
+                }
+
+                for (i = pack::width; i + pack::width <= count; i += pack::width) {
+                    pack p[S];
+                    load_interleaved(points[i].v, p);
+                    for (std::size_t c = 0u; c < S; ++c) {
+                        packMin[c] = min(packMin[c], p[c]);
+                        packMax[c] = max(packMax[c], p[c]);
+                    }
+                }
+
+                for (std::size_t c = 0u; c < S; ++c) {
+                    T mins[pack::width];
+                    T maxs[pack::width];
+                    packMin[c].store(mins);
+                    packMax[c].store(maxs);
+                    for (std::size_t l = 0u; l < pack::width; ++l) {
+                        lo[c] = std::min(lo[c], mins[l]);
+                        hi[c] = std::max(hi[c], maxs[l]);
+                    }
+                }
+            }
+
+            for (; i < count; ++i) {
+                lo = min(lo, points[i]);
+                hi = max(hi, points[i]);
+            }
+            return bbox<T,S>(lo, hi);
+        }
+
+        /**
+         * Computes the sum of the given block of points.
+         */
+        template <typename T, std::size_t S>
+        vec<T,S> sum_block(const vec<T,S>* points, const std::size_t count) {
+            static_assert(sizeof(vec<T,S>) == S * sizeof(T), "vectors must be tightly packed");
+            using pack = detail::pack<T>;
+
+            pack sums[S];
+            for (std::size_t c = 0u; c < S; ++c) {
+                sums[c] = pack::broadcast(T(0.0));
+            }
+
+            std::size_t i = 0u;
+            for (; i + pack::width <= count; i += pack::width) {
+                pack p[S];
+                load_interleaved(points[i].v, p);
+                for (std::size_t c = 0u; c < S; ++c) {
+                    sums[c] = sums[c] + p[c];
+                }
+            }
+
+            vec<T,S> result;
+            for (std::size_t c = 0u; c < S; ++c) {
+                T values[pack::width];
+                sums[c].store(values);
+                for (std::size_t l = 0u; l < pack::width; ++l) {
+                    result[c] += values[l];
+                }
+            }
+
+            for (; i < count; ++i) {
+                result = result + points[i];
+            }
+            return result;
+        }
+
+        template <typename I, typename G>
+        using parallel_value_type = typename std::remove_cv<typename std::remove_reference<decltype(std::declval<const G&>()(*std::declval<I>()))>::type>::type;
+
+        /**
+         * Checks whether a range given by iterators of type I and a function of type G can be passed to the pointer
+         * based overloads.
+         */
+        template <typename I, typename G>
+        constexpr bool is_packed_vec_range =
+            std::is_pointer<I>::value &&
+            std::is_same<G, identity>::value &&
+            std::is_same<typename std::remove_cv<typename std::remove_pointer<I>::type>::type, parallel_value_type<I, G>>::value;
+
+        template <typename I>
+        constexpr void assert_random_access() {
+            static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<I>::iterator_category>::value,
+                          "parallel algorithms require random access iterators");
+        }
+    }
+
+    /**
+     * Computes the smallest bounding box that contains all of the given points in parallel. The result is identical
+     * to the result of bbox<T,S>::merge_all.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param points the points
+     * @param count the number of points, must not be 0
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     * @return the bounding box
+     */
+    template <typename T, std::size_t S>
+    bbox<T,S> parallel_merge_all(const vec<T,S>* points, const std::size_t count, const std::size_t threadCount = 0u) {
+        assert(count > 0u);
+        const auto blocks = detail::parallel_blocks<bbox<T,S>>(count, threadCount, [&](const std::size_t begin, const std::size_t end) {
+            return detail::bounds_block(points + begin, end - begin);
+        });
+
+        auto result = blocks.front();
+        for (std::size_t i = 1u; i < blocks.size(); ++i) {
+            result = merge(result, blocks[i]);
+        }
+        return result;
+    }
+
+    /**
+     * Computes the smallest bounding box that contains all points in the given range in parallel. Optionally accepts
+     * a transformation that is applied to each element of the range, which must be safe to call from several threads
+     * at once. The result is identical to the result of bbox<T,S>::merge_all.
+     *
+     * If the range is given by pointers to vectors and no transformation is given, the pointer based overload is used.
+     *
+     * @tparam I the range iterator type, must be a random access iterator
+     * @tparam G type of the transformation
+     * @param cur the start of the range
+     * @param end the end of the range, the range must not be empty
+     * @param get the transformation
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     * @return the bounding box
+     */
+    template <typename I, typename G = identity>
+    auto parallel_merge_all(I cur, I end, const G& get = G(), const std::size_t threadCount = 0u) {
+        using V = detail::parallel_value_type<I, G>;
+        using B = bbox<typename V::type, V::size>;
+        detail::assert_random_access<I>();
+        assert(cur != end);
+
+        const auto count = static_cast<std::size_t>(end - cur);
+        if constexpr (detail::is_packed_vec_range<I, G>) {
+            return parallel_merge_all(&*cur, count, threadCount);
+        } else {
+            const auto blocks = detail::parallel_blocks<B>(count, threadCount, [&](const std::size_t begin, const std::size_t blockEnd) {
+                using D = typename std::iterator_traits<I>::difference_type;
+                return B::merge_all(cur + static_cast<D>(begin), cur + static_cast<D>(blockEnd), get);
+            });
+
+            auto result = blocks.front();
+            for (std::size_t i = 1u; i < blocks.size(); ++i) {
+                result = merge(result, blocks[i]);
+            }
+            return result;
+        }
+    }
+
+    /**
+     * Adds the points in the given range to the given bounding box builder, computing their bounds in parallel. See
+     * parallel_merge_all for details.
+     *
+     * @tparam B the type of the builder
+     * @tparam I the range iterator type, must be a random access iterator
+     * @tparam G type of the transformation
+     * @param builder the builder
+     * @param cur the start of the range
+     * @param end the end of the range
+     * @param get the transformation
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     */
+    template <typename B, typename I, typename G = identity>
+    void parallel_add(B& builder, I cur, I end, const G& get = G(), const std::size_t threadCount = 0u) {
+        if (cur != end) {
+            builder.add(parallel_merge_all(cur, end, get, threadCount));
+        }
+    }
+
+    /**
+     * Computes the average of the given points in parallel. The sum is computed in a different order than in vm::average,
+     * so the result may differ slightly, but it does not depend on the number of threads.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param points the points
+     * @param count the number of points, must not be 0
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     * @return the average of the given points
+     */
+    template <typename T, std::size_t S>
+    vec<T,S> parallel_average(const vec<T,S>* points, const std::size_t count, const std::size_t threadCount = 0u) {
+        assert(count > 0u);
+        const auto blocks = detail::parallel_blocks<vec<T,S>>(count, threadCount, [&](const std::size_t begin, const std::size_t end) {
+            return detail::sum_block(points + begin, end - begin);
+        });
+
+        vec<T,S> sum;
+        for (const auto& block : blocks) {
+            sum = sum + block;
+        }
+        return sum / static_cast<T>(count);
+    }
+
+    /**
+     * Computes the average of the given range of elements in parallel, using the given function to transform an element
+     * into a vector, which must be safe to call from several threads at once. See the pointer based overload for
+     * details.
+     *
+     * @tparam I the range iterator type, must be a random access iterator
+     * @tparam G the type of the transformation function from a range element to a vector type
+     * @param cur the start of the range
+     * @param end the end of the range, the range must not be empty
+     * @param get the transformation function, defaults to identity
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     * @return the average of the vectors obtained from the given range of elements
+     */
+    template <typename I, typename G = identity>
+    auto parallel_average(I cur, I end, const G& get = G(), const std::size_t threadCount = 0u) {
+        using V = detail::parallel_value_type<I, G>;
+        using T = typename V::type;
+        detail::assert_random_access<I>();
+        assert(cur != end);
+
+        const auto count = static_cast<std::size_t>(end - cur);
+        if constexpr (detail::is_packed_vec_range<I, G>) {
+            return parallel_average(&*cur, count, threadCount);
+        } else {
+            const auto blocks = detail::parallel_blocks<V>(count, threadCount, [&](const std::size_t begin, const std::size_t blockEnd) {
+                using D = typename std::iterator_traits<I>::difference_type;
+                V sum;
+                for (auto i = cur + static_cast<D>(begin); i != cur + static_cast<D>(blockEnd); ++i) {
+                    sum = sum + get(*i);
+                }
+                return sum;
+            });
+
+            V sum;
+            for (const auto& block : blocks) {
+                sum = sum + block;
+            }
+            return sum / static_cast<T>(count);
+        }
+    }
+
+    /**
+     * Sorts the given keys in ascending order in parallel and applies the same permutation to the given values. The
+     * sort is a least significant digit radix sort with 8 bit digits, so it is stable, and its result does not depend
+     * on the number of threads. Passes over digits that are equal for all keys are skipped.
+     *
+     * @tparam K the key type, must be an unsigned integer type
+     * @tparam V the value type
+     * @param keys the keys to sort
+     * @param values the values to permute along with the keys
+     * @param count the number of keys and values
+     * @param threadCount the maximum number of threads to use, or 0 to use default_thread_count()
+     */
+    template <typename K, typename V>
+    void parallel_radix_sort(K* keys, V* values, const std::size_t count, const std::size_t threadCount = 0u) {
+        static_assert(std::is_unsigned_v<K>, "key type must be an unsigned integer type");
+        using histogram = std::array<std::size_t, 256u>;
+
+        std::vector<K> keyBuffer(count);
+        std::vector<V> valueBuffer(count);
+        auto* srcKeys = keys;
+        auto* srcValues = values;
+        auto* dstKeys = keyBuffer.data();
+        auto* dstValues = valueBuffer.data();
+
+        for (std::size_t shift = 0u; shift < static_cast<std::size_t>(std::numeric_limits<K>::digits); shift += 8u) {
+            const auto digit = [&](const K key) {
+                return static_cast<std::size_t>((key >> shift) & K(0xFF));
+            };
+
+            auto offsets = detail::parallel_blocks<histogram>(count, threadCount, [&](const std::size_t begin, const std::size_t end) {
+                histogram counts = {};
+                for (std::size_t i = begin; i < end; ++i) {
+                    ++counts[digit(srcKeys[i])];
+                }
+                return counts;
+            });
+
+            // turn the per block counts into the position of the first key of each digit in each block
+            std::size_t position = 0u;
+            bool skip = false;
+            for (std::size_t d = 0u; d < 256u && !skip; ++d) {
+                const auto first = position;
+                for (auto& blockOffsets : offsets) {
+                    const auto blockCount = blockOffsets[d];
+                    blockOffsets[d] = position;
+                    position += blockCount;
+                }
+                skip = position - first == count;
+            }
+            if (skip) {
+                continue;
+            }
+
+            detail::parallel_for_blocks(count, threadCount, [&](const std::size_t begin, const std::size_t end) {
+                auto& blockOffsets = offsets[begin / detail::parallel_block_size];
+                for (std::size_t i = begin; i < end; ++i) {
+                    const auto j = blockOffsets[digit(srcKeys[i])]++;
+                    dstKeys[j] = srcKeys[i];
+                    dstValues[j] = std::move(srcValues[i]);
+                }
+            });
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcValues, dstValues);
+        }
+
+        if (srcKeys != keys) {
+            std::copy(srcKeys, srcKeys + count, keys);
+            std::move(srcValues, srcValues + count, values);
+        }
+    }
+}
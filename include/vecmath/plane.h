@@ -20,6 +20,7 @@
 
 #include "vec.h"
 #include "mat.h"
+#include "affine.h"
 #include "scalar.h"
 #include "util.h"
 #include "constants.h"
@@ -185,6 +186,17 @@ namespace vm {
             return plane<T,S>(transform * anchor(), normalize(strip_translation(transform) * normal));
         }
 
+        /**
+         * Transforms this plane using the given affine transformation. The translational part is not applied to the
+         * normal.
+         *
+         * @param transform the transformation to apply
+         * @return the transformed plane
+         */
+        plane<T,S> transform(const affine<T,S>& transform) const {
+            return plane<T,S>(transform_point(transform, anchor()), normalize(transform_vector(transform, normal)));
+        }
+
         /**
          * Transforms this plane using the given transformation matrix at compile time. The translational part is not
          * applied to the normal.
@@ -22,6 +22,7 @@
 #include <vecmath/vec_ext.h>
 #include <vecmath/mat.h>
 #include <vecmath/mat_ext.h>
+#include <vecmath/affine.h>
 
 #include <algorithm>
 #include <cstddef>
@@ -220,6 +221,21 @@ namespace vm {
             return polygon<T,S>(mat * vertices());
         }
 
+        /**
+         * Transforms this polygon using the given affine transformation.
+         *
+         * @param transform the transformation to apply
+         * @return the transformed polygon
+         */
+        polygon<T,S> transform(const affine<T,S>& transform) const {
+            std::vector<vec<T,S>> vertices;
+            vertices.reserve(m_vertices.size());
+            for (const auto& vertex : m_vertices) {
+                vertices.push_back(transform_point(transform, vertex));
+            }
+            return polygon<T,S>(std::move(vertices));
+        }
+
         // FIXME: this is only here because TB's VertexToolBase needs it, it should be moved elsewhere
         /**
          * Adds the vertices of the given range of polygons to the given output iterator.
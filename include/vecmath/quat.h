@@ -20,8 +20,13 @@
 
 #include "vec.h"
 #include "scalar.h"
+#include "simd.h"
+#include "constants.h"
 
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
 
 namespace vm {
     template <typename T>
@@ -276,7 +281,11 @@ namespace vm {
     }
 
     /**
-     * Applies the given quaternion to the given vector, in effect rotating it.
+     * Applies the given quaternion to the given vector, in effect rotating it. The quaternion is expected to be
+     * normalized.
+     *
+     * Instead of computing the quaternion product q * (0, v) * q', this uses the equivalent form v + r * t + q.v x t
+     * with t = 2 * (q.v x v), which needs about half as many operations.
      *
      * @tparam T the component type
      * @param lhs the quaternion
@@ -285,7 +294,314 @@ namespace vm {
      */
     template <typename T>
     constexpr vec<T,3> operator*(const quat<T>& lhs, const vec<T,3>& rhs) {
-        return (lhs * quat<T>(T(0.0), rhs) * lhs.conjugate()).v;
+        const auto t = T(2.0) * cross(lhs.v, rhs);
+        return rhs + lhs.r * t + cross(lhs.v, t);
+    }
+
+    /**
+     * Rotates the given vectors by the given quaternion and writes the results to the given destination. Each result
+     * is computed with the same operations as the product of the quaternion and the corresponding vector, but the
+     * vectors are rotated in blocks using SIMD instructions if available. The results may differ from the product by a
+     * few units in the last place if the compiler contracts either implementation into fused multiply-add
+     * instructions. No memory is allocated.
+     *
+     * @tparam T the component type
+     * @param q the quaternion, expected to be normalized
+     * @param vectors the vectors to rotate
+     * @param count the number of vectors
+     * @param out the destination, must have room for the given number of vectors and may be identical to vectors
+     */
+    template <typename T>
+    void rotate(const quat<T>& q, const vec<T,3>* vectors, const std::size_t count, vec<T,3>* out) {
+        static_assert(sizeof(vec<T,3>) == 3u * sizeof(T), "vectors must be tightly packed");
+        using pack = detail::pack<T>;
+
+        const auto r = pack::broadcast(q.r);
+        const auto ux = pack::broadcast(q.v[0]);
+        const auto uy = pack::broadcast(q.v[1]);
+        const auto uz = pack::broadcast(q.v[2]);
+        const auto two = pack::broadcast(T(2.0));
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            pack v[3];
+            detail::load_interleaved(vectors[i].v, v);
+
+            // same operations in the same order as operator*
+            const auto tx = two * (uy * v[2] - uz * v[1]);
+            const auto ty = two * (uz * v[0] - ux * v[2]);
+            const auto tz = two * (ux * v[1] - uy * v[0]);
+
+            const pack result[3] = {
+                v[0] + r * tx + (uy * tz - uz * ty),
+                v[1] + r * ty + (uz * tx - ux * tz),
+                v[2] + r * tz + (ux * ty - uy * tx)
+            };
+            detail::store_interleaved(result, out[i].v);
+        }
+
+        for (; i < count; ++i) {
+            out[i] = q * vectors[i];
+        }
+    }
+
+    /**
+     * Rotates the given vectors in place by the given quaternion. See the overload with a destination for details.
+     *
+     * @tparam T the component type
+     * @param q the quaternion, expected to be normalized
+     * @param vectors the vectors to rotate
+     * @param count the number of vectors
+     */
+    template <typename T>
+    void rotate(const quat<T>& q, vec<T,3>* vectors, const std::size_t count) {
+        rotate(q, vectors, count, vectors);
+    }
+
+    /**
+     * Rotates the vectors in the given range by the given quaternion and writes the results to the given output
+     * iterator, which may point to the beginning of the given range. If both iterators are pointers, the vectors are
+     * rotated in blocks as described above. Otherwise, they are rotated one by one.
+     *
+     * @tparam T the component type
+     * @tparam I the type of the input iterator
+     * @tparam O the type of the output iterator
+     * @param q the quaternion, expected to be normalized
+     * @param cur the start of the range of vectors
+     * @param end the end of the range of vectors
+     * @param out the output iterator
+     * @return the output iterator pointing past the last rotated vector
+     */
+    template <typename T, typename I, typename O>
+    O rotate(const quat<T>& q, I cur, I end, O out) {
+        if constexpr (std::is_pointer<I>::value && std::is_pointer<O>::value) {
+            const auto count = static_cast<std::size_t>(end - cur);
+            rotate(q, cur, count, out);
+            return out + count;
+        } else {
+            while (cur != end) {
+                *out = q * *cur;
+                ++cur;
+                ++out;
+            }
+            return out;
+        }
+    }
+
+    /**
+     * Computes the dot product of the given quaternions, treating them as four dimensional vectors. For unit
+     * quaternions, this is the cosine of half the angle of the rotation that takes one onto the other.
+     *
+     * @tparam T the component type
+     * @param lhs the first quaternion
+     * @param rhs the second quaternion
+     * @return the dot product of the given quaternions
+     */
+    template <typename T>
+    constexpr T dot(const quat<T>& lhs, const quat<T>& rhs) {
+        return lhs.r * rhs.r + lhs.v[0] * rhs.v[0] + lhs.v[1] * rhs.v[1] + lhs.v[2] * rhs.v[2];
+    }
+
+    /**
+     * Normalizes the given quaternion, treating it as a four dimensional vector.
+     *
+     * @tparam T the component type
+     * @param q the quaternion to normalize
+     * @return the normalized quaternion
+     */
+    template <typename T>
+    quat<T> normalize(const quat<T>& q) {
+        const auto length = std::sqrt(dot(q, q));
+        return quat<T>(q.r / length, q.v / length);
+    }
+
+    namespace detail {
+        /**
+         * Returns the given weighted sum of the given quaternions.
+         */
+        template <typename T>
+        constexpr quat<T> blend(const quat<T>& q0, const T w0, const quat<T>& q1, const T w1) {
+            return quat<T>(q0.r * w0 + q1.r * w1, q0.v * w0 + q1.v * w1);
+        }
+
+        /**
+         * The number of terms of the polynomial slerp approximation, see fast_slerp.
+         */
+        constexpr std::size_t slerp_terms = 16u;
+
+        /**
+         * The coefficients of the polynomial slerp approximation, see fast_slerp. With n = i+1, u_i = 1 / (n(2n+1))
+         * and v_i = n / (2n+1) are the coefficients of the power series of sin(t * a) / sin(a) in terms of
+         * cos(a) - 1. The coefficients of the last term are scaled by a constant that minimizes the maximum error of
+         * the truncated series.
+         */
+        template <typename T>
+        constexpr T slerp_u(const std::size_t i) {
+            const auto n = static_cast<T>(i + 1u);
+            const auto u = T(1.0) / (n * (T(2.0) * n + T(1.0)));
+            return i + 1u < slerp_terms ? u : u * T(1.91667136055716);
+        }
+
+        template <typename T>
+        constexpr T slerp_v(const std::size_t i) {
+            const auto n = static_cast<T>(i + 1u);
+            const auto v = n / (T(2.0) * n + T(1.0));
+            return i + 1u < slerp_terms ? v : v * T(1.91667136055716);
+        }
+    }
+
+    /**
+     * Interpolates linearly between the given unit quaternions and normalizes the result. If the dot product of the
+     * given quaternions is negative, the second quaternion is negated so that the interpolation follows the shorter
+     * path. Unlike slerp, the angular velocity is not constant, but the result is cheap to compute and accurate for
+     * small angles between the given quaternions.
+     *
+     * @tparam T the component type
+     * @param q0 the start quaternion, returned for t = 0
+     * @param q1 the end quaternion, returned for t = 1
+     * @param t the interpolation parameter, in [0, 1]
+     * @return the interpolated quaternion
+     */
+    template <typename T>
+    quat<T> nlerp(const quat<T>& q0, const quat<T>& q1, const T t) {
+        const auto w1 = dot(q0, q1) < T(0.0) ? -t : t;
+        return normalize(detail::blend(q0, T(1.0) - t, q1, w1));
+    }
+
+    /**
+     * Interpolates spherically between the given unit quaternions, that is, the result rotates about the same axis
+     * as the rotation that takes q0 onto q1 with constant angular velocity in t. If the dot product of the given
+     * quaternions is negative, the second quaternion is negated so that the interpolation follows the shorter path.
+     * If the given quaternions are nearly identical, this falls back to nlerp to avoid dividing by a vanishing sine.
+     *
+     * @tparam T the component type
+     * @param q0 the start quaternion, returned for t = 0
+     * @param q1 the end quaternion, returned for t = 1
+     * @param t the interpolation parameter, in [0, 1]
+     * @return the interpolated quaternion
+     */
+    template <typename T>
+    quat<T> slerp(const quat<T>& q0, const quat<T>& q1, const T t) {
+        const auto cos = dot(q0, q1);
+        const auto sign = cos < T(0.0) ? T(-1.0) : T(1.0);
+        const auto absCos = cos * sign;
+        if (absCos > T(1.0) - constants<T>::almost_zero() * constants<T>::almost_zero()) {
+            return nlerp(q0, q1, t);
+        }
+
+        const auto angle = std::acos(absCos);
+        const auto sin = std::sin(angle);
+        const auto w0 = std::sin((T(1.0) - t) * angle) / sin;
+        const auto w1 = std::sin(t * angle) / sin;
+        return detail::blend(q0, w0, q1, sign * w1);
+    }
+
+    /**
+     * Approximates slerp using only additions and multiplications. This evaluates the weights sin((1-t) * a) / sin(a)
+     * and sin(t * a) / sin(a) using a truncated power series in cos(a) - 1 as described by Eberly in "A Fast and
+     * Accurate Algorithm for Computing SLERP" (Journal of Graphics, GPU, and Game Tools, 2011), with 16 terms. The
+     * approximation is valid for all pairs of unit quaternions and t in [0, 1], and like slerp, it follows the shorter
+     * path.
+     *
+     * The error of each weight is at most 3.1e-8, so the error of each component of the result, compared to slerp, is
+     * below 1e-7 for double. For float, rounding dominates, and the error is below 5e-7. The result is not normalized;
+     * its length deviates from 1 by at most the same amount.
+     *
+     * @tparam T the component type
+     * @param q0 the start quaternion, returned for t = 0
+     * @param q1 the end quaternion, returned for t = 1
+     * @param t the interpolation parameter, in [0, 1]
+     * @return the interpolated quaternion
+     */
+    template <typename T>
+    constexpr quat<T> fast_slerp(const quat<T>& q0, const quat<T>& q1, const T t) {
+        const auto cos = dot(q0, q1);
+        const auto sign = cos < T(0.0) ? T(-1.0) : T(1.0);
+        const auto cosMinusOne = cos * sign - T(1.0);
+
+        const auto s = T(1.0) - t;
+        const auto tt = t * t;
+        const auto ss = s * s;
+
+        auto ct = T(1.0);
+        auto cs = T(1.0);
+        for (std::size_t i = detail::slerp_terms; i-- > 0u;) {
+            const auto u = detail::slerp_u<T>(i);
+            const auto v = detail::slerp_v<T>(i);
+            ct = T(1.0) + (u * tt - v) * cosMinusOne * ct;
+            cs = T(1.0) + (u * ss - v) * cosMinusOne * cs;
+        }
+
+        return detail::blend(q0, s * cs, q1, sign * (t * ct));
+    }
+
+    /**
+     * Interpolates count pairs of quaternions using fast_slerp, as when sampling many animation tracks at once. The
+     * i-th result is computed with the same operations as fast_slerp(q0[i], q1[i], t[i]), but the quaternions are
+     * interpolated in blocks using SIMD instructions if available. The results may differ from those of fast_slerp by
+     * a few units in the last place if the compiler contracts either implementation into fused multiply-add
+     * instructions. No memory is allocated.
+     *
+     * @tparam T the component type
+     * @param q0 the start quaternions
+     * @param q1 the end quaternions
+     * @param t the interpolation parameters
+     * @param count the number of quaternions to interpolate
+     * @param out the destination, must have room for the given number of quaternions and may be identical to q0 or q1
+     */
+    template <typename T>
+    void fast_slerp(const quat<T>* q0, const quat<T>* q1, const T* t, const std::size_t count, quat<T>* out) {
+        static_assert(sizeof(quat<T>) == 4u * sizeof(T), "quaternions must be tightly packed");
+        static_assert(std::is_standard_layout<quat<T>>::value, "quaternions must have standard layout");
+        using pack = detail::pack<T>;
+
+        const auto zero = pack::broadcast(T(0.0));
+        const auto one = pack::broadcast(T(1.0));
+        const auto minusOne = pack::broadcast(T(-1.0));
+
+        pack u[detail::slerp_terms];
+        pack v[detail::slerp_terms];
+        for (std::size_t i = 0u; i < detail::slerp_terms; ++i) {
+            u[i] = pack::broadcast(detail::slerp_u<T>(i));
+            v[i] = pack::broadcast(detail::slerp_v<T>(i));
+        }
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            pack a[4];
+            pack b[4];
+            detail::load_interleaved(reinterpret_cast<const T*>(q0 + i), a);
+            detail::load_interleaved(reinterpret_cast<const T*>(q1 + i), b);
+            const auto pt = pack::load(t + i);
+
+            // same operations in the same order as the scalar fast_slerp
+            const auto cos = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+            const auto sign = select(cos < zero, minusOne, one);
+            const auto cosMinusOne = cos * sign - one;
+
+            const auto s = one - pt;
+            const auto tt = pt * pt;
+            const auto ss = s * s;
+
+            auto ct = one;
+            auto cs = one;
+            for (std::size_t j = detail::slerp_terms; j-- > 0u;) {
+                ct = one + (u[j] * tt - v[j]) * cosMinusOne * ct;
+                cs = one + (u[j] * ss - v[j]) * cosMinusOne * cs;
+            }
+
+            const auto w0 = s * cs;
+            const auto w1 = sign * (pt * ct);
+            pack result[4];
+            for (std::size_t c = 0u; c < 4u; ++c) {
+                result[c] = a[c] * w0 + b[c] * w1;
+            }
+            detail::store_interleaved(result, reinterpret_cast<T*>(out + i));
+        }
+
+        for (; i < count; ++i) {
+            out[i] = fast_slerp(q0[i], q1[i], t[i]);
+        }
     }
 }
 
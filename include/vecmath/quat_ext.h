@@ -0,0 +1,355 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "quat.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace vm {
+    /**
+     * A unit quaternion compressed into the given number of bits using the smallest three encoding. Since q and -q
+     * represent the same rotation, and the components of a unit quaternion satisfy r^2 + x^2 + y^2 + z^2 = 1, it
+     * suffices to store the index of the component with the largest magnitude in 2 bits and the other three
+     * components, flipped so that the largest one is positive. Their magnitude is at most 1/sqrt(2), so each of them
+     * is quantized to (Bits - 2) / 3 bits over the range [-1/sqrt(2), 1/sqrt(2)]. The largest component is
+     * recovered from the others when decompressing.
+     *
+     * The bits are stored as little endian bytes, so a compressed quaternion occupies exactly Bits / 8 bytes and can
+     * be persisted or transmitted as is. With 32 bits, each component is quantized to 10 bits, and the rotation
+     * angle between a quaternion and its decompressed counterpart is at most about 0.24 degrees. With 48 bits, each
+     * component is quantized to 15 bits, and the angular error is at most about 0.008 degrees.
+     *
+     * @tparam Bits the number of bits, must be a multiple of 8 between 16 and 64
+     */
+    template <std::size_t Bits>
+    class compressed_quat {
+        static_assert(Bits % 8u == 0u && Bits >= 16u && Bits <= 64u, "Bits must be a multiple of 8 between 16 and 64");
+    public:
+        /**
+         * The number of bits used for each of the three stored components.
+         */
+        static constexpr std::size_t component_bits = (Bits - 2u) / 3u;
+
+        /**
+         * The largest quantized value of a stored component.
+         */
+        static constexpr std::uint64_t max_component = (std::uint64_t(1) << component_bits) - 1u;
+
+        /**
+         * The encoded bits, least significant byte first.
+         */
+        std::uint8_t bytes[Bits / 8u];
+    public:
+        /**
+         * Creates a new compressed quaternion with all bits set to 0.
+         */
+        constexpr compressed_quat() : bytes{} {}
+
+        /**
+         * Creates a new compressed quaternion from the given encoded bits.
+         *
+         * @param value the encoded bits, only the lowest Bits bits are used
+         */
+        constexpr explicit compressed_quat(const std::uint64_t value) : bytes{} {
+            for (std::size_t i = 0u; i < Bits / 8u; ++i) {
+                bytes[i] = static_cast<std::uint8_t>(value >> (8u * i));
+            }
+        }
+
+        /**
+         * Returns the encoded bits. The two most significant bits contain the index of the omitted component, followed
+         * by the three stored components in order.
+         *
+         * @return the encoded bits
+         */
+        constexpr std::uint64_t value() const {
+            std::uint64_t result = 0u;
+            for (std::size_t i = 0u; i < Bits / 8u; ++i) {
+                result |= static_cast<std::uint64_t>(bytes[i]) << (8u * i);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Checks whether the given compressed quaternions have identical bits.
+     *
+     * @tparam Bits the number of bits
+     * @param lhs the first compressed quaternion
+     * @param rhs the second compressed quaternion
+     * @return true if the given compressed quaternions are identical and false otherwise
+     */
+    template <std::size_t Bits>
+    constexpr bool operator==(const compressed_quat<Bits>& lhs, const compressed_quat<Bits>& rhs) {
+        return lhs.value() == rhs.value();
+    }
+
+    /**
+     * Checks whether the given compressed quaternions have different bits.
+     *
+     * @tparam Bits the number of bits
+     * @param lhs the first compressed quaternion
+     * @param rhs the second compressed quaternion
+     * @return true if the given compressed quaternions are different and false otherwise
+     */
+    template <std::size_t Bits>
+    constexpr bool operator!=(const compressed_quat<Bits>& lhs, const compressed_quat<Bits>& rhs) {
+        return lhs.value() != rhs.value();
+    }
+
+    namespace detail {
+        /**
+         * The largest magnitude of the three smallest components of a unit quaternion, 1/sqrt(2).
+         */
+        template <typename T>
+        constexpr T smallest_three_range() {
+            return static_cast<T>(0.707106781186547524400844362104849039);
+        }
+
+        /**
+         * The factor that maps [-1/sqrt(2), 1/sqrt(2)] onto [0, max_component] after the range has been shifted.
+         */
+        template <typename T, std::size_t Bits>
+        constexpr T smallest_three_scale() {
+            return static_cast<T>(compressed_quat<Bits>::max_component) / (T(2.0) * smallest_three_range<T>());
+        }
+
+        /**
+         * The inverse of smallest_three_scale.
+         */
+        template <typename T, std::size_t Bits>
+        constexpr T smallest_three_inverse_scale() {
+            return (T(2.0) * smallest_three_range<T>()) / static_cast<T>(compressed_quat<Bits>::max_component);
+        }
+
+        /**
+         * Assembles the encoded bits from the given index of the omitted component and the given quantized values,
+         * which must be non-negative and are truncated towards 0.
+         */
+        template <std::size_t Bits, typename T>
+        compressed_quat<Bits> assemble_smallest_three(const T index, const T a, const T b, const T c) {
+            constexpr auto n = compressed_quat<Bits>::component_bits;
+            auto value = static_cast<std::uint64_t>(index);
+            value = (value << n) | static_cast<std::uint64_t>(a);
+            value = (value << n) | static_cast<std::uint64_t>(b);
+            value = (value << n) | static_cast<std::uint64_t>(c);
+            return compressed_quat<Bits>(value);
+        }
+
+        /**
+         * Extracts the index of the omitted component and the quantized values from the given compressed quaternion.
+         */
+        template <typename T, std::size_t Bits>
+        void disassemble_smallest_three(const compressed_quat<Bits>& q, T& index, T& a, T& b, T& c) {
+            constexpr auto n = compressed_quat<Bits>::component_bits;
+            constexpr auto mask = compressed_quat<Bits>::max_component;
+            const auto value = q.value();
+            index = static_cast<T>((value >> (3u * n)) & 3u);
+            a = static_cast<T>((value >> (2u * n)) & mask);
+            b = static_cast<T>((value >> n) & mask);
+            c = static_cast<T>(value & mask);
+        }
+    }
+
+    /**
+     * Compresses the given unit quaternion using the smallest three encoding, see compressed_quat.
+     *
+     * @tparam Bits the number of bits of the result
+     * @tparam T the component type
+     * @param q the quaternion to compress, expected to be normalized
+     * @return the compressed quaternion
+     */
+    template <std::size_t Bits, typename T>
+    compressed_quat<Bits> compress_quat(const quat<T>& q) {
+        constexpr auto range = detail::smallest_three_range<T>();
+        constexpr auto scale = detail::smallest_three_scale<T, Bits>();
+
+        const T c[4] = { q.r, q.v[0], q.v[1], q.v[2] };
+        const T a[4] = { std::abs(c[0]), std::abs(c[1]), std::abs(c[2]), std::abs(c[3]) };
+
+        std::size_t largest;
+        if (a[0] >= a[1] && a[0] >= a[2] && a[0] >= a[3]) {
+            largest = 0u;
+        } else if (a[1] >= a[2] && a[1] >= a[3]) {
+            largest = 1u;
+        } else if (a[2] >= a[3]) {
+            largest = 2u;
+        } else {
+            largest = 3u;
+        }
+
+        // negate the quaternion if necessary so that the omitted component is positive
+        const auto sign = c[largest] < T(0.0) ? T(-1.0) : T(1.0);
+
+        T quantized[3];
+        for (std::size_t i = 0u, j = 0u; i < 4u; ++i) {
+            if (i != largest) {
+                const auto v = std::min(std::max(c[i] * sign, -range), range);
+                quantized[j++] = (v + range) * scale + T(0.5);
+            }
+        }
+
+        return detail::assemble_smallest_three<Bits>(static_cast<T>(largest), quantized[0], quantized[1], quantized[2]);
+    }
+
+    /**
+     * Decompresses the given quaternion, see compressed_quat. The result is normalized up to rounding.
+     *
+     * @tparam T the component type of the result
+     * @tparam Bits the number of bits of the compressed quaternion
+     * @param q the compressed quaternion
+     * @return the decompressed quaternion
+     */
+    template <typename T, std::size_t Bits>
+    quat<T> decompress_quat(const compressed_quat<Bits>& q) {
+        constexpr auto range = detail::smallest_three_range<T>();
+        constexpr auto inverseScale = detail::smallest_three_inverse_scale<T, Bits>();
+
+        T index, a, b, c;
+        detail::disassemble_smallest_three(q, index, a, b, c);
+
+        const auto v0 = a * inverseScale - range;
+        const auto v1 = b * inverseScale - range;
+        const auto v2 = c * inverseScale - range;
+        const auto l = std::sqrt(std::max(T(0.0), T(1.0) - v0 * v0 - v1 * v1 - v2 * v2));
+
+        return quat<T>(
+            index == T(0.0) ? l : v0, vec<T,3>(
+            index == T(1.0) ? l : (index > T(1.0) ? v1 : v0),
+            index == T(2.0) ? l : (index > T(2.0) ? v2 : v1),
+            index == T(3.0) ? l : v2));
+    }
+
+    /**
+     * Compresses the given unit quaternions and writes the results to the given destination. Each result is
+     * identical to compress_quat of the corresponding quaternion, but the arithmetic is performed in blocks using SIMD
+     * instructions if available. No memory is allocated.
+     *
+     * @tparam T the component type
+     * @tparam Bits the number of bits of the results
+     * @param quats the quaternions to compress, expected to be normalized
+     * @param count the number of quaternions
+     * @param out the destination, must have room for the given number of compressed quaternions
+     */
+    template <typename T, std::size_t Bits>
+    void compress_quat(const quat<T>* quats, const std::size_t count, compressed_quat<Bits>* out) {
+        static_assert(sizeof(quat<T>) == 4u * sizeof(T), "quaternions must be tightly packed");
+        using pack = detail::pack<T>;
+
+        const auto zero = pack::broadcast(T(0.0));
+        const auto one = pack::broadcast(T(1.0));
+        const auto minusOne = pack::broadcast(T(-1.0));
+        const auto range = pack::broadcast(detail::smallest_three_range<T>());
+        const auto minusRange = pack::broadcast(-detail::smallest_three_range<T>());
+        const auto scale = pack::broadcast(detail::smallest_three_scale<T, Bits>());
+        const auto half = pack::broadcast(T(0.5));
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            pack c[4];
+            detail::load_interleaved(reinterpret_cast<const T*>(quats + i), c);
+            const pack a[4] = { abs(c[0]), abs(c[1]), abs(c[2]), abs(c[3]) };
+
+            // same decisions as the branches in the scalar version; is1 and is2 only apply if the preceding masks
+            // are not set
+            const auto is0 = (a[0] >= a[1]) & (a[0] >= a[2]) & (a[0] >= a[3]);
+            const auto is1 = (a[1] >= a[2]) & (a[1] >= a[3]);
+            const auto is2 = a[2] >= a[3];
+            const auto is01 = is0 | is1;
+            const auto is012 = is01 | is2;
+
+            const auto largest = select(is0, c[0], select(is1, c[1], select(is2, c[2], c[3])));
+            const auto sign = select(largest < zero, minusOne, one);
+            const auto quantize = [&](const pack& v) {
+                return (min(max(v * sign, minusRange), range) + range) * scale + half;
+            };
+
+            T index[pack::width], q0[pack::width], q1[pack::width], q2[pack::width];
+            select(is0, zero, select(is1, one, select(is2, pack::broadcast(T(2.0)), pack::broadcast(T(3.0))))).store(index);
+            quantize(select(is0, c[1], c[0])).store(q0);
+            quantize(select(is01, c[2], c[1])).store(q1);
+            quantize(select(is012, c[3], c[2])).store(q2);
+
+            for (std::size_t j = 0u; j < pack::width; ++j) {
+                out[i + j] = detail::assemble_smallest_three<Bits>(index[j], q0[j], q1[j], q2[j]);
+            }
+        }
+
+        for (; i < count; ++i) {
+            out[i] = compress_quat<Bits>(quats[i]);
+        }
+    }
+
+    /**
+     * Decompresses the given quaternions and writes the results to the given destination. Each result is identical
+     * to decompress_quat of the corresponding compressed quaternion, but the arithmetic is performed in blocks using
+     * SIMD instructions if available. No memory is allocated.
+     *
+     * @tparam T the component type of the results
+     * @tparam Bits the number of bits of the compressed quaternions
+     * @param quats the compressed quaternions
+     * @param count the number of compressed quaternions
+     * @param out the destination, must have room for the given number of quaternions
+     */
+    template <typename T, std::size_t Bits>
+    void decompress_quat(const compressed_quat<Bits>* quats, const std::size_t count, quat<T>* out) {
+        static_assert(sizeof(quat<T>) == 4u * sizeof(T), "quaternions must be tightly packed");
+        using pack = detail::pack<T>;
+
+        const auto zero = pack::broadcast(T(0.0));
+        const auto one = pack::broadcast(T(1.0));
+        const auto two = pack::broadcast(T(2.0));
+        const auto three = pack::broadcast(T(3.0));
+        const auto range = pack::broadcast(detail::smallest_three_range<T>());
+        const auto inverseScale = pack::broadcast(detail::smallest_three_inverse_scale<T, Bits>());
+
+        std::size_t i = 0u;
+        for (; i + pack::width <= count; i += pack::width) {
+            T index[pack::width], q0[pack::width], q1[pack::width], q2[pack::width];
+            for (std::size_t j = 0u; j < pack::width; ++j) {
+                detail::disassemble_smallest_three(quats[i + j], index[j], q0[j], q1[j], q2[j]);
+            }
+
+            const auto k = pack::load(index);
+            const auto v0 = pack::load(q0) * inverseScale - range;
+            const auto v1 = pack::load(q1) * inverseScale - range;
+            const auto v2 = pack::load(q2) * inverseScale - range;
+            const auto l = sqrt(max(zero, one - v0 * v0 - v1 * v1 - v2 * v2));
+
+            // same choices as the conditional expressions in the scalar version
+            const pack c[4] = {
+                select(k == zero, l, v0),
+                select(k == one, l, select(k > one, v1, v0)),
+                select(k == two, l, select(k > two, v2, v1)),
+                select(k == three, l, v2)
+            };
+            detail::store_interleaved(c, reinterpret_cast<T*>(out + i));
+        }
+
+        for (; i < count; ++i) {
+            out[i] = decompress_quat<T>(quats[i]);
+        }
+    }
+}
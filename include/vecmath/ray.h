@@ -20,6 +20,7 @@
 
 #include "vec.h"
 #include "mat.h"
+#include "affine.h"
 
 #include "abstract_line.h"
 #include "scalar.h"
@@ -105,6 +106,19 @@ namespace vm {
             return ray<T,S>(newOrigin, newDirection);
         }
 
+        /**
+         * Transforms this line using the given affine transformation. The translational part is not applied to the
+         * direction, and the direction is normalized after the transformation has been applied.
+         *
+         * @param transform the transformation to apply
+         * @return the transformed ray
+         */
+        ray<T,S> transform(const affine<T,S>& transform) const {
+            const auto newOrigin = transform_point(transform, origin);
+            const auto newDirection = normalize(transform_vector(transform, direction));
+            return ray<T,S>(newOrigin, newDirection);
+        }
+
         /**
          * Transforms this line using the given transformation matrix at compile time. The translational part is not
          * applied to the direction, and the direction is normalized after the transformation has been applied.
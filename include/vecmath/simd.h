@@ -0,0 +1,831 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * Detects the SIMD instruction sets that are available for the compilation target. The following macros are defined
+ * if the corresponding instruction set can be used:
+ *
+ * - VM_SIMD_SSE2 if SSE2 instructions are available
+ * - VM_SIMD_AVX if AVX instructions are available
+ *
+ * Defining VM_DISABLE_SIMD before including any vecmath header disables all SIMD code paths.
+ *
+ * The SIMD code paths are only taken at runtime. During constant evaluation, the generic implementations are used.
+ * If the compiler does not provide a way to detect constant evaluation, VM_SIMD_DISPATCH remains undefined and the
+ * generic implementations are used everywhere.
+ *
+ * Batched kernels are written in terms of detail::pack<T>, which holds pack<T>::width values of type T and maps its
+ * operations to the widest available instruction set. For types or targets without SIMD support, a generic
+ * implementation which operates on an array of four values is used.
+ */
+
+#if !defined(VM_DISABLE_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VM_SIMD_SSE2 1
+#endif
+#if defined(VM_SIMD_SSE2) && defined(__AVX__)
+#define VM_SIMD_AVX 1
+#endif
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define VM_HAS_BUILTIN_IS_CONSTANT_EVALUATED 1
+#endif
+#elif defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9
+#define VM_HAS_BUILTIN_IS_CONSTANT_EVALUATED 1
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define VM_HAS_BUILTIN_IS_CONSTANT_EVALUATED 1
+#endif
+
+#if defined(VM_SIMD_SSE2) && defined(VM_HAS_BUILTIN_IS_CONSTANT_EVALUATED)
+#define VM_SIMD_DISPATCH 1
+#endif
+
+#if defined(VM_SIMD_SSE2)
+#include <immintrin.h>
+#endif
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+namespace vm {
+    namespace detail {
+        /**
+         * Checks whether the calling function is being evaluated at compile time. If the compiler cannot detect this,
+         * true is returned so that callers always choose their constexpr capable implementation.
+         *
+         * @return true if the call happens during constant evaluation and false otherwise
+         */
+        constexpr bool is_constant_evaluated() noexcept {
+#if defined(VM_HAS_BUILTIN_IS_CONSTANT_EVALUATED)
+            return __builtin_is_constant_evaluated();
+#else
+            return true;
+#endif
+        }
+
+        /**
+         * A mask with one boolean lane per lane of pack<T>. This is the generic implementation.
+         *
+         * @tparam T the component type of the corresponding pack
+         */
+        template <typename T>
+        struct pack_mask {
+            static constexpr std::size_t width = 4u;
+            bool v[width];
+
+            /**
+             * Returns a bit mask where bit i is set if lane i of this mask is set.
+             */
+            unsigned bits() const {
+                unsigned result = 0u;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result |= v[i] ? (1u << i) : 0u;
+                }
+                return result;
+            }
+
+            friend pack_mask operator&(const pack_mask& lhs, const pack_mask& rhs) {
+                pack_mask result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = lhs.v[i] && rhs.v[i];
+                }
+                return result;
+            }
+
+            friend pack_mask operator|(const pack_mask& lhs, const pack_mask& rhs) {
+                pack_mask result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = lhs.v[i] || rhs.v[i];
+                }
+                return result;
+            }
+
+            friend pack_mask operator!(const pack_mask& m) {
+                pack_mask result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = !m.v[i];
+                }
+                return result;
+            }
+        };
+
+        /**
+         * A fixed number of values of type T which are processed together. This is the generic implementation, which
+         * processes four values using scalar operations.
+         *
+         * All operations have the same semantics as their scalar counterparts, including the handling of NaN by min
+         * and max: min(a, b) returns a < b ? a : b, and max(a, b) returns a > b ? a : b.
+         *
+         * @tparam T the component type
+         */
+        template <typename T>
+        struct pack {
+            using mask = pack_mask<T>;
+            static constexpr std::size_t width = 4u;
+            T v[width];
+
+            static pack broadcast(const T value) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = value;
+                }
+                return result;
+            }
+
+            static pack load(const T* values) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = values[i];
+                }
+                return result;
+            }
+
+            void store(T* values) const {
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i] = v[i];
+                }
+            }
+
+            static pack load_strided(const T* values, const std::size_t stride) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = values[i * stride];
+                }
+                return result;
+            }
+
+            void store_strided(T* values, const std::size_t stride) const {
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i * stride] = v[i];
+                }
+            }
+
+            T operator[](const std::size_t i) const {
+                assert(i < width);
+                return v[i];
+            }
+
+#define VM_PACK_GENERIC_BINARY_OP(op) \
+            friend pack operator op(const pack& lhs, const pack& rhs) { \
+                pack result; \
+                for (std::size_t i = 0u; i < width; ++i) { \
+                    result.v[i] = lhs.v[i] op rhs.v[i]; \
+                } \
+                return result; \
+            }
+
+#define VM_PACK_GENERIC_COMPARISON_OP(op) \
+            friend mask operator op(const pack& lhs, const pack& rhs) { \
+                mask result; \
+                for (std::size_t i = 0u; i < width; ++i) { \
+                    result.v[i] = lhs.v[i] op rhs.v[i]; \
+                } \
+                return result; \
+            }
+
+            VM_PACK_GENERIC_BINARY_OP(+)
+            VM_PACK_GENERIC_BINARY_OP(-)
+            VM_PACK_GENERIC_BINARY_OP(*)
+            VM_PACK_GENERIC_BINARY_OP(/)
+            VM_PACK_GENERIC_COMPARISON_OP(<)
+            VM_PACK_GENERIC_COMPARISON_OP(<=)
+            VM_PACK_GENERIC_COMPARISON_OP(>)
+            VM_PACK_GENERIC_COMPARISON_OP(>=)
+            VM_PACK_GENERIC_COMPARISON_OP(==)
+
+#undef VM_PACK_GENERIC_BINARY_OP
+#undef VM_PACK_GENERIC_COMPARISON_OP
+
+            friend pack operator-(const pack& p) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = -p.v[i];
+                }
+                return result;
+            }
+
+            friend pack min(const pack& lhs, const pack& rhs) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = lhs.v[i] < rhs.v[i] ? lhs.v[i] : rhs.v[i];
+                }
+                return result;
+            }
+
+            friend pack max(const pack& lhs, const pack& rhs) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = lhs.v[i] > rhs.v[i] ? lhs.v[i] : rhs.v[i];
+                }
+                return result;
+            }
+
+            friend pack abs(const pack& p) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = p.v[i] < T(0) ? -p.v[i] : p.v[i];
+                }
+                return result;
+            }
+
+            friend pack sqrt(const pack& p) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = std::sqrt(p.v[i]);
+                }
+                return result;
+            }
+
+            friend pack select(const mask& m, const pack& lhs, const pack& rhs) {
+                pack result;
+                for (std::size_t i = 0u; i < width; ++i) {
+                    result.v[i] = m.v[i] ? lhs.v[i] : rhs.v[i];
+                }
+                return result;
+            }
+        };
+
+#if defined(VM_SIMD_SSE2)
+#if defined(VM_SIMD_AVX)
+        /**
+         * Mask for eight float lanes using AVX instructions.
+         */
+        template <>
+        struct pack_mask<float> {
+            static constexpr std::size_t width = 8u;
+            __m256 v;
+
+            unsigned bits() const {
+                return static_cast<unsigned>(_mm256_movemask_ps(v));
+            }
+
+            friend pack_mask operator&(const pack_mask& lhs, const pack_mask& rhs) { return { _mm256_and_ps(lhs.v, rhs.v) }; }
+            friend pack_mask operator|(const pack_mask& lhs, const pack_mask& rhs) { return { _mm256_or_ps(lhs.v, rhs.v) }; }
+            friend pack_mask operator!(const pack_mask& m) { return { _mm256_xor_ps(m.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))) }; }
+        };
+
+        /**
+         * Eight float values using AVX instructions.
+         */
+        template <>
+        struct pack<float> {
+            using mask = pack_mask<float>;
+            static constexpr std::size_t width = 8u;
+            __m256 v;
+
+            static pack broadcast(const float value) { return { _mm256_set1_ps(value) }; }
+            static pack load(const float* values) { return { _mm256_loadu_ps(values) }; }
+            void store(float* values) const { _mm256_storeu_ps(values, v); }
+
+            static pack load_strided(const float* values, const std::size_t stride) {
+                return { _mm256_set_ps(values[7 * stride], values[6 * stride], values[5 * stride], values[4 * stride],
+                    values[3 * stride], values[2 * stride], values[stride], values[0]) };
+            }
+
+            void store_strided(float* values, const std::size_t stride) const {
+                float buffer[width];
+                store(buffer);
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i * stride] = buffer[i];
+                }
+            }
+
+            float operator[](const std::size_t i) const {
+                assert(i < width);
+                float values[width];
+                store(values);
+                return values[i];
+            }
+
+            friend pack operator+(const pack& lhs, const pack& rhs) { return { _mm256_add_ps(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& lhs, const pack& rhs) { return { _mm256_sub_ps(lhs.v, rhs.v) }; }
+            friend pack operator*(const pack& lhs, const pack& rhs) { return { _mm256_mul_ps(lhs.v, rhs.v) }; }
+            friend pack operator/(const pack& lhs, const pack& rhs) { return { _mm256_div_ps(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& p) { return { _mm256_xor_ps(p.v, _mm256_set1_ps(-0.0f)) }; }
+
+            friend mask operator< (const pack& lhs, const pack& rhs) { return { _mm256_cmp_ps(lhs.v, rhs.v, _CMP_LT_OQ) }; }
+            friend mask operator<=(const pack& lhs, const pack& rhs) { return { _mm256_cmp_ps(lhs.v, rhs.v, _CMP_LE_OQ) }; }
+            friend mask operator> (const pack& lhs, const pack& rhs) { return { _mm256_cmp_ps(lhs.v, rhs.v, _CMP_GT_OQ) }; }
+            friend mask operator>=(const pack& lhs, const pack& rhs) { return { _mm256_cmp_ps(lhs.v, rhs.v, _CMP_GE_OQ) }; }
+            friend mask operator==(const pack& lhs, const pack& rhs) { return { _mm256_cmp_ps(lhs.v, rhs.v, _CMP_EQ_OQ) }; }
+
+            friend pack min(const pack& lhs, const pack& rhs) { return { _mm256_min_ps(lhs.v, rhs.v) }; }
+            friend pack max(const pack& lhs, const pack& rhs) { return { _mm256_max_ps(lhs.v, rhs.v) }; }
+            friend pack abs(const pack& p) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), p.v) }; }
+            friend pack sqrt(const pack& p) { return { _mm256_sqrt_ps(p.v) }; }
+            friend pack select(const mask& m, const pack& lhs, const pack& rhs) { return { _mm256_blendv_ps(rhs.v, lhs.v, m.v) }; }
+        };
+
+        /**
+         * Mask for four double lanes using AVX instructions.
+         */
+        template <>
+        struct pack_mask<double> {
+            static constexpr std::size_t width = 4u;
+            __m256d v;
+
+            unsigned bits() const {
+                return static_cast<unsigned>(_mm256_movemask_pd(v));
+            }
+
+            friend pack_mask operator&(const pack_mask& lhs, const pack_mask& rhs) { return { _mm256_and_pd(lhs.v, rhs.v) }; }
+            friend pack_mask operator|(const pack_mask& lhs, const pack_mask& rhs) { return { _mm256_or_pd(lhs.v, rhs.v) }; }
+            friend pack_mask operator!(const pack_mask& m) { return { _mm256_xor_pd(m.v, _mm256_castsi256_pd(_mm256_set1_epi32(-1))) }; }
+        };
+
+        /**
+         * Four double values using AVX instructions.
+         */
+        template <>
+        struct pack<double> {
+            using mask = pack_mask<double>;
+            static constexpr std::size_t width = 4u;
+            __m256d v;
+
+            static pack broadcast(const double value) { return { _mm256_set1_pd(value) }; }
+            static pack load(const double* values) { return { _mm256_loadu_pd(values) }; }
+            void store(double* values) const { _mm256_storeu_pd(values, v); }
+
+            static pack load_strided(const double* values, const std::size_t stride) {
+                return { _mm256_set_pd(values[3 * stride], values[2 * stride], values[stride], values[0]) };
+            }
+
+            void store_strided(double* values, const std::size_t stride) const {
+                double buffer[width];
+                store(buffer);
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i * stride] = buffer[i];
+                }
+            }
+
+            double operator[](const std::size_t i) const {
+                assert(i < width);
+                double values[width];
+                store(values);
+                return values[i];
+            }
+
+            friend pack operator+(const pack& lhs, const pack& rhs) { return { _mm256_add_pd(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& lhs, const pack& rhs) { return { _mm256_sub_pd(lhs.v, rhs.v) }; }
+            friend pack operator*(const pack& lhs, const pack& rhs) { return { _mm256_mul_pd(lhs.v, rhs.v) }; }
+            friend pack operator/(const pack& lhs, const pack& rhs) { return { _mm256_div_pd(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& p) { return { _mm256_xor_pd(p.v, _mm256_set1_pd(-0.0)) }; }
+
+            friend mask operator< (const pack& lhs, const pack& rhs) { return { _mm256_cmp_pd(lhs.v, rhs.v, _CMP_LT_OQ) }; }
+            friend mask operator<=(const pack& lhs, const pack& rhs) { return { _mm256_cmp_pd(lhs.v, rhs.v, _CMP_LE_OQ) }; }
+            friend mask operator> (const pack& lhs, const pack& rhs) { return { _mm256_cmp_pd(lhs.v, rhs.v, _CMP_GT_OQ) }; }
+            friend mask operator>=(const pack& lhs, const pack& rhs) { return { _mm256_cmp_pd(lhs.v, rhs.v, _CMP_GE_OQ) }; }
+            friend mask operator==(const pack& lhs, const pack& rhs) { return { _mm256_cmp_pd(lhs.v, rhs.v, _CMP_EQ_OQ) }; }
+
+            friend pack min(const pack& lhs, const pack& rhs) { return { _mm256_min_pd(lhs.v, rhs.v) }; }
+            friend pack max(const pack& lhs, const pack& rhs) { return { _mm256_max_pd(lhs.v, rhs.v) }; }
+            friend pack abs(const pack& p) { return { _mm256_andnot_pd(_mm256_set1_pd(-0.0), p.v) }; }
+            friend pack sqrt(const pack& p) { return { _mm256_sqrt_pd(p.v) }; }
+            friend pack select(const mask& m, const pack& lhs, const pack& rhs) { return { _mm256_blendv_pd(rhs.v, lhs.v, m.v) }; }
+        };
+#else
+        /**
+         * Mask for four float lanes using SSE instructions.
+         */
+        template <>
+        struct pack_mask<float> {
+            static constexpr std::size_t width = 4u;
+            __m128 v;
+
+            unsigned bits() const {
+                return static_cast<unsigned>(_mm_movemask_ps(v));
+            }
+
+            friend pack_mask operator&(const pack_mask& lhs, const pack_mask& rhs) { return { _mm_and_ps(lhs.v, rhs.v) }; }
+            friend pack_mask operator|(const pack_mask& lhs, const pack_mask& rhs) { return { _mm_or_ps(lhs.v, rhs.v) }; }
+            friend pack_mask operator!(const pack_mask& m) { return { _mm_xor_ps(m.v, _mm_castsi128_ps(_mm_set1_epi32(-1))) }; }
+        };
+
+        /**
+         * Four float values using SSE instructions.
+         */
+        template <>
+        struct pack<float> {
+            using mask = pack_mask<float>;
+            static constexpr std::size_t width = 4u;
+            __m128 v;
+
+            static pack broadcast(const float value) { return { _mm_set1_ps(value) }; }
+            static pack load(const float* values) { return { _mm_loadu_ps(values) }; }
+            void store(float* values) const { _mm_storeu_ps(values, v); }
+
+            static pack load_strided(const float* values, const std::size_t stride) {
+                return { _mm_set_ps(values[3 * stride], values[2 * stride], values[stride], values[0]) };
+            }
+
+            void store_strided(float* values, const std::size_t stride) const {
+                float buffer[width];
+                store(buffer);
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i * stride] = buffer[i];
+                }
+            }
+
+            float operator[](const std::size_t i) const {
+                assert(i < width);
+                float values[width];
+                store(values);
+                return values[i];
+            }
+
+            friend pack operator+(const pack& lhs, const pack& rhs) { return { _mm_add_ps(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& lhs, const pack& rhs) { return { _mm_sub_ps(lhs.v, rhs.v) }; }
+            friend pack operator*(const pack& lhs, const pack& rhs) { return { _mm_mul_ps(lhs.v, rhs.v) }; }
+            friend pack operator/(const pack& lhs, const pack& rhs) { return { _mm_div_ps(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& p) { return { _mm_xor_ps(p.v, _mm_set1_ps(-0.0f)) }; }
+
+            friend mask operator< (const pack& lhs, const pack& rhs) { return { _mm_cmplt_ps(lhs.v, rhs.v) }; }
+            friend mask operator<=(const pack& lhs, const pack& rhs) { return { _mm_cmple_ps(lhs.v, rhs.v) }; }
+            friend mask operator> (const pack& lhs, const pack& rhs) { return { _mm_cmpgt_ps(lhs.v, rhs.v) }; }
+            friend mask operator>=(const pack& lhs, const pack& rhs) { return { _mm_cmpge_ps(lhs.v, rhs.v) }; }
+            friend mask operator==(const pack& lhs, const pack& rhs) { return { _mm_cmpeq_ps(lhs.v, rhs.v) }; }
+
+            friend pack min(const pack& lhs, const pack& rhs) { return { _mm_min_ps(lhs.v, rhs.v) }; }
+            friend pack max(const pack& lhs, const pack& rhs) { return { _mm_max_ps(lhs.v, rhs.v) }; }
+            friend pack abs(const pack& p) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), p.v) }; }
+            friend pack sqrt(const pack& p) { return { _mm_sqrt_ps(p.v) }; }
+            friend pack select(const mask& m, const pack& lhs, const pack& rhs) {
+                return { _mm_or_ps(_mm_and_ps(m.v, lhs.v), _mm_andnot_ps(m.v, rhs.v)) };
+            }
+        };
+
+        /**
+         * Mask for two double lanes using SSE2 instructions.
+         */
+        template <>
+        struct pack_mask<double> {
+            static constexpr std::size_t width = 2u;
+            __m128d v;
+
+            unsigned bits() const {
+                return static_cast<unsigned>(_mm_movemask_pd(v));
+            }
+
+            friend pack_mask operator&(const pack_mask& lhs, const pack_mask& rhs) { return { _mm_and_pd(lhs.v, rhs.v) }; }
+            friend pack_mask operator|(const pack_mask& lhs, const pack_mask& rhs) { return { _mm_or_pd(lhs.v, rhs.v) }; }
+            friend pack_mask operator!(const pack_mask& m) { return { _mm_xor_pd(m.v, _mm_castsi128_pd(_mm_set1_epi32(-1))) }; }
+        };
+
+        /**
+         * Two double values using SSE2 instructions.
+         */
+        template <>
+        struct pack<double> {
+            using mask = pack_mask<double>;
+            static constexpr std::size_t width = 2u;
+            __m128d v;
+
+            static pack broadcast(const double value) { return { _mm_set1_pd(value) }; }
+            static pack load(const double* values) { return { _mm_loadu_pd(values) }; }
+            void store(double* values) const { _mm_storeu_pd(values, v); }
+
+            static pack load_strided(const double* values, const std::size_t stride) {
+                return { _mm_set_pd(values[stride], values[0]) };
+            }
+
+            void store_strided(double* values, const std::size_t stride) const {
+                double buffer[width];
+                store(buffer);
+                for (std::size_t i = 0u; i < width; ++i) {
+                    values[i * stride] = buffer[i];
+                }
+            }
+
+            double operator[](const std::size_t i) const {
+                assert(i < width);
+                double values[width];
+                store(values);
+                return values[i];
+            }
+
+            friend pack operator+(const pack& lhs, const pack& rhs) { return { _mm_add_pd(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& lhs, const pack& rhs) { return { _mm_sub_pd(lhs.v, rhs.v) }; }
+            friend pack operator*(const pack& lhs, const pack& rhs) { return { _mm_mul_pd(lhs.v, rhs.v) }; }
+            friend pack operator/(const pack& lhs, const pack& rhs) { return { _mm_div_pd(lhs.v, rhs.v) }; }
+            friend pack operator-(const pack& p) { return { _mm_xor_pd(p.v, _mm_set1_pd(-0.0)) }; }
+
+            friend mask operator< (const pack& lhs, const pack& rhs) { return { _mm_cmplt_pd(lhs.v, rhs.v) }; }
+            friend mask operator<=(const pack& lhs, const pack& rhs) { return { _mm_cmple_pd(lhs.v, rhs.v) }; }
+            friend mask operator> (const pack& lhs, const pack& rhs) { return { _mm_cmpgt_pd(lhs.v, rhs.v) }; }
+            friend mask operator>=(const pack& lhs, const pack& rhs) { return { _mm_cmpge_pd(lhs.v, rhs.v) }; }
+            friend mask operator==(const pack& lhs, const pack& rhs) { return { _mm_cmpeq_pd(lhs.v, rhs.v) }; }
+
+            friend pack min(const pack& lhs, const pack& rhs) { return { _mm_min_pd(lhs.v, rhs.v) }; }
+            friend pack max(const pack& lhs, const pack& rhs) { return { _mm_max_pd(lhs.v, rhs.v) }; }
+            friend pack abs(const pack& p) { return { _mm_andnot_pd(_mm_set1_pd(-0.0), p.v) }; }
+            friend pack sqrt(const pack& p) { return { _mm_sqrt_pd(p.v) }; }
+            friend pack select(const mask& m, const pack& lhs, const pack& rhs) {
+                return { _mm_or_pd(_mm_and_pd(m.v, lhs.v), _mm_andnot_pd(m.v, rhs.v)) };
+            }
+        };
+#endif
+#endif
+
+        /**
+         * Loads the given number of values into a pack. The remaining lanes are set to 0.
+         *
+         * @tparam T the component type
+         * @param values the values to load
+         * @param count the number of values to load, must not exceed pack<T>::width
+         * @return the pack
+         */
+        template <typename T>
+        pack<T> load_pack(const T* values, const std::size_t count) {
+            assert(count <= pack<T>::width);
+            if (count == pack<T>::width) {
+                return pack<T>::load(values);
+            }
+            T buffer[pack<T>::width] {};
+            for (std::size_t i = 0u; i < count; ++i) {
+                buffer[i] = values[i];
+            }
+            return pack<T>::load(buffer);
+        }
+
+        /**
+         * Stores the given number of lanes of the given pack.
+         *
+         * @tparam T the component type
+         * @param p the pack to store
+         * @param values the destination
+         * @param count the number of lanes to store, must not exceed pack<T>::width
+         */
+        template <typename T>
+        void store_pack(const pack<T>& p, T* values, const std::size_t count) {
+            assert(count <= pack<T>::width);
+            if (count == pack<T>::width) {
+                p.store(values);
+            } else {
+                T buffer[pack<T>::width];
+                p.store(buffer);
+                for (std::size_t i = 0u; i < count; ++i) {
+                    values[i] = buffer[i];
+                }
+            }
+        }
+
+        /**
+         * Calls the given operation for consecutive blocks of pack<T>::width indices in the range [0, count). The
+         * operation is passed the first index of the block and the number of indices in the block, which is less than
+         * the pack width only for the last block.
+         *
+         * @tparam T the component type that determines the pack width
+         * @tparam Op the type of the operation
+         * @param count the number of indices
+         * @param op the operation
+         */
+        template <typename T, typename Op>
+        void for_each_pack(const std::size_t count, Op&& op) {
+            constexpr auto width = pack<T>::width;
+            std::size_t i = 0u;
+            for (; i + width <= count; i += width) {
+                op(i, width);
+            }
+            if (i < count) {
+                op(i, count - i);
+            }
+        }
+
+        /**
+         * Loads pack<T>::width consecutive vectors with N components each and transposes them into N packs, such that
+         * the i-th pack contains the i-th component of each vector.
+         *
+         * @tparam T the component type
+         * @tparam N the number of components per vector
+         * @param values the components of the vectors, stored consecutively
+         * @param result the packs to load into
+         */
+        template <typename T, std::size_t N>
+        void load_interleaved(const T* values, pack<T> (&result)[N]) {
+            for (std::size_t c = 0u; c < N; ++c) {
+                result[c] = pack<T>::load_strided(values + c, N);
+            }
+        }
+
+        /**
+         * Transposes the given N packs into pack<T>::width vectors with N components each and stores them
+         * consecutively. This is the inverse of load_interleaved.
+         *
+         * @tparam T the component type
+         * @tparam N the number of components per vector
+         * @param p the packs to store
+         * @param values the destination
+         */
+        template <typename T, std::size_t N>
+        void store_interleaved(const pack<T> (&p)[N], T* values) {
+            for (std::size_t c = 0u; c < N; ++c) {
+                p[c].store_strided(values + c, N);
+            }
+        }
+
+#if defined(VM_SIMD_SSE2)
+        /*
+         * Three component vectors are transposed using shuffles. For float, four vectors occupy three registers
+         * (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3), and for double, two vectors occupy three registers
+         * (x0 y0 | z0 x1 | y1 z1). With AVX, each 128 bit lane holds the corresponding registers of one half of the
+         * vectors, and since the shuffles operate within lanes, the same shuffles apply.
+         */
+#if defined(VM_SIMD_AVX)
+        inline void load_interleaved(const float* values, pack<float> (&result)[3]) {
+            const auto load = [&](const std::size_t i) {
+                return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(values + i)), _mm_loadu_ps(values + i + 12u), 1);
+            };
+            const __m256 a = load(0u), b = load(4u), c = load(8u);
+#define VM_SHUFFLE_PS _mm256_shuffle_ps
+#else
+        inline void load_interleaved(const float* values, pack<float> (&result)[3]) {
+            const __m128 a = _mm_loadu_ps(values), b = _mm_loadu_ps(values + 4u), c = _mm_loadu_ps(values + 8u);
+#define VM_SHUFFLE_PS _mm_shuffle_ps
+#endif
+            result[0].v = VM_SHUFFLE_PS(VM_SHUFFLE_PS(a, a, _MM_SHUFFLE(3, 3, 3, 0)), VM_SHUFFLE_PS(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+            result[1].v = VM_SHUFFLE_PS(VM_SHUFFLE_PS(a, b, _MM_SHUFFLE(0, 0, 1, 1)), VM_SHUFFLE_PS(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            result[2].v = VM_SHUFFLE_PS(VM_SHUFFLE_PS(a, b, _MM_SHUFFLE(1, 1, 2, 2)), VM_SHUFFLE_PS(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+
+        inline void store_interleaved(const pack<float> (&p)[3], float* values) {
+            const auto x = p[0].v, y = p[1].v, z = p[2].v;
+            const auto a = VM_SHUFFLE_PS(VM_SHUFFLE_PS(x, y, _MM_SHUFFLE(0, 0, 0, 0)), VM_SHUFFLE_PS(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+            const auto b = VM_SHUFFLE_PS(VM_SHUFFLE_PS(y, z, _MM_SHUFFLE(1, 1, 1, 1)), VM_SHUFFLE_PS(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+            const auto c = VM_SHUFFLE_PS(VM_SHUFFLE_PS(z, x, _MM_SHUFFLE(3, 3, 2, 2)), VM_SHUFFLE_PS(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+#if defined(VM_SIMD_AVX)
+            _mm_storeu_ps(values,       _mm256_castps256_ps128(a));
+            _mm_storeu_ps(values + 4u,  _mm256_castps256_ps128(b));
+            _mm_storeu_ps(values + 8u,  _mm256_castps256_ps128(c));
+            _mm_storeu_ps(values + 12u, _mm256_extractf128_ps(a, 1));
+            _mm_storeu_ps(values + 16u, _mm256_extractf128_ps(b, 1));
+            _mm_storeu_ps(values + 20u, _mm256_extractf128_ps(c, 1));
+#else
+            _mm_storeu_ps(values,      a);
+            _mm_storeu_ps(values + 4u, b);
+            _mm_storeu_ps(values + 8u, c);
+#endif
+        }
+#undef VM_SHUFFLE_PS
+
+#if defined(VM_SIMD_AVX)
+        inline void load_interleaved(const double* values, pack<double> (&result)[3]) {
+            const auto load = [&](const std::size_t i) {
+                return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(values + i)), _mm_loadu_pd(values + i + 6u), 1);
+            };
+            const __m256d a = load(0u), b = load(2u), c = load(4u);
+            result[0].v = _mm256_shuffle_pd(a, b, 0xA);
+            result[1].v = _mm256_shuffle_pd(a, c, 0x5);
+            result[2].v = _mm256_shuffle_pd(b, c, 0xA);
+        }
+
+        inline void store_interleaved(const pack<double> (&p)[3], double* values) {
+            const __m256d a = _mm256_shuffle_pd(p[0].v, p[1].v, 0x0);
+            const __m256d b = _mm256_shuffle_pd(p[2].v, p[0].v, 0xA);
+            const __m256d c = _mm256_shuffle_pd(p[1].v, p[2].v, 0xF);
+            _mm_storeu_pd(values,      _mm256_castpd256_pd128(a));
+            _mm_storeu_pd(values + 2u, _mm256_castpd256_pd128(b));
+            _mm_storeu_pd(values + 4u, _mm256_castpd256_pd128(c));
+            _mm_storeu_pd(values + 6u, _mm256_extractf128_pd(a, 1));
+            _mm_storeu_pd(values + 8u, _mm256_extractf128_pd(b, 1));
+            _mm_storeu_pd(values + 10u, _mm256_extractf128_pd(c, 1));
+        }
+#else
+        inline void load_interleaved(const double* values, pack<double> (&result)[3]) {
+            const __m128d a = _mm_loadu_pd(values), b = _mm_loadu_pd(values + 2u), c = _mm_loadu_pd(values + 4u);
+            result[0].v = _mm_shuffle_pd(a, b, 0x2);
+            result[1].v = _mm_shuffle_pd(a, c, 0x1);
+            result[2].v = _mm_shuffle_pd(b, c, 0x2);
+        }
+
+        inline void store_interleaved(const pack<double> (&p)[3], double* values) {
+            _mm_storeu_pd(values,      _mm_shuffle_pd(p[0].v, p[1].v, 0x0));
+            _mm_storeu_pd(values + 2u, _mm_shuffle_pd(p[2].v, p[0].v, 0x2));
+            _mm_storeu_pd(values + 4u, _mm_shuffle_pd(p[1].v, p[2].v, 0x3));
+        }
+#endif
+
+        /*
+         * Four component vectors are transposed as 4x4 blocks for float and as 2x2 blocks for double. As above, with
+         * AVX, each 128 bit lane holds one half of the vectors.
+         */
+#if defined(VM_SIMD_AVX)
+#define VM_UNPACKLO_PS _mm256_unpacklo_ps
+#define VM_UNPACKHI_PS _mm256_unpackhi_ps
+#define VM_SHUFFLE_PS _mm256_shuffle_ps
+#else
+#define VM_UNPACKLO_PS _mm_unpacklo_ps
+#define VM_UNPACKHI_PS _mm_unpackhi_ps
+#define VM_SHUFFLE_PS _mm_shuffle_ps
+#endif
+        template <typename R>
+        inline void transpose_4x4(const R& a, const R& b, const R& c, const R& d, R (&result)[4]) {
+            const auto t0 = VM_UNPACKLO_PS(a, b), t1 = VM_UNPACKLO_PS(c, d);
+            const auto t2 = VM_UNPACKHI_PS(a, b), t3 = VM_UNPACKHI_PS(c, d);
+            result[0] = VM_SHUFFLE_PS(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+            result[1] = VM_SHUFFLE_PS(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+            result[2] = VM_SHUFFLE_PS(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            result[3] = VM_SHUFFLE_PS(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+#undef VM_UNPACKLO_PS
+#undef VM_UNPACKHI_PS
+#undef VM_SHUFFLE_PS
+
+#if defined(VM_SIMD_AVX)
+        inline void load_interleaved(const float* values, pack<float> (&result)[4]) {
+            const auto load = [&](const std::size_t i) {
+                return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(values + i)), _mm_loadu_ps(values + i + 16u), 1);
+            };
+            __m256 r[4];
+            transpose_4x4(load(0u), load(4u), load(8u), load(12u), r);
+            for (std::size_t i = 0u; i < 4u; ++i) {
+                result[i].v = r[i];
+            }
+        }
+
+        inline void store_interleaved(const pack<float> (&p)[4], float* values) {
+            __m256 r[4];
+            transpose_4x4(p[0].v, p[1].v, p[2].v, p[3].v, r);
+            for (std::size_t i = 0u; i < 4u; ++i) {
+                _mm_storeu_ps(values + 4u * i, _mm256_castps256_ps128(r[i]));
+                _mm_storeu_ps(values + 4u * i + 16u, _mm256_extractf128_ps(r[i], 1));
+            }
+        }
+
+        inline void load_interleaved(const double* values, pack<double> (&result)[4]) {
+            const auto load = [&](const std::size_t i) {
+                return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(values + i)), _mm_loadu_pd(values + i + 8u), 1);
+            };
+            const __m256d a = load(0u), b = load(2u), c = load(4u), d = load(6u);
+            result[0].v = _mm256_unpacklo_pd(a, c);
+            result[1].v = _mm256_unpackhi_pd(a, c);
+            result[2].v = _mm256_unpacklo_pd(b, d);
+            result[3].v = _mm256_unpackhi_pd(b, d);
+        }
+
+        inline void store_interleaved(const pack<double> (&p)[4], double* values) {
+            const __m256d r[4] = {
+                _mm256_unpacklo_pd(p[0].v, p[1].v),
+                _mm256_unpacklo_pd(p[2].v, p[3].v),
+                _mm256_unpackhi_pd(p[0].v, p[1].v),
+                _mm256_unpackhi_pd(p[2].v, p[3].v)
+            };
+            for (std::size_t i = 0u; i < 4u; ++i) {
+                _mm_storeu_pd(values + 2u * i, _mm256_castpd256_pd128(r[i]));
+                _mm_storeu_pd(values + 2u * i + 8u, _mm256_extractf128_pd(r[i], 1));
+            }
+        }
+#else
+        inline void load_interleaved(const float* values, pack<float> (&result)[4]) {
+            __m128 r[4];
+            transpose_4x4(_mm_loadu_ps(values), _mm_loadu_ps(values + 4u), _mm_loadu_ps(values + 8u), _mm_loadu_ps(values + 12u), r);
+            for (std::size_t i = 0u; i < 4u; ++i) {
+                result[i].v = r[i];
+            }
+        }
+
+        inline void store_interleaved(const pack<float> (&p)[4], float* values) {
+            __m128 r[4];
+            transpose_4x4(p[0].v, p[1].v, p[2].v, p[3].v, r);
+            for (std::size_t i = 0u; i < 4u; ++i) {
+                _mm_storeu_ps(values + 4u * i, r[i]);
+            }
+        }
+
+        inline void load_interleaved(const double* values, pack<double> (&result)[4]) {
+            const __m128d a = _mm_loadu_pd(values), b = _mm_loadu_pd(values + 2u), c = _mm_loadu_pd(values + 4u), d = _mm_loadu_pd(values + 6u);
+            result[0].v = _mm_unpacklo_pd(a, c);
+            result[1].v = _mm_unpackhi_pd(a, c);
+            result[2].v = _mm_unpacklo_pd(b, d);
+            result[3].v = _mm_unpackhi_pd(b, d);
+        }
+
+        inline void store_interleaved(const pack<double> (&p)[4], double* values) {
+            _mm_storeu_pd(values,      _mm_unpacklo_pd(p[0].v, p[1].v));
+            _mm_storeu_pd(values + 2u, _mm_unpacklo_pd(p[2].v, p[3].v));
+            _mm_storeu_pd(values + 4u, _mm_unpackhi_pd(p[0].v, p[1].v));
+            _mm_storeu_pd(values + 6u, _mm_unpackhi_pd(p[2].v, p[3].v));
+        }
+#endif
+#endif
+    }
+}
@@ -0,0 +1,556 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+#include "scalar.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    namespace detail {
+        /**
+         * A hash table that maps 64 bit keys to 32 bit values. All entries are stored in a single array using open
+         * addressing with linear probing, and entries are erased by shifting the following entries back instead of
+         * leaving tombstones, so the memory used only depends on the number of entries.
+         */
+        class flat_hash_table {
+        public:
+            /**
+             * The value returned by find if the key is not in the table. It cannot be stored in the table.
+             */
+            static constexpr std::uint32_t no_value = std::numeric_limits<std::uint32_t>::max();
+        private:
+            struct slot {
+                std::uint64_t key;
+                std::uint32_t value;
+            };
+
+            std::vector<slot> m_slots;
+            std::size_t m_size = 0u;
+
+            static std::uint64_t hash(std::uint64_t key) {
+                // the finalizer of MurmurHash3, which spreads every input bit over the whole result
+                key ^= key >> 33u;
+                key *= 0xFF51AFD7ED558CCDu;
+                key ^= key >> 33u;
+                key *= 0xC4CEB9FE1A85EC53u;
+                key ^= key >> 33u;
+                return key;
+            }
+
+            std::size_t home(const std::uint64_t key) const {
+                return static_cast<std::size_t>(hash(key)) & (m_slots.size() - 1u);
+            }
+
+            std::size_t find_slot(const std::uint64_t key) const {
+                if (m_slots.empty()) {
+                    return m_slots.size();
+                }
+                for (auto i = home(key);; i = (i + 1u) & (m_slots.size() - 1u)) {
+                    if (m_slots[i].value == no_value) {
+                        return m_slots.size();
+                    } else if (m_slots[i].key == key) {
+                        return i;
+                    }
+                }
+            }
+
+            void grow() {
+                auto slots = std::vector<slot>(std::max(std::size_t(16u), 2u * m_slots.size()), slot{ 0u, no_value });
+                std::swap(slots, m_slots);
+                m_size = 0u;
+                for (const auto& s : slots) {
+                    if (s.value != no_value) {
+                        insert(s.key, s.value);
+                    }
+                }
+            }
+        public:
+            /**
+             * Returns the number of entries.
+             */
+            std::size_t size() const {
+                return m_size;
+            }
+
+            /**
+             * Returns the number of slots, which is a power of two and at least a third larger than the number of
+             * entries.
+             */
+            std::size_t capacity() const {
+                return m_slots.size();
+            }
+
+            /**
+             * Returns the value for the given key, or no_value if the key is not in the table.
+             */
+            std::uint32_t find(const std::uint64_t key) const {
+                const auto i = find_slot(key);
+                return i < m_slots.size() ? m_slots[i].value : no_value;
+            }
+
+            /**
+             * Sets the value for the given key. The key must not be in the table yet.
+             */
+            void insert(const std::uint64_t key, const std::uint32_t value) {
+                assert(value != no_value);
+                assert(find(key) == no_value);
+
+                if (4u * (m_size + 1u) > 3u * m_slots.size()) {
+                    grow();
+                }
+
+                auto i = home(key);
+                while (m_slots[i].value != no_value) {
+                    i = (i + 1u) & (m_slots.size() - 1u);
+                }
+                m_slots[i] = slot{ key, value };
+                ++m_size;
+            }
+
+            /**
+             * Replaces the value for the given key, which must be in the table.
+             */
+            void replace(const std::uint64_t key, const std::uint32_t value) {
+                assert(value != no_value);
+                const auto i = find_slot(key);
+                assert(i < m_slots.size());
+                m_slots[i].value = value;
+            }
+
+            /**
+             * Removes the given key from the table. Returns true if the key was in the table and false otherwise.
+             */
+            bool erase(const std::uint64_t key) {
+                auto i = find_slot(key);
+                if (i == m_slots.size()) {
+                    return false;
+                }
+
+                // move back each following entry of the probe sequence that would not be found after the gap
+                const auto mask = m_slots.size() - 1u;
+                for (auto j = (i + 1u) & mask; m_slots[j].value != no_value; j = (j + 1u) & mask) {
+                    const auto k = home(m_slots[j].key);
+                    const auto reachable = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+                    if (!reachable) {
+                        m_slots[i] = m_slots[j];
+                        i = j;
+                    }
+                }
+                m_slots[i].value = no_value;
+                --m_size;
+                return true;
+            }
+
+            /**
+             * Calls the given function with the key and the value of every entry.
+             */
+            template <typename F>
+            void for_each(F&& f) const {
+                for (const auto& s : m_slots) {
+                    if (s.value != no_value) {
+                        f(s.key, s.value);
+                    }
+                }
+            }
+
+            /**
+             * Removes all entries and releases the memory.
+             */
+            void clear() {
+                m_slots = std::vector<slot>();
+                m_size = 0u;
+            }
+        };
+
+        /**
+         * Returns the squared distance between the given point and the closest point of the given box, which is 0 if
+         * the box contains the point.
+         */
+        template <typename T, std::size_t S>
+        constexpr T squared_distance_to_bbox(const vec<T,S>& p, const bbox<T,S>& b) {
+            auto result = T(0.0);
+            for (std::size_t i = 0u; i < S; ++i) {
+                const auto d = p[i] < b.min[i] ? b.min[i] - p[i] : (p[i] > b.max[i] ? p[i] - b.max[i] : T(0.0));
+                result += d * d;
+            }
+            return result;
+        }
+    }
+
+    /**
+     * A spatial hash that stores bounding boxes in the cells of a uniform grid, used to find the items within a box
+     * or a radius. Only the occupied cells are stored, in a flat hash table keyed by the cell coordinates, so the
+     * memory used depends on the number of items and not on the extent of the space they are in. Each item is stored
+     * in every cell it overlaps, so the grid works best when most items are not much larger than a cell, e.g. for
+     * vertices or small entities.
+     *
+     * The cell of a coordinate v is given by floor(v / cellSize), so the minimum of the cell is the grid point found
+     * by rounding v down. Cell coordinates are clamped to 21 bits per axis; coordinates farther than 2^20 cells from
+     * the origin share the outermost cells, which remains correct but becomes slower.
+     *
+     * Items are identified by ids, which remain valid until the item is removed, after which they may be reused.
+     * Items and cell entries are taken from pools that keep released elements in free lists.
+     *
+     * @tparam T the component type
+     * @tparam U the type of the user data stored with each item, must be default constructible
+     */
+    template <typename T, typename U>
+    class spatial_hash {
+    public:
+        /**
+         * The id that is never assigned to an item.
+         */
+        static constexpr std::size_t invalid_id = std::numeric_limits<std::size_t>::max();
+    private:
+        static constexpr std::int64_t max_cell = (std::int64_t(1) << 20) - 1;
+        static constexpr std::uint32_t no_entry = detail::flat_hash_table::no_value;
+
+        struct item {
+            bbox<T,3> bounds;
+            U data;
+            bool valid = false;
+        };
+
+        /** An entry of the singly linked list of items in a cell. */
+        struct entry {
+            std::uint32_t item;
+            std::uint32_t next;
+        };
+
+        using cell = std::array<std::int64_t, 3>;
+
+        T m_cellSize;
+        std::vector<item> m_items;
+        std::vector<std::size_t> m_freeItems;
+        std::size_t m_size;
+        std::vector<entry> m_entries;
+        std::uint32_t m_freeEntries;
+        /** Maps the key of each occupied cell to the first entry of its list. */
+        detail::flat_hash_table m_cells;
+    public:
+        /**
+         * Creates an empty spatial hash with the given cell size.
+         *
+         * @param cellSize the size of a cell along each axis, must be positive
+         */
+        explicit spatial_hash(const T cellSize) :
+        m_cellSize(cellSize),
+        m_size(0u),
+        m_freeEntries(no_entry) {
+            assert(cellSize > T(0.0));
+        }
+
+        /**
+         * Returns the size of a cell along each axis.
+         */
+        T cell_size() const {
+            return m_cellSize;
+        }
+
+        /**
+         * Indicates whether this spatial hash contains any items.
+         */
+        bool empty() const {
+            return m_size == 0u;
+        }
+
+        /**
+         * Returns the number of items.
+         */
+        std::size_t size() const {
+            return m_size;
+        }
+
+        /**
+         * Returns the number of occupied cells.
+         */
+        std::size_t cell_count() const {
+            return m_cells.size();
+        }
+
+        /**
+         * Removes all items. The pools are kept for reuse.
+         */
+        void clear() {
+            m_items.clear();
+            m_freeItems.clear();
+            m_size = 0u;
+            m_entries.clear();
+            m_freeEntries = no_entry;
+            m_cells.clear();
+        }
+
+        /**
+         * Inserts an item with the given bounds and user data.
+         *
+         * @param bounds the bounds of the item
+         * @param data the user data
+         * @return the id of the item
+         */
+        std::size_t insert(const bbox<T,3>& bounds, U data = U()) {
+            std::size_t id;
+            if (m_freeItems.empty()) {
+                assert(m_items.size() < no_entry);
+                id = m_items.size();
+                m_items.emplace_back();
+            } else {
+                id = m_freeItems.back();
+                m_freeItems.pop_back();
+            }
+
+            auto& i = m_items[id];
+            i.bounds = bounds;
+            i.data = std::move(data);
+            i.valid = true;
+            ++m_size;
+
+            for_each_cell(cell_of(bounds.min), cell_of(bounds.max), [&](const std::uint64_t key) {
+                const auto e = allocate_entry();
+                m_entries[e].item = static_cast<std::uint32_t>(id);
+                m_entries[e].next = m_cells.find(key);
+                if (m_entries[e].next == no_entry) {
+                    m_cells.insert(key, e);
+                } else {
+                    m_cells.replace(key, e);
+                }
+            });
+            return id;
+        }
+
+        /**
+         * Inserts a point with the given user data.
+         *
+         * @param point the point
+         * @param data the user data
+         * @return the id of the item
+         */
+        std::size_t insert(const vec<T,3>& point, U data = U()) {
+            return insert(bbox<T,3>(point, point), std::move(data));
+        }
+
+        /**
+         * Removes the item with the given id. The id becomes invalid and may be reused by later insertions.
+         *
+         * @param id the id of the item
+         */
+        void remove(const std::size_t id) {
+            assert(is_valid(id));
+
+            auto& i = m_items[id];
+            for_each_cell(cell_of(i.bounds.min), cell_of(i.bounds.max), [&](const std::uint64_t key) {
+                const auto first = m_cells.find(key);
+                auto previous = no_entry;
+                auto e = first;
+                while (m_entries[e].item != id) {
+                    previous = e;
+                    e = m_entries[e].next;
+                }
+
+                const auto next = m_entries[e].next;
+                if (previous != no_entry) {
+                    m_entries[previous].next = next;
+                } else if (next != no_entry) {
+                    m_cells.replace(key, next);
+                } else {
+                    m_cells.erase(key);
+                }
+                free_entry(e);
+            });
+
+            i.valid = false;
+            i.data = U();
+            m_freeItems.push_back(id);
+            --m_size;
+        }
+
+        /**
+         * Returns the bounds of the item with the given id.
+         */
+        const bbox<T,3>& bounds(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_items[id].bounds;
+        }
+
+        /**
+         * Returns the user data of the item with the given id.
+         */
+        const U& data(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_items[id].data;
+        }
+
+        /**
+         * Returns the user data of the item with the given id.
+         */
+        U& data(const std::size_t id) {
+            assert(is_valid(id));
+            return m_items[id].data;
+        }
+
+        /**
+         * Indicates whether the given id refers to an item in this spatial hash.
+         */
+        bool is_valid(const std::size_t id) const {
+            return id < m_items.size() && m_items[id].valid;
+        }
+
+        /**
+         * Calls the given function once with the id of each item whose bounds intersect the given bounding box. The
+         * function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param b the bounding box
+         * @param visit the function
+         */
+        template <typename F>
+        void query(const bbox<T,3>& b, F&& visit) const {
+            query_cells(b, [&](const item& i) {
+                return i.bounds.intersects(b);
+            }, visit);
+        }
+
+        /**
+         * Calls the given function once with the id of each item whose bounds are within the given distance of the
+         * given point. The function must return true to continue the query or false to stop it.
+         *
+         * @tparam F the type of the function
+         * @param center the point
+         * @param radius the distance
+         * @param visit the function
+         */
+        template <typename F>
+        void query_radius(const vec<T,3>& center, const T radius, F&& visit) const {
+            const auto b = bbox<T,3>(center - vec<T,3>::fill(radius), center + vec<T,3>::fill(radius));
+            query_cells(b, [&](const item& i) {
+                return detail::squared_distance_to_bbox(center, i.bounds) <= radius * radius;
+            }, visit);
+        }
+    private:
+        cell cell_of(const vec<T,3>& p) const {
+            cell result;
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                const auto c = floor(p[i] / m_cellSize);
+                // compare in floating point before converting to avoid overflow
+                result[i] = c < static_cast<T>(-max_cell - 1) ? -max_cell - 1 : (c > static_cast<T>(max_cell) ? max_cell : static_cast<std::int64_t>(c));
+            }
+            return result;
+        }
+
+        static std::uint64_t key_of(const cell& c) {
+            const auto bits = [](const std::int64_t v) {
+                return static_cast<std::uint64_t>(v + max_cell + 1);
+            };
+            return (bits(c[0]) << 42u) | (bits(c[1]) << 21u) | bits(c[2]);
+        }
+
+        static cell cell_of_key(const std::uint64_t key) {
+            const auto value = [](const std::uint64_t bits) {
+                return static_cast<std::int64_t>(bits & 0x1FFFFFu) - max_cell - 1;
+            };
+            return cell{ value(key >> 42u), value(key >> 21u), value(key) };
+        }
+
+        template <typename F>
+        static void for_each_cell(const cell& min, const cell& max, F&& f) {
+            for (auto x = min[0]; x <= max[0]; ++x) {
+                for (auto y = min[1]; y <= max[1]; ++y) {
+                    for (auto z = min[2]; z <= max[2]; ++z) {
+                        f(key_of(cell{ x, y, z }));
+                    }
+                }
+            }
+        }
+
+        /**
+         * Visits the items in the cells overlapped by the given box that pass the given test. An item that overlaps
+         * several of these cells is only visited from the first of them, which is the cell containing the maximum of
+         * the minima of the item and the box.
+         */
+        template <typename P, typename F>
+        void query_cells(const bbox<T,3>& b, const P& test, F& visit) const {
+            const auto min = cell_of(b.min);
+            const auto max = cell_of(b.max);
+
+            const auto visit_cell = [&](const cell& c, std::uint32_t e) {
+                for (; e != no_entry; e = m_entries[e].next) {
+                    const auto& i = m_items[m_entries[e].item];
+                    if (test(i) && cell_of(vm::max(i.bounds.min, b.min)) == c && !visit(static_cast<std::size_t>(m_entries[e].item))) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // if the box covers more cells than are occupied, it is faster to check the occupied cells
+            auto cellCount = T(1.0);
+            for (std::size_t i = 0u; i < 3u; ++i) {
+                cellCount *= static_cast<T>(max[i] - min[i] + 1);
+            }
+
+            if (cellCount > static_cast<T>(m_cells.size())) {
+                auto stop = false;
+                m_cells.for_each([&](const std::uint64_t key, const std::uint32_t first) {
+                    if (!stop) {
+                        const auto c = cell_of_key(key);
+                        if (c[0] >= min[0] && c[1] >= min[1] && c[2] >= min[2] && c[0] <= max[0] && c[1] <= max[1] && c[2] <= max[2]) {
+                            stop = !visit_cell(c, first);
+                        }
+                    }
+                });
+            } else {
+                for (auto x = min[0]; x <= max[0]; ++x) {
+                    for (auto y = min[1]; y <= max[1]; ++y) {
+                        for (auto z = min[2]; z <= max[2]; ++z) {
+                            const auto first = m_cells.find(key_of(cell{ x, y, z }));
+                            if (first != no_entry && !visit_cell(cell{ x, y, z }, first)) {
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        std::uint32_t allocate_entry() {
+            if (m_freeEntries == no_entry) {
+                assert(m_entries.size() < no_entry);
+                m_entries.push_back(entry{ 0u, no_entry });
+                return static_cast<std::uint32_t>(m_entries.size() - 1u);
+            }
+            const auto e = m_freeEntries;
+            m_freeEntries = m_entries[e].next;
+            return e;
+        }
+
+        void free_entry(const std::uint32_t e) {
+            m_entries[e].next = m_freeEntries;
+            m_freeEntries = e;
+        }
+    };
+}
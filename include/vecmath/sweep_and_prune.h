@@ -0,0 +1,346 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "bbox.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A broadphase that finds the pairs of intersecting boxes in a changing set of bounding boxes using the sweep and
+     * prune method.
+     *
+     * For each axis, the minimum and maximum coordinates of all boxes are kept in an array of endpoints sorted along
+     * that axis. When the boxes move, the arrays are re-sorted using insertion sort, which takes linear time if the
+     * boxes only move a little between updates. Whenever a minimum endpoint of one box moves past a maximum endpoint
+     * of another, the two boxes start or stop overlapping along that axis, and the set of intersecting pairs is
+     * updated accordingly. Boxes that touch are considered intersecting, as with bbox::intersects.
+     *
+     * Boxes are identified by ids, which remain valid until the box is removed, after which they may be reused.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     */
+    template <typename T, std::size_t S>
+    class sweep_and_prune {
+    private:
+        struct endpoint {
+            T value;
+            /** The id of the box shifted left by one, with the lowest bit set for maximum endpoints. */
+            std::uint32_t data;
+
+            std::uint32_t id() const {
+                return data >> 1u;
+            }
+
+            bool is_max() const {
+                return (data & 1u) != 0u;
+            }
+
+            /**
+             * Orders endpoints by value, and minimum endpoints before maximum endpoints with the same value, so that
+             * touching boxes overlap.
+             */
+            bool operator<(const endpoint& other) const {
+                return value < other.value || (value == other.value && (data & 1u) < (other.data & 1u));
+            }
+        };
+
+        std::vector<bbox<T,S>> m_bounds;
+        /** The bounds at the last update, which determine whether a pair can be in the set of pairs. */
+        std::vector<bbox<T,S>> m_previousBounds;
+        std::vector<bool> m_valid;
+        std::vector<std::size_t> m_free;
+        std::vector<endpoint> m_endpoints[S];
+        std::unordered_set<std::uint64_t> m_pairs;
+        std::size_t m_inserted = 0u;
+    public:
+        /**
+         * If more boxes than this were inserted since the last update, the next update sorts the endpoints from
+         * scratch and finds all pairs with a single sweep instead of sorting the new endpoints into place one by one.
+         */
+        static constexpr std::size_t rebuild_threshold = 16u;
+
+        /**
+         * The largest number of boxes that can be stored.
+         */
+        static constexpr std::size_t max_size = std::size_t(1u) << 31u;
+
+        /**
+         * Creates an empty broadphase.
+         */
+        sweep_and_prune() = default;
+
+        /**
+         * Returns the number of boxes.
+         */
+        std::size_t size() const {
+            return m_endpoints[0].size() / 2u;
+        }
+
+        /**
+         * Indicates whether this broadphase contains any boxes.
+         */
+        bool empty() const {
+            return size() == 0u;
+        }
+
+        /**
+         * Indicates whether the given id refers to a box.
+         */
+        bool is_valid(const std::size_t id) const {
+            return id < m_valid.size() && m_valid[id];
+        }
+
+        /**
+         * Returns the bounds of the box with the given id, as passed to the last call to insert or move.
+         */
+        const bbox<T,S>& bounds(const std::size_t id) const {
+            assert(is_valid(id));
+            return m_bounds[id];
+        }
+
+        /**
+         * Adds a box with the given bounds. Its pairs are found by the next call to update.
+         *
+         * @param bounds the bounds of the box
+         * @return the id of the box
+         */
+        std::size_t insert(const bbox<T,S>& bounds) {
+            std::size_t id;
+            if (m_free.empty()) {
+                id = m_bounds.size();
+                assert(id < max_size);
+                m_bounds.push_back(bounds);
+                m_previousBounds.push_back(disjoint_bounds());
+                m_valid.push_back(true);
+            } else {
+                id = m_free.back();
+                m_free.pop_back();
+                m_bounds[id] = bounds;
+                m_previousBounds[id] = disjoint_bounds();
+                m_valid[id] = true;
+            }
+
+            // the new endpoints are sorted into place by the next update, which reports the new pairs
+            const auto data = static_cast<std::uint32_t>(id << 1u);
+            for (std::size_t i = 0u; i < S; ++i) {
+                m_endpoints[i].push_back(endpoint{ std::numeric_limits<T>::max(), data });
+                m_endpoints[i].push_back(endpoint{ std::numeric_limits<T>::max(), data | 1u });
+            }
+            ++m_inserted;
+            return id;
+        }
+
+        /**
+         * Removes the box with the given id and all of its pairs. This takes linear time in the number of boxes and
+         * pairs.
+         *
+         * @param id the id of the box
+         */
+        void remove(const std::size_t id) {
+            assert(is_valid(id));
+            for (std::size_t i = 0u; i < S; ++i) {
+                auto& endpoints = m_endpoints[i];
+                endpoints.erase(std::remove_if(std::begin(endpoints), std::end(endpoints), [&](const endpoint& e) {
+                    return e.id() == id;
+                }), std::end(endpoints));
+            }
+
+            for (auto it = std::begin(m_pairs); it != std::end(m_pairs);) {
+                if (key_first(*it) == id || key_second(*it) == id) {
+                    it = m_pairs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            m_valid[id] = false;
+            m_free.push_back(id);
+        }
+
+        /**
+         * Sets the bounds of the box with the given id. The pairs are updated by the next call to update.
+         *
+         * @param id the id of the box
+         * @param bounds the new bounds of the box
+         */
+        void move(const std::size_t id, const bbox<T,S>& bounds) {
+            assert(is_valid(id));
+            m_bounds[id] = bounds;
+        }
+
+        /**
+         * Sorts the endpoints according to the current bounds of the boxes and updates the set of intersecting pairs.
+         * If the boxes moved only a little since the last update, this takes close to linear time.
+         */
+        void update() {
+            const auto rebuild = m_inserted > rebuild_threshold;
+            m_inserted = 0u;
+
+            for (std::size_t i = 0u; i < S; ++i) {
+                auto& endpoints = m_endpoints[i];
+                for (auto& e : endpoints) {
+                    const auto& b = m_bounds[e.id()];
+                    e.value = e.is_max() ? b.max[i] : b.min[i];
+                }
+                if (rebuild) {
+                    std::sort(std::begin(endpoints), std::end(endpoints));
+                } else {
+                    sort_axis(endpoints, i);
+                }
+            }
+
+            if (rebuild) {
+                find_all_pairs();
+            }
+            m_previousBounds = m_bounds;
+        }
+
+        /**
+         * Returns the number of intersecting pairs found by the last update.
+         */
+        std::size_t pair_count() const {
+            return m_pairs.size();
+        }
+
+        /**
+         * Calls the given function with the ids of each pair of intersecting boxes found by the last update, passing
+         * the smaller id first. The pairs are visited in no particular order.
+         *
+         * @tparam F the type of the function
+         * @param visit the function
+         */
+        template <typename F>
+        void for_each_pair(F&& visit) const {
+            for (const auto key : m_pairs) {
+                visit(key_first(key), key_second(key));
+            }
+        }
+    private:
+        /**
+         * Returns bounds that do not intersect any box, for boxes that did not exist at the last update.
+         */
+        static bbox<T,S> disjoint_bounds() {
+            bbox<T,S> result;
+            result.min = vec<T,S>::fill(std::numeric_limits<T>::infinity());
+            result.max = vec<T,S>::fill(-std::numeric_limits<T>::infinity());
+            return result;
+        }
+
+        static std::uint64_t make_key(const std::size_t a, const std::size_t b) {
+            const auto first = static_cast<std::uint64_t>(std::min(a, b));
+            const auto second = static_cast<std::uint64_t>(std::max(a, b));
+            return (first << 32u) | second;
+        }
+
+        static std::size_t key_first(const std::uint64_t key) {
+            return static_cast<std::size_t>(key >> 32u);
+        }
+
+        static std::size_t key_second(const std::uint64_t key) {
+            return static_cast<std::size_t>(key & 0xFFFFFFFFu);
+        }
+
+        /**
+         * Checks whether the given boxes may still be in the set of pairs while the given axis is sorted.
+         */
+        bool was_pair(const std::size_t a, const std::size_t b, const std::size_t axis) const {
+            if (!m_previousBounds[a].intersects(m_previousBounds[b])) {
+                return false;
+            }
+            for (std::size_t i = 0u; i < axis; ++i) {
+                if (m_bounds[a].max[i] < m_bounds[b].min[i] || m_bounds[b].max[i] < m_bounds[a].min[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Replaces the set of intersecting pairs by sweeping over the sorted endpoints of the first axis and testing
+         * each box against the boxes that overlap it along that axis.
+         */
+        void find_all_pairs() {
+            m_pairs.clear();
+
+            // the boxes whose minimum endpoint has been passed, but not their maximum endpoint
+            std::vector<std::uint32_t> active;
+            std::vector<std::size_t> activeIndex(m_bounds.size());
+            for (const auto& e : m_endpoints[0]) {
+                const auto id = e.id();
+                if (e.is_max()) {
+                    const auto index = activeIndex[id];
+                    active[index] = active.back();
+                    activeIndex[active[index]] = index;
+                    active.pop_back();
+                } else {
+                    for (const auto other : active) {
+                        if (m_bounds[id].intersects(m_bounds[other])) {
+                            m_pairs.insert(make_key(id, other));
+                        }
+                    }
+                    activeIndex[id] = active.size();
+                    active.push_back(id);
+                }
+            }
+        }
+
+        /**
+         * Sorts the given endpoints of the given axis using insertion sort. Every pair of endpoints that is out of
+         * order is swapped exactly once, so a pair of boxes starts or stops overlapping along this axis exactly when a
+         * minimum endpoint of one box is swapped with a maximum endpoint of the other.
+         *
+         * When two boxes stop overlapping, they can only form a pair if they intersected at the last update. If they
+         * also stopped overlapping along one of the axes sorted before, the pair was already removed then.
+         */
+        void sort_axis(std::vector<endpoint>& endpoints, const std::size_t axis) {
+            for (std::size_t i = 1u; i < endpoints.size(); ++i) {
+                const auto e = endpoints[i];
+                auto j = i;
+                while (j > 0u && e < endpoints[j - 1u]) {
+                    const auto& previous = endpoints[j - 1u];
+                    if (!e.is_max() && previous.is_max()) {
+                        // the boxes start overlapping along this axis, and intersect if they overlap along the others
+                        if (m_bounds[e.id()].intersects(m_bounds[previous.id()])) {
+                            m_pairs.insert(make_key(e.id(), previous.id()));
+                        }
+                    } else if (e.is_max() && !previous.is_max()) {
+                        // the boxes stop overlapping along this axis
+                        if (was_pair(e.id(), previous.id(), axis)) {
+                            m_pairs.erase(make_key(e.id(), previous.id()));
+                        }
+                    }
+                    endpoints[j] = previous;
+                    --j;
+                }
+                endpoints[j] = e;
+            }
+        }
+    };
+}
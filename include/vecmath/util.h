@@ -49,6 +49,12 @@ namespace vm {
         inside
     };
 
+    enum class frustum_status {
+        outside,
+        intersecting,
+        inside
+    };
+
     namespace axis {
         using type = size_t;
         static const type x = 0;
@@ -0,0 +1,618 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "vec.h"
+#include "scalar.h"
+#include "simd.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vm {
+    /**
+     * A sequence of vectors that is stored as a structure of arrays, that is, the components of the vectors are stored
+     * in S separate contiguous arrays, one for each component. This layout allows the arithmetic functions declared
+     * below to process several vectors at once using SIMD instructions.
+     *
+     * Individual vectors are accessed using proxy objects that convert to and from vec<T,S>.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     */
+    template <typename T, std::size_t S>
+    class vec_soa {
+    public:
+        using type = T;
+        using value_type = vec<T,S>;
+        static constexpr std::size_t components = S;
+
+        /**
+         * Proxy for a single vector stored in a vec_soa. Assigning to a proxy assigns to the stored vector.
+         */
+        class reference {
+        private:
+            vec_soa* m_soa;
+            std::size_t m_index;
+        public:
+            reference(vec_soa& soa, const std::size_t index) :
+            m_soa(&soa),
+            m_index(index) {}
+
+            reference(const reference& other) = default;
+
+            /**
+             * Assigns the given vector to the referenced vector.
+             */
+            reference& operator=(const vec<T,S>& v) {
+                for (std::size_t c = 0u; c < S; ++c) {
+                    m_soa->m_components[c][m_index] = v[c];
+                }
+                return *this;
+            }
+
+            /**
+             * Assigns the vector referenced by the given proxy to the vector referenced by this proxy.
+             */
+            reference& operator=(const reference& other) {
+                const vec<T,S> v = other;
+                return *this = v;
+            }
+
+            /**
+             * Returns a reference to the given component of the referenced vector.
+             */
+            T& operator[](const std::size_t c) const {
+                assert(c < S);
+                return m_soa->m_components[c][m_index];
+            }
+
+            /**
+             * Returns a copy of the referenced vector.
+             */
+            operator vec<T,S>() const {
+                vec<T,S> result;
+                for (std::size_t c = 0u; c < S; ++c) {
+                    result[c] = m_soa->m_components[c][m_index];
+                }
+                return result;
+            }
+        };
+    private:
+        std::vector<T> m_components[S];
+    public:
+        /**
+         * Creates a new empty sequence.
+         */
+        vec_soa() = default;
+
+        /**
+         * Creates a new sequence of the given number of vectors with all components initialized to 0.
+         *
+         * @param count the number of vectors
+         */
+        explicit vec_soa(const std::size_t count) {
+            resize(count);
+        }
+
+        /**
+         * Creates a new sequence containing the vectors in the given range. Optionally accepts a transformation that is
+         * applied to each element of the range.
+         *
+         * @tparam I the range iterator type
+         * @tparam G the type of the transformation
+         * @param cur the start of the range
+         * @param end the end of the range
+         * @param get the transformation
+         */
+        template <typename I, typename G = identity, typename = decltype(*std::declval<I>())>
+        vec_soa(I cur, I end, const G& get = G()) {
+            while (cur != end) {
+                push_back(get(*cur));
+                ++cur;
+            }
+        }
+
+        /**
+         * Returns the number of vectors in this sequence.
+         */
+        std::size_t size() const {
+            return m_components[0].size();
+        }
+
+        /**
+         * Indicates whether this sequence is empty.
+         */
+        bool empty() const {
+            return size() == 0u;
+        }
+
+        /**
+         * Reserves storage for the given number of vectors.
+         */
+        void reserve(const std::size_t count) {
+            for (auto& component : m_components) {
+                component.reserve(count);
+            }
+        }
+
+        /**
+         * Resizes this sequence to the given number of vectors. Added vectors have all components set to 0.
+         */
+        void resize(const std::size_t count) {
+            for (auto& component : m_components) {
+                component.resize(count, static_cast<T>(0.0));
+            }
+        }
+
+        /**
+         * Removes all vectors from this sequence.
+         */
+        void clear() {
+            for (auto& component : m_components) {
+                component.clear();
+            }
+        }
+
+        /**
+         * Appends the given vector to this sequence.
+         */
+        void push_back(const vec<T,S>& v) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                m_components[c].push_back(v[c]);
+            }
+        }
+
+        /**
+         * Returns a proxy for the vector at the given index.
+         */
+        reference operator[](const std::size_t i) {
+            assert(i < size());
+            return reference(*this, i);
+        }
+
+        /**
+         * Returns a copy of the vector at the given index.
+         */
+        vec<T,S> operator[](const std::size_t i) const {
+            assert(i < size());
+            vec<T,S> result;
+            for (std::size_t c = 0u; c < S; ++c) {
+                result[c] = m_components[c][i];
+            }
+            return result;
+        }
+
+        /**
+         * Returns a pointer to the contiguous array that stores the given component of all vectors.
+         */
+        T* data(const std::size_t c) {
+            assert(c < S);
+            return m_components[c].data();
+        }
+
+        /**
+         * Returns a pointer to the contiguous array that stores the given component of all vectors.
+         */
+        const T* data(const std::size_t c) const {
+            assert(c < S);
+            return m_components[c].data();
+        }
+    };
+
+    /* ========== conversion ========== */
+
+    /**
+     * Converts the given range of vectors into a structure of arrays. Optionally accepts a transformation that is
+     * applied to each element of the range.
+     *
+     * @tparam I the range iterator type
+     * @tparam G the type of the transformation
+     * @param cur the start of the range
+     * @param end the end of the range
+     * @param get the transformation
+     * @return the structure of arrays
+     */
+    template <typename I, typename G = identity>
+    auto to_soa(I cur, I end, const G& get = G()) {
+        using V = typename std::remove_cv<typename std::remove_reference<decltype(get(*cur))>::type>::type;
+        return vec_soa<typename V::type, V::size>(cur, end, get);
+    }
+
+    /**
+     * Converts the given structure of arrays back into individual vectors, which are written to the given output
+     * iterator.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam O the output iterator type
+     * @param soa the structure of arrays
+     * @param out the output iterator
+     */
+    template <typename T, std::size_t S, typename O>
+    void to_aos(const vec_soa<T,S>& soa, O out) {
+        for (std::size_t i = 0u; i < soa.size(); ++i) {
+            *out++ = soa[i];
+        }
+    }
+
+    namespace detail {
+        /**
+         * Applies the given binary operation to each pair of corresponding components of the given sequences.
+         *
+         * @tparam T the component type
+         * @tparam S the number of components
+         * @tparam Op the type of the operation, which must accept and return pack<T>
+         * @param lhs the first sequence
+         * @param rhs the second sequence
+         * @param op the operation
+         * @return a sequence containing the results
+         */
+        template <typename T, std::size_t S, typename Op>
+        vec_soa<T,S> soa_componentwise(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs, const Op& op) {
+            assert(lhs.size() == rhs.size());
+            vec_soa<T,S> result(lhs.size());
+            for (std::size_t c = 0u; c < S; ++c) {
+                const T* l = lhs.data(c);
+                const T* r = rhs.data(c);
+                T* o = result.data(c);
+                for_each_pack<T>(lhs.size(), [&](const std::size_t i, const std::size_t n) {
+                    store_pack(op(load_pack(l + i, n), load_pack(r + i, n)), o + i, n);
+                });
+            }
+            return result;
+        }
+
+        /**
+         * Computes the dot products of the given packs of vector components.
+         */
+        template <typename T, std::size_t S>
+        pack<T> soa_dot(const pack<T> (&lhs)[S], const pack<T> (&rhs)[S]) {
+            auto result = pack<T>::broadcast(static_cast<T>(0.0));
+            for (std::size_t c = 0u; c < S; ++c) {
+                result = result + lhs[c] * rhs[c];
+            }
+            return result;
+        }
+
+        /**
+         * Loads the components of the vectors at the given index in the given sequence.
+         */
+        template <typename T, std::size_t S>
+        void soa_load(const vec_soa<T,S>& soa, const std::size_t i, const std::size_t n, pack<T> (&result)[S]) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                result[c] = load_pack(soa.data(c) + i, n);
+            }
+        }
+
+        /**
+         * Stores the given components at the given index in the given sequence.
+         */
+        template <typename T, std::size_t S>
+        void soa_store(const pack<T> (&values)[S], vec_soa<T,S>& soa, const std::size_t i, const std::size_t n) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                store_pack(values[c], soa.data(c) + i, n);
+            }
+        }
+    }
+
+    /* ========== arithmetic functions ========== */
+
+    /**
+     * Returns the sums of the corresponding vectors of the given sequences.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the sums
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> operator+(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        return detail::soa_componentwise(lhs, rhs, [](const auto& l, const auto& r) { return l + r; });
+    }
+
+    /**
+     * Returns the differences of the corresponding vectors of the given sequences.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the differences
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> operator-(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        return detail::soa_componentwise(lhs, rhs, [](const auto& l, const auto& r) { return l - r; });
+    }
+
+    /**
+     * Returns the products of the vectors of the given sequence with the given scalar factor.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the sequence
+     * @param rhs the scalar factor
+     * @return the products
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> operator*(const vec_soa<T,S>& lhs, const T rhs) {
+        const auto f = detail::pack<T>::broadcast(rhs);
+        vec_soa<T,S> result(lhs.size());
+        for (std::size_t c = 0u; c < S; ++c) {
+            const T* l = lhs.data(c);
+            T* o = result.data(c);
+            detail::for_each_pack<T>(lhs.size(), [&](const std::size_t i, const std::size_t n) {
+                detail::store_pack(detail::load_pack(l + i, n) * f, o + i, n);
+            });
+        }
+        return result;
+    }
+
+    /**
+     * Returns the products of the vectors of the given sequence with the given scalar factor.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the scalar factor
+     * @param rhs the sequence
+     * @return the products
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> operator*(const T lhs, const vec_soa<T,S>& rhs) {
+        return rhs * lhs;
+    }
+
+    /**
+     * Returns the component wise minimums of the corresponding vectors of the given sequences. NaN values are handled
+     * like vm::min(const vec<T,S>&, const vec<T,S>&) does.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the component wise minimums
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> min(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        return detail::soa_componentwise(lhs, rhs, [](const auto& l, const auto& r) { return min(l, r); });
+    }
+
+    /**
+     * Returns the component wise maximums of the corresponding vectors of the given sequences. NaN values are handled
+     * like vm::max(const vec<T,S>&, const vec<T,S>&) does.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the component wise maximums
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> max(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        return detail::soa_componentwise(lhs, rhs, [](const auto& l, const auto& r) { return max(l, r); });
+    }
+
+    /**
+     * Returns the dot products of the corresponding vectors of the given sequences.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the dot products
+     */
+    template <typename T, std::size_t S>
+    std::vector<T> dot(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        assert(lhs.size() == rhs.size());
+        std::vector<T> result(lhs.size());
+        detail::for_each_pack<T>(lhs.size(), [&](const std::size_t i, const std::size_t n) {
+            detail::pack<T> l[S], r[S];
+            detail::soa_load(lhs, i, n, l);
+            detail::soa_load(rhs, i, n, r);
+            detail::store_pack(detail::soa_dot(l, r), result.data() + i, n);
+        });
+        return result;
+    }
+
+    /**
+     * Returns the cross products of the corresponding vectors of the given sequences.
+     *
+     * @tparam T the component type
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the cross products
+     */
+    template <typename T>
+    vec_soa<T,3> cross(const vec_soa<T,3>& lhs, const vec_soa<T,3>& rhs) {
+        assert(lhs.size() == rhs.size());
+        vec_soa<T,3> result(lhs.size());
+        detail::for_each_pack<T>(lhs.size(), [&](const std::size_t i, const std::size_t n) {
+            detail::pack<T> l[3], r[3];
+            detail::soa_load(lhs, i, n, l);
+            detail::soa_load(rhs, i, n, r);
+            const detail::pack<T> o[3] = {
+                l[1] * r[2] - l[2] * r[1],
+                l[2] * r[0] - l[0] * r[2],
+                l[0] * r[1] - l[1] * r[0]
+            };
+            detail::soa_store(o, result, i, n);
+        });
+        return result;
+    }
+
+    /**
+     * Normalizes the vectors of the given sequence.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param soa the sequence
+     * @return the normalized vectors
+     */
+    template <typename T, std::size_t S>
+    vec_soa<T,S> normalize(const vec_soa<T,S>& soa) {
+        vec_soa<T,S> result(soa.size());
+        detail::for_each_pack<T>(soa.size(), [&](const std::size_t i, const std::size_t n) {
+            detail::pack<T> v[S];
+            detail::soa_load(soa, i, n, v);
+            const auto length = sqrt(detail::soa_dot(v, v));
+            for (std::size_t c = 0u; c < S; ++c) {
+                v[c] = v[c] / length;
+            }
+            detail::soa_store(v, result, i, n);
+        });
+        return result;
+    }
+
+    /**
+     * Returns the squared distances between the corresponding vectors of the given sequences.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param lhs the first sequence
+     * @param rhs the second sequence, which must have the same size as the first sequence
+     * @return the squared distances
+     */
+    template <typename T, std::size_t S>
+    std::vector<T> squared_distance(const vec_soa<T,S>& lhs, const vec_soa<T,S>& rhs) {
+        assert(lhs.size() == rhs.size());
+        std::vector<T> result(lhs.size());
+        detail::for_each_pack<T>(lhs.size(), [&](const std::size_t i, const std::size_t n) {
+            detail::pack<T> l[S], r[S];
+            detail::soa_load(lhs, i, n, l);
+            detail::soa_load(rhs, i, n, r);
+            for (std::size_t c = 0u; c < S; ++c) {
+                l[c] = l[c] - r[c];
+            }
+            detail::store_pack(detail::soa_dot(l, l), result.data() + i, n);
+        });
+        return result;
+    }
+
+    /* ========== linear systems ========== */
+
+    /**
+     * Solves many independent systems of equations a_i*x_i=b_i at once, using LU factorization with pivoting. The
+     * matrices are given in structure of arrays form: columns[c] contains the c-th column of each matrix a_i, so
+     * columns[c][i][r] is the element of a_i in row r and column c.
+     *
+     * Several systems are solved together using SIMD instructions if available. The pivot of each system is chosen
+     * separately by blending the rows of the packed matrices, so every system is solved using the same operations as
+     * lup_solve, and the solutions are identical to those computed by lup_solve.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param columns the columns of the matrices, all of which must have the same size as b
+     * @param b the right-hand sides of the systems
+     * @return a pair of a mask and the solutions such that the i-th element of the mask indicates whether the i-th
+     * system could be solved, and if so, the i-th solution is x_i such that a_i*x_i=b_i; the solutions of the systems
+     * that could not be solved are set to 0
+     */
+    template <typename T, std::size_t S>
+    std::tuple<std::vector<bool>, vec_soa<T,S>> lup_solve(const std::array<vec_soa<T,S>, S>& columns, const vec_soa<T,S>& b) {
+        using pack = detail::pack<T>;
+        using mask = typename pack::mask;
+
+        const auto count = b.size();
+        std::vector<bool> solved(count);
+        vec_soa<T,S> result(count);
+
+        detail::for_each_pack<T>(count, [&](const std::size_t i, const std::size_t n) {
+            pack a[S][S];
+            for (std::size_t c = 0u; c < S; ++c) {
+                assert(columns[c].size() == count);
+                detail::soa_load(columns[c], i, n, a[c]);
+            }
+            pack y[S];
+            detail::soa_load(b, i, n, y);
+
+            const auto zero = pack::broadcast(static_cast<T>(0.0));
+            const auto threshold = pack::broadcast(static_cast<T>(1.0e-15));
+            mask singular = zero < zero; // no lanes set
+
+            for (std::size_t k = 0u; k < S; ++k) {
+                // find the row with the largest pivot in each system; best[r] is set for the lanes whose pivot is in row r
+                auto p = zero;
+                mask best[S];
+                for (std::size_t r = k; r < S; ++r) {
+                    const auto v = abs(a[k][r]);
+                    const auto greater = v > p;
+                    p = select(greater, v, p);
+                    for (std::size_t q = k; q < r; ++q) {
+                        best[q] = best[q] & !greater;
+                    }
+                    best[r] = greater;
+                }
+                singular = singular | (p < threshold);
+
+                // swap the pivot row with row k, including the right-hand side
+                for (std::size_t r = k + 1u; r < S; ++r) {
+                    for (std::size_t c = 0u; c < S; ++c) {
+                        const auto t = a[c][k];
+                        a[c][k] = select(best[r], a[c][r], t);
+                        a[c][r] = select(best[r], t, a[c][r]);
+                    }
+                    const auto t = y[k];
+                    y[k] = select(best[r], y[r], t);
+                    y[r] = select(best[r], t, y[r]);
+                }
+
+                for (std::size_t r = k + 1u; r < S; ++r) {
+                    a[k][r] = a[k][r] / a[k][k];
+                    for (std::size_t c = k + 1u; c < S; ++c) {
+                        a[c][r] = a[c][r] - a[k][r] * a[c][k];
+                    }
+                }
+            }
+
+            // forward substitution with L, then back substitution with U
+            for (std::size_t r = 0u; r < S; ++r) {
+                auto sum = zero;
+                for (std::size_t c = 0u; c < r; ++c) {
+                    sum = sum + a[c][r] * y[c];
+                }
+                y[r] = y[r] - sum;
+            }
+            pack x[S];
+            for (std::size_t r = S - 1u; r < S; --r) {
+                auto sum = zero;
+                for (std::size_t c = r + 1u; c < S; ++c) {
+                    sum = sum + a[c][r] * x[c];
+                }
+                x[r] = (y[r] - sum) / a[r][r];
+            }
+            for (std::size_t r = 0u; r < S; ++r) {
+                x[r] = select(singular, zero, x[r]);
+            }
+            detail::soa_store(x, result, i, n);
+
+            const auto bits = singular.bits();
+            for (std::size_t l = 0u; l < n; ++l) {
+                solved[i + l] = ((bits >> l) & 1u) == 0u;
+            }
+        });
+
+        return std::make_tuple(std::move(solved), std::move(result));
+    }
+}
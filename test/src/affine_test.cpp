@@ -0,0 +1,197 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/affine.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/mat.h>
+#include <vecmath/mat_ext.h>
+#include <vecmath/mat_io.h>
+#include <vecmath/plane.h>
+#include <vecmath/polygon.h>
+#include <vecmath/ray.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+
+#include "test_utils.h"
+
+#include <tuple>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    static mat4x4d make_affine_matrix() {
+        return translation_matrix(vec3d(1.0, -2.0, 3.0))
+            * rotation_matrix(normalize(vec3d(1.0, 2.0, 3.0)), to_radians(27.0))
+            * scaling_matrix(vec3d(2.0, 0.5, 3.0));
+    }
+
+    static mat4x4d make_rigid_matrix() {
+        return translation_matrix(vec3d(-4.0, 5.0, 1.0)) * rotation_matrix(normalize(vec3d(3.0, -1.0, 2.0)), to_radians(71.0));
+    }
+
+    TEST_CASE("affine.constructor_default") {
+        constexpr auto t = affine3d();
+        CER_CHECK(t.to_matrix() == mat4x4d::identity());
+        CER_CHECK(t == affine3d::identity());
+    }
+
+    TEST_CASE("affine.constructor_with_linear_and_translation") {
+        constexpr auto t = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        CER_CHECK(t.to_matrix() == mat4x4d(
+            1, 2, 3, 10,
+            4, 5, 6, 11,
+            7, 8, 9, 12,
+            0, 0, 0,  1));
+        CER_CHECK(t.linear() == mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9));
+        CER_CHECK(t.translation() == vec3d(10, 11, 12));
+    }
+
+    TEST_CASE("affine.constructor_from_matrix") {
+        constexpr auto m = mat4x4d(
+            1, 2, 3, 10,
+            4, 5, 6, 11,
+            7, 8, 9, 12,
+            0, 0, 0,  1);
+        constexpr auto t = affine3d(m);
+        CER_CHECK(t.to_matrix() == m);
+        CER_CHECK(t[3] == vec3d(10, 11, 12));
+    }
+
+    TEST_CASE("affine.constructor_convert") {
+        constexpr auto t = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        constexpr auto u = affine3f(t);
+        CER_CHECK(u.to_matrix() == mat4x4f(t.to_matrix()));
+    }
+
+    TEST_CASE("affine.compare") {
+        constexpr auto t = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        constexpr auto u = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 13));
+        CER_CHECK(compare(t, t) == 0);
+        CER_CHECK(compare(t, u) < 0);
+        CER_CHECK(compare(u, t) > 0);
+        CER_CHECK(t != u);
+        CER_CHECK(is_equal(t, u, 1.0));
+        CER_CHECK_FALSE(is_equal(t, u, 0.5));
+    }
+
+    TEST_CASE("affine.operator_multiply_affine") {
+        const auto m1 = make_affine_matrix();
+        const auto m2 = make_rigid_matrix();
+        CHECK(is_equal((affine3d(m1) * affine3d(m2)).to_matrix(), m1 * m2, 0.000001));
+        CHECK(is_equal((affine3d(m2) * affine3d(m1)).to_matrix(), m2 * m1, 0.000001));
+
+        constexpr auto t = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        CER_CHECK((t * t).to_matrix() == t.to_matrix() * t.to_matrix());
+    }
+
+    TEST_CASE("affine.transform_point") {
+        const auto m = make_affine_matrix();
+        const auto t = affine3d(m);
+        for (const auto& p : { vec3d(0, 0, 0), vec3d(1, 2, 3), vec3d(-7.5, 0.25, 12.0) }) {
+            CHECK(is_equal(t * p, m * p, 0.000001));
+            CHECK(is_equal(transform_point(t, p), m * p, 0.000001));
+        }
+
+        constexpr auto c = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        CER_CHECK(c * vec3d(1, 2, 3) == vec3d(24, 43, 62));
+    }
+
+    TEST_CASE("affine.transform_vector") {
+        const auto m = make_affine_matrix();
+        const auto t = affine3d(m);
+        const auto v = vec3d(1, 2, 3);
+        CHECK(is_equal(transform_vector(t, v), strip_translation(m) * v, 0.000001));
+
+        constexpr auto c = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        CER_CHECK(transform_vector(c, vec3d(1, 2, 3)) == vec3d(14, 32, 50));
+    }
+
+    TEST_CASE("affine.transform_normal") {
+        const auto t = affine3d(make_affine_matrix());
+
+        // the tangents of a surface and its normal must remain perpendicular
+        const auto u = vec3d(1, 2, 0);
+        const auto v = vec3d(0, -1, 3);
+        const auto n = cross(u, v);
+
+        const auto tn = transform_normal(t, n);
+        CHECK(dot(tn, transform_vector(t, u)) == approx(0.0));
+        CHECK(dot(tn, transform_vector(t, v)) == approx(0.0));
+        CHECK(dot(tn, n) > 0.0);
+
+        // for a rigid transformation, normals transform like vectors
+        const auto r = affine3d(make_rigid_matrix());
+        CHECK(transform_normal(r, n) == approx(transform_vector(r, n)));
+
+        constexpr auto s = affine3d(mat3x3d(2, 0, 0, 0, 4, 0, 0, 0, 1), vec3d(1, 1, 1));
+        CER_CHECK(transform_normal(s, vec3d(1, 1, 1)) == approx(vec3d(0.5, 0.25, 1.0)));
+    }
+
+    TEST_CASE("affine.invert") {
+        const auto m = make_affine_matrix();
+        const auto t = affine3d(m);
+
+        const auto [invertible, inverse] = invert(t);
+        CHECK(invertible);
+        CHECK(inverse.to_matrix() == approx(std::get<1>(invert(m))));
+        CHECK((inverse * t).to_matrix() == approx(mat4x4d::identity()));
+
+        constexpr auto singular = affine3d(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9), vec3d(10, 11, 12));
+        CER_CHECK_FALSE(std::get<0>(invert(singular)));
+        CER_CHECK(std::get<1>(invert(singular)) == affine3d::identity());
+    }
+
+    TEST_CASE("affine.invert_rigid") {
+        const auto m = make_rigid_matrix();
+        const auto t = affine3d(m);
+        CHECK(invert_rigid(t).to_matrix() == approx(std::get<1>(invert(m))));
+        CHECK((invert_rigid(t) * t).to_matrix() == approx(mat4x4d::identity()));
+    }
+
+    TEST_CASE("affine.bbox_transform") {
+        const auto m = make_affine_matrix();
+        const auto b = bbox3d(vec3d(-1, -2, -3), vec3d(4, 5, 6));
+        CHECK(b.transform(affine3d(m)) == b.transform(m));
+    }
+
+    TEST_CASE("affine.plane_transform") {
+        const auto m = make_affine_matrix();
+        const auto p = plane3d(vec3d(1, 2, 3), normalize(vec3d(1, 1, 0)));
+        const auto expected = p.transform(m);
+        const auto actual = p.transform(affine3d(m));
+        CHECK(actual.normal == approx(expected.normal));
+        CHECK(actual.distance == approx(expected.distance));
+    }
+
+    TEST_CASE("affine.ray_transform") {
+        const auto m = make_affine_matrix();
+        const auto r = ray3d(vec3d(1, 2, 3), normalize(vec3d(1, -1, 2)));
+        const auto expected = r.transform(m);
+        const auto actual = r.transform(affine3d(m));
+        CHECK(actual.origin == approx(expected.origin));
+        CHECK(actual.direction == approx(expected.direction));
+    }
+
+    TEST_CASE("affine.polygon_transform") {
+        const auto m = make_affine_matrix();
+        const auto p = polygon3d{ vec3d(0, 0, 0), vec3d(4, 0, 0), vec3d(4, 4, 0), vec3d(0, 4, 0) };
+        CHECK(p.transform(affine3d(m)) == p.transform(m));
+    }
+}
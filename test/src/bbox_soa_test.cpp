@@ -0,0 +1,143 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/bbox_io.h>
+#include <vecmath/bbox_soa.h>
+#include <vecmath/scalar.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename T, typename P>
+    static void check_bbox_soa_results(const std::vector<bbox<T,3>>& boxes, const P& predicate, const std::vector<std::size_t>& indices, const std::vector<std::uint64_t>& mask) {
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0u; i < boxes.size(); ++i) {
+            if (predicate(boxes[i])) {
+                expected.push_back(i);
+            }
+        }
+        CHECK(indices == expected);
+
+        REQUIRE(mask.size() == (boxes.size() + 63u) / 64u);
+        std::vector<std::size_t> fromMask;
+        for (std::size_t i = 0u; i < mask.size() * 64u; ++i) {
+            if ((mask[i / 64u] >> (i % 64u)) & 1u) {
+                fromMask.push_back(i);
+            }
+        }
+        CHECK(fromMask == expected);
+    }
+
+    template <typename T>
+    static void check_bbox_soa_queries(const bbox<T,3>& query, const std::vector<bbox<T,3>>& boxes) {
+        const auto soa = bbox_soa<T,3>(std::begin(boxes), std::end(boxes));
+        check_bbox_soa_results(boxes, [&](const bbox<T,3>& b) { return query.intersects(b); }, find_intersecting(query, soa), intersecting_mask(query, soa));
+        check_bbox_soa_results(boxes, [&](const bbox<T,3>& b) { return query.contains(b); }, find_contained(query, soa), contained_mask(query, soa));
+        check_bbox_soa_results(boxes, [&](const bbox<T,3>& b) { return query.encloses(b); }, find_enclosed(query, soa), enclosed_mask(query, soa));
+    }
+
+    TEST_CASE("bbox_soa.constructor") {
+        const auto boxes = std::vector<bbox3f> {
+            bbox3f(vec3f(-1.0f, -2.0f, -3.0f), vec3f(1.0f, 2.0f, 3.0f)),
+            bbox3f(vec3f( 4.0f,  5.0f,  6.0f), vec3f(7.0f, 8.0f, 9.0f))
+        };
+
+        const auto empty = bbox_soa<float,3>();
+        CHECK(empty.empty());
+        CHECK(empty.size() == 0u);
+
+        auto soa = bbox_soa<float,3>(std::begin(boxes), std::end(boxes));
+        CHECK_FALSE(soa.empty());
+        CHECK(soa.size() == 2u);
+        CHECK(soa[0] == boxes[0]);
+        CHECK(soa[1] == boxes[1]);
+        CHECK(soa.min_data(1)[1] == 5.0f);
+        CHECK(soa.max_data(2)[0] == 3.0f);
+
+        soa.set(0u, boxes[1]);
+        CHECK(soa[0] == boxes[1]);
+
+        soa.push_back(boxes[0]);
+        CHECK(soa.size() == 3u);
+        CHECK(soa[2] == boxes[0]);
+
+        soa.clear();
+        CHECK(soa.empty());
+    }
+
+    TEST_CASE("bbox_soa.queries") {
+        const auto query = bbox3f(vec3f(-1.0f, 0.0f, -1.0f), vec3f(1.0f, 1.0f, 2.0f));
+        const auto boxes = std::vector<bbox3f> {
+            bbox3f(vec3f(-0.5f, 0.2f, 0.0f), vec3f(0.5f, 0.8f, 1.0f)),   // enclosed
+            bbox3f(vec3f(-1.0f, 0.0f, 0.0f), vec3f(0.5f, 0.8f, 1.0f)),   // contained, touches the query from inside
+            bbox3f(vec3f( 1.0f, 0.0f, 0.0f), vec3f(2.0f, 0.8f, 1.0f)),   // intersects, touches the query from outside
+            bbox3f(vec3f( 0.0f, 0.0f, 0.0f), vec3f(2.0f, 0.8f, 1.0f)),   // intersects
+            bbox3f(vec3f( 1.5f, 0.0f, 0.0f), vec3f(2.0f, 0.8f, 1.0f)),   // disjoint
+            bbox3f(vec3f(-2.0f, -1.0f, -2.0f), vec3f(2.0f, 2.0f, 3.0f))  // encloses the query
+        };
+        const auto soa = bbox_soa<float,3>(std::begin(boxes), std::end(boxes));
+
+        CHECK(find_intersecting(query, soa) == std::vector<std::size_t>{ 0u, 1u, 2u, 3u, 5u });
+        CHECK(find_contained(query, soa) == std::vector<std::size_t>{ 0u, 1u });
+        CHECK(find_enclosed(query, soa) == std::vector<std::size_t>{ 0u });
+
+        CHECK(intersecting_mask(query, soa) == std::vector<std::uint64_t>{ 0x2Fu });
+        CHECK(contained_mask(query, soa) == std::vector<std::uint64_t>{ 0x03u });
+        CHECK(enclosed_mask(query, soa) == std::vector<std::uint64_t>{ 0x01u });
+
+        const auto none = bbox_soa<float,3>();
+        CHECK(find_intersecting(query, none).empty());
+        CHECK(intersecting_mask(query, none).empty());
+    }
+
+    TEST_CASE("bbox_soa.queries_match_bbox") {
+        const auto query = bbox3f(vec3f(-3.0f, -2.0f, 0.0f), vec3f(4.0f, 3.0f, 5.0f));
+
+        // sizes which leave a partial block for every pack width and which span several mask words
+        for (const std::size_t count : { 1u, 3u, 7u, 13u, 64u, 65u, 1001u }) {
+            auto boxes = random_boxes<double>(count, static_cast<unsigned>(count), { -8.0, 8.0 }, { 0.0, 6.0 });
+            // snap to an integer grid, so that many boxes touch the query box or share its faces
+            for (auto& b : boxes) {
+                b = bbox3d(round(b.min), round(b.max));
+            }
+            check_bbox_soa_queries(query, std::vector<bbox3f>(std::begin(boxes), std::end(boxes)));
+            check_bbox_soa_queries(bbox3d(query), boxes);
+        }
+    }
+
+    TEST_CASE("bbox_soa.queries_nan") {
+        const auto query = bbox3d(vec3d(-1.0, -1.0, -1.0), vec3d(1.0, 1.0, 1.0));
+        const auto boxes = std::vector<bbox3d> {
+            bbox3d(vec3d(nan<double>(), 0.0, 0.0), vec3d(0.5, 0.5, 0.5)),
+            bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(0.5, nan<double>(), 0.5)),
+            bbox3d(vec3d(nan<double>(), nan<double>(), nan<double>()), vec3d(nan<double>(), nan<double>(), nan<double>())),
+            bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(0.5, 0.5, 0.5))
+        };
+        check_bbox_soa_queries(query, boxes);
+    }
+}
@@ -21,9 +21,11 @@
 #include <vecmath/bbox_io.h>
 #include <vecmath/vec.h>
 #include <vecmath/mat_ext.h>
+#include <vecmath/affine.h>
 
 #include "test_utils.h"
 
+#include <random>
 #include <sstream>
 #include <vector>
 
@@ -208,6 +210,63 @@ namespace vm {
         CER_CHECK(bounds.transform(transform).max == transformed.max);
     }
 
+    /**
+     * Transforms the exact corners of the given box one by one, summing the products in the same order as the
+     * generic matrix vector product.
+     */
+    template <typename T>
+    static bbox<T,3> transformVertices(const bbox<T,3>& bounds, const mat<T,4,4>& transform) {
+        typename bbox<T,3>::builder builder;
+        for (size_t i = 0; i < 8u; ++i) {
+            const auto corner = vec<T,4>(
+                (i & 1u) ? bounds.max[0] : bounds.min[0],
+                (i & 2u) ? bounds.max[1] : bounds.min[1],
+                (i & 4u) ? bounds.max[2] : bounds.min[2],
+                T(1.0));
+            vec<T,4> transformed;
+            for (size_t r = 0; r < 4u; ++r) {
+                for (size_t c = 0; c < 4u; ++c) {
+                    transformed[r] += transform[c][r] * corner[c];
+                }
+            }
+            builder.add(to_cartesian_coords(transformed));
+        }
+        return builder.bounds();
+    }
+
+    TEST_CASE("bbox.transform_affine") {
+        constexpr auto bounds = bbox3d(vec3d(-2.0, 1.0, 3.0), vec3d(5.0, 2.0, 7.0));
+        constexpr auto transform = translation_matrix(vec3d(1.0, -2.0, 3.0)) * scaling_matrix(vec3d(-0.5, 2.0, 3.0));
+        CER_CHECK(bounds.transform(transform) == bbox3d(vec3d(-1.5, 0.0, 12.0), vec3d(2.0, 2.0, 24.0)));
+        CER_CHECK(bounds.transform(affine3d(transform)) == bounds.transform(transform));
+
+        // the result matches the bounds of the transformed vertices up to rounding
+        std::mt19937 rng(3u);
+        std::uniform_real_distribution<double> dist(-10.0, 10.0);
+        for (size_t i = 0; i < 100u; ++i) {
+            const auto a = vec3d(dist(rng), dist(rng), dist(rng));
+            const auto b = vec3d(dist(rng), dist(rng), dist(rng));
+            const auto box = bbox3d(min(a, b), max(a, b));
+
+            const auto m = translation_matrix(vec3d(dist(rng), dist(rng), dist(rng)))
+                * rotation_matrix(dist(rng), dist(rng), dist(rng))
+                * scaling_matrix(vec3d(dist(rng), dist(rng), dist(rng)));
+            const auto expected = transformVertices(box, m);
+            CHECK(is_equal(box.transform(m), expected, 0.000001));
+            CHECK(is_equal(box.transform(affine3d(m)), expected, 0.000001));
+
+            const auto boxf = bbox3f(box);
+            const auto mf = mat4x4f(m);
+            CHECK(is_equal(boxf.transform(affine3f(mf)), transformVertices(boxf, mf), 0.001f));
+        }
+    }
+
+    TEST_CASE("bbox.transform_projective") {
+        const auto bounds = bbox3d(vec3d(-2.0, -1.0, -30.0), vec3d(5.0, 2.0, -10.0));
+        const auto transform = perspective_matrix(90.0, 1.0, 100.0, 640, 480);
+        CHECK(is_equal(bounds.transform(transform), transformVertices(bounds, transform), 0.000001));
+    }
+
     TEST_CASE("bbox.operator_equal") {
         constexpr auto min =  vec3f(-1, -2, -3);
         constexpr auto max =  vec3f( 1,  2,  3);
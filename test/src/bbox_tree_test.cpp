@@ -0,0 +1,290 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/bbox_tree.h>
+#include <vecmath/intersection.h>
+#include <vecmath/ray.h>
+#include <vecmath/scalar.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    using tree3d = bbox_tree<double, 3, std::size_t>;
+
+    static constexpr auto box_positions = std::make_pair(-100.0, 100.0);
+    static constexpr auto box_extents = std::make_pair(0.1, 8.0);
+
+    static std::set<std::size_t> query_ids(const tree3d& tree, const bbox3d& b) {
+        std::set<std::size_t> result;
+        tree.query(b, [&](const std::size_t id) {
+            result.insert(id);
+            return true;
+        });
+        return result;
+    }
+
+    TEST_CASE("bbox_tree.empty") {
+        const tree3d tree(0.5);
+        CHECK(tree.empty());
+        CHECK(tree.size() == 0u);
+        CHECK(tree.height() == 0u);
+        CHECK(query_ids(tree, bbox3d(100.0)).empty());
+
+        const auto [distance, id] = tree.intersect_closest(ray3d(vec3d::zero(), vec3d::pos_x()), [](const std::size_t) { return 0.0; });
+        CHECK(is_nan(distance));
+        CHECK(id == tree3d::invalid_id);
+    }
+
+    TEST_CASE("bbox_tree.insert_remove") {
+        tree3d tree(0.5);
+
+        const auto a = tree.insert(bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(1.0, 1.0, 1.0)), 10u);
+        const auto b = tree.insert(bbox3d(vec3d(5.0, 0.0, 0.0), vec3d(6.0, 1.0, 1.0)), 11u);
+        CHECK(tree.size() == 2u);
+        CHECK(tree.height() == 1u);
+        CHECK(tree.is_valid(a));
+        CHECK(tree.data(a) == 10u);
+        CHECK(tree.data(b) == 11u);
+        CHECK(tree.fat_bounds(a) == bbox3d(vec3d(-0.5, -0.5, -0.5), vec3d(1.5, 1.5, 1.5)));
+        CHECK(tree.bounds() == bbox3d(vec3d(-0.5, -0.5, -0.5), vec3d(6.5, 1.5, 1.5)));
+
+        CHECK(query_ids(tree, bbox3d(vec3d(1.2, 0.0, 0.0), vec3d(1.3, 1.0, 1.0))) == std::set<std::size_t>{ a });
+        CHECK(query_ids(tree, bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(5.0, 1.0, 1.0))) == std::set<std::size_t>{ a, b });
+
+        tree.remove(a);
+        CHECK(tree.size() == 1u);
+        CHECK_FALSE(tree.is_valid(a));
+        CHECK(tree.is_valid(b));
+        CHECK(tree.data(b) == 11u);
+        CHECK(tree.height() == 0u);
+        CHECK(query_ids(tree, bbox3d(100.0)) == std::set<std::size_t>{ b });
+
+        tree.remove(b);
+        CHECK(tree.empty());
+        CHECK(query_ids(tree, bbox3d(100.0)).empty());
+    }
+
+    TEST_CASE("bbox_tree.move") {
+        tree3d tree(0.5);
+        const auto id = tree.insert(bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(1.0, 1.0, 1.0)));
+        const auto other = tree.insert(bbox3d(vec3d(10.0, 0.0, 0.0), vec3d(11.0, 1.0, 1.0)));
+
+        // small movements stay within the fat bounds
+        CHECK_FALSE(tree.move(id, bbox3d(vec3d(0.3, 0.0, 0.0), vec3d(1.3, 1.0, 1.0))));
+        CHECK(tree.fat_bounds(id) == bbox3d(vec3d(-0.5, -0.5, -0.5), vec3d(1.5, 1.5, 1.5)));
+
+        // larger movements reinsert the box, and the fat bounds are extended by the displacement
+        CHECK(tree.move(id, bbox3d(vec3d(2.0, 0.0, 0.0), vec3d(3.0, 1.0, 1.0)), vec3d(10.0, 0.0, -1.0)));
+        CHECK(tree.fat_bounds(id) == bbox3d(vec3d(1.5, -0.5, -1.5), vec3d(13.5, 1.5, 1.5)));
+        CHECK(tree.is_valid(id));
+        CHECK(tree.is_valid(other));
+        CHECK(query_ids(tree, bbox3d(vec3d(4.0, 0.0, 0.0), vec3d(4.5, 1.0, 1.0))) == std::set<std::size_t>{ id });
+        CHECK(query_ids(tree, bbox3d(vec3d(10.0, 0.0, 0.0), vec3d(10.5, 1.0, 1.0))) == std::set<std::size_t>{ id, other });
+
+        // fat bounds that are much too large are shrunk
+        CHECK(tree.move(id, bbox3d(vec3d(2.0, 0.0, 0.0), vec3d(3.0, 1.0, 1.0))));
+        CHECK(tree.fat_bounds(id) == bbox3d(vec3d(1.5, -0.5, -0.5), vec3d(3.5, 1.5, 1.5)));
+    }
+
+    TEST_CASE("bbox_tree.ids_are_stable") {
+        tree3d tree(0.1);
+        auto rng = std::mt19937(3u);
+
+        std::vector<std::pair<std::size_t, bbox3d>> boxes;
+        for (std::size_t i = 0u; i < 500u; ++i) {
+            const auto b = random_box(rng, box_positions, box_extents);
+            boxes.emplace_back(tree.insert(b, i), b);
+        }
+
+        // remove every other box, the remaining ids and their data are unchanged
+        for (std::size_t i = 0u; i < boxes.size(); i += 2u) {
+            tree.remove(boxes[i].first);
+        }
+        for (std::size_t i = 1u; i < boxes.size(); i += 2u) {
+            CHECK(tree.is_valid(boxes[i].first));
+            CHECK(tree.data(boxes[i].first) == i);
+            CHECK(tree.fat_bounds(boxes[i].first) == boxes[i].second.expand(0.1));
+        }
+
+        // removed ids are reused
+        std::set<std::size_t> removed;
+        for (std::size_t i = 0u; i < boxes.size(); i += 2u) {
+            removed.insert(boxes[i].first);
+        }
+        const auto reused = tree.insert(random_box(rng, box_positions, box_extents));
+        CHECK(tree.size() == 251u);
+        CHECK(tree.is_valid(reused));
+        CHECK(std::any_of(std::begin(removed), std::end(removed), [&](const std::size_t id) { return id == reused; }));
+    }
+
+    TEST_CASE("bbox_tree.balance") {
+        // inserting boxes in sorted order degenerates into a list without rotations
+        tree3d tree(0.0);
+        std::vector<std::size_t> ids;
+        for (std::size_t i = 0u; i < 1024u; ++i) {
+            const auto x = static_cast<double>(i);
+            ids.push_back(tree.insert(bbox3d(vec3d(x, 0.0, 0.0), vec3d(x + 0.5, 1.0, 1.0))));
+        }
+        CHECK(tree.height() <= 15u);
+
+        for (std::size_t i = 0u; i < 1000u; ++i) {
+            tree.remove(ids[i]);
+        }
+        CHECK(tree.height() <= 6u);
+    }
+
+    TEST_CASE("bbox_tree.queries") {
+        tree3d tree(0.2);
+        auto rng = std::mt19937(7u);
+        auto coin = std::uniform_int_distribution<int>(0, 2);
+        auto offset = std::uniform_real_distribution<double>(-3.0, 3.0);
+
+        // maps ids to the current bounds
+        std::vector<std::pair<std::size_t, bbox3d>> boxes;
+        for (std::size_t i = 0u; i < 300u; ++i) {
+            const auto b = random_box(rng, box_positions, box_extents);
+            boxes.emplace_back(tree.insert(b, i), b);
+        }
+
+        // random edits
+        for (std::size_t i = 0u; i < 600u; ++i) {
+            const auto action = coin(rng);
+            const auto index = std::uniform_int_distribution<std::size_t>(0u, boxes.size() - 1u)(rng);
+            if (action == 0) {
+                tree.remove(boxes[index].first);
+                boxes.erase(std::begin(boxes) + static_cast<std::ptrdiff_t>(index));
+            } else if (action == 1) {
+                const auto b = random_box(rng, box_positions, box_extents);
+                boxes.emplace_back(tree.insert(b), b);
+            } else {
+                const auto displacement = vec3d(offset(rng), offset(rng), offset(rng));
+                auto& [id, b] = boxes[index];
+                b = b.translate(displacement);
+                tree.move(id, b, displacement);
+            }
+        }
+        REQUIRE(tree.size() == boxes.size());
+
+        for (const auto& [id, b] : boxes) {
+            REQUIRE(tree.is_valid(id));
+            CHECK(tree.fat_bounds(id).contains(b));
+            CHECK(tree.bounds().contains(tree.fat_bounds(id)));
+        }
+
+        SECTION("box queries") {
+            for (std::size_t i = 0u; i < 100u; ++i) {
+                const auto query = random_box(rng, box_positions, box_extents).expand(5.0);
+                std::set<std::size_t> expected;
+                for (const auto& entry : boxes) {
+                    if (tree.fat_bounds(entry.first).intersects(query)) {
+                        expected.insert(entry.first);
+                    }
+                }
+                CHECK(query_ids(tree, query) == expected);
+            }
+
+            // stopping a query
+            std::size_t visited = 0u;
+            tree.query(bbox3d(1000.0), [&](const std::size_t) {
+                ++visited;
+                return false;
+            });
+            CHECK(visited == 1u);
+        }
+
+        SECTION("pair queries") {
+            std::set<std::pair<std::size_t, std::size_t>> expected;
+            for (std::size_t i = 0u; i < boxes.size(); ++i) {
+                for (std::size_t j = i + 1u; j < boxes.size(); ++j) {
+                    const auto a = boxes[i].first;
+                    const auto b = boxes[j].first;
+                    if (tree.fat_bounds(a).intersects(tree.fat_bounds(b))) {
+                        expected.insert(std::make_pair(std::min(a, b), std::max(a, b)));
+                    }
+                }
+            }
+
+            std::set<std::pair<std::size_t, std::size_t>> actual;
+            std::size_t count = 0u;
+            tree.query_pairs([&](const std::size_t a, const std::size_t b) {
+                CHECK(a < b);
+                actual.insert(std::make_pair(a, b));
+                ++count;
+            });
+            CHECK(count == actual.size());
+            CHECK(actual == expected);
+        }
+
+        SECTION("ray queries") {
+            const auto bounds_of = [&](const std::size_t id) {
+                const auto it = std::find_if(std::begin(boxes), std::end(boxes), [&](const auto& entry) { return entry.first == id; });
+                return it->second;
+            };
+
+            auto position = std::uniform_real_distribution<double>(-120.0, 120.0);
+            for (std::size_t i = 0u; i < 100u; ++i) {
+                const auto origin = vec3d(position(rng), position(rng), position(rng));
+                const auto target = vec3d(offset(rng), offset(rng), offset(rng)) * 10.0;
+                const auto r = ray3d(origin, normalize(target - origin));
+                const auto intersect = [&](const std::size_t id) {
+                    return intersect_ray_bbox(r, bounds_of(id));
+                };
+
+                auto expectedDistance = std::numeric_limits<double>::infinity();
+                auto expectedId = tree3d::invalid_id;
+                for (const auto& [id, b] : boxes) {
+                    const auto distance = intersect_ray_bbox(r, b);
+                    if (!is_nan(distance) && distance < expectedDistance) {
+                        expectedDistance = distance;
+                        expectedId = id;
+                    }
+                }
+
+                const auto [distance, id] = tree.intersect_closest(r, intersect);
+                const auto [hit, hitId] = tree.intersect_any(r, intersect);
+                if (expectedId == tree3d::invalid_id) {
+                    CHECK(is_nan(distance));
+                    CHECK(id == tree3d::invalid_id);
+                    CHECK_FALSE(hit);
+                } else {
+                    CHECK(distance == approx(expectedDistance));
+                    CHECK(intersect(id) == approx(expectedDistance));
+                    CHECK(hit);
+                    CHECK_FALSE(is_nan(intersect(hitId)));
+                }
+            }
+        }
+    }
+}
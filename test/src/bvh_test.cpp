@@ -0,0 +1,265 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/bvh.h>
+#include <vecmath/intersection.h>
+#include <vecmath/ray.h>
+#include <vecmath/scalar.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+
+#include "test_utils.h"
+
+#include <array>
+#include <cstddef>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    using triangle = std::array<vec3d, 3>;
+
+    static std::vector<triangle> make_triangles(const std::size_t count) {
+        auto rng = std::mt19937(5u);
+        auto position = std::uniform_real_distribution<double>(-100.0, 100.0);
+        auto offset = std::uniform_real_distribution<double>(-5.0, 5.0);
+
+        std::vector<triangle> result;
+        for (std::size_t i = 0u; i < count; ++i) {
+            const auto p = vec3d(position(rng), position(rng), position(rng));
+            result.push_back({
+                p + vec3d(offset(rng), offset(rng), offset(rng)),
+                p + vec3d(offset(rng), offset(rng), offset(rng)),
+                p + vec3d(offset(rng), offset(rng), offset(rng))
+            });
+        }
+        return result;
+    }
+
+    static bbox3d triangle_bounds(const triangle& t) {
+        return bbox3d::merge_all(std::begin(t), std::end(t));
+    }
+
+    static std::vector<ray3d> make_rays(const std::size_t count) {
+        auto rng = std::mt19937(9u);
+        auto position = std::uniform_real_distribution<double>(-120.0, 120.0);
+        auto direction = std::uniform_real_distribution<double>(-1.0, 1.0);
+
+        std::vector<ray3d> result;
+        for (std::size_t i = 0u; i < count; ++i) {
+            const auto origin = vec3d(position(rng), position(rng), position(rng));
+            // aim roughly at the center so that most rays hit something
+            const auto target = vec3d(direction(rng), direction(rng), direction(rng)) * 50.0;
+            result.emplace_back(origin, normalize(target - origin));
+        }
+
+        // axis aligned rays have zero direction components
+        result.emplace_back(vec3d(-150.0, 0.0, 0.0), vec3d::pos_x());
+        result.emplace_back(vec3d(0.0, 150.0, 0.0), vec3d::neg_y());
+        return result;
+    }
+
+    static void check_bvh_structure(const bvh<double>& tree, const std::size_t primitiveCount) {
+        const auto& nodes = tree.nodes();
+        REQUIRE_FALSE(nodes.empty());
+
+        std::vector<std::size_t> seen(primitiveCount, 0u);
+        std::size_t leafPrimitives = 0u;
+        for (std::size_t i = 0u; i < nodes.size(); ++i) {
+            const auto& n = nodes[i];
+            if (n.is_leaf()) {
+                for (std::size_t j = n.offset; j < n.offset + n.count; ++j) {
+                    ++seen[tree.primitives()[j]];
+                }
+                leafPrimitives += n.count;
+            } else {
+                // depth first layout: the first child follows its parent
+                REQUIRE(i + 1u < nodes.size());
+                REQUIRE(n.offset > i + 1u);
+                REQUIRE(n.offset < nodes.size());
+                CHECK(n.bounds.contains(nodes[i + 1u].bounds));
+                CHECK(n.bounds.contains(nodes[n.offset].bounds));
+            }
+        }
+
+        CHECK(leafPrimitives == primitiveCount);
+        for (const auto count : seen) {
+            CHECK(count == 1u);
+        }
+    }
+
+    TEST_CASE("bvh.empty") {
+        const auto tree = bvh<double>();
+        CHECK(tree.empty());
+
+        const auto r = ray3d(vec3d::zero(), vec3d::pos_x());
+        const auto [distance, primitive] = tree.intersect_closest(r, [](const std::size_t) { return 0.0; });
+        CHECK(is_nan(distance));
+        CHECK(primitive == 0u);
+        CHECK_FALSE(std::get<0>(tree.intersect_any(r, [](const std::size_t) { return 0.0; })));
+    }
+
+    TEST_CASE("bvh.single_primitive") {
+        const auto boxes = std::vector<bbox3d>{ bbox3d(vec3d(1, -1, -1), vec3d(2, 1, 1)) };
+        const auto tree = bvh<double>(std::begin(boxes), std::end(boxes), [](const bbox3d& b) { return b; });
+        CHECK(tree.nodes().size() == 1u);
+        CHECK(tree.bounds() == boxes.front());
+
+        const auto r = ray3d(vec3d::zero(), vec3d::pos_x());
+        const auto intersect = [&](const std::size_t i) { return intersect_ray_bbox(r, boxes[i]); };
+        const auto [distance, primitive] = tree.intersect_closest(r, intersect);
+        CHECK(distance == approx(1.0));
+        CHECK(primitive == 0u);
+
+        CHECK(std::get<0>(tree.intersect_any(r, intersect)));
+        CHECK_FALSE(std::get<0>(tree.intersect_any(r, intersect, 0.5)));
+        CHECK_FALSE(std::get<0>(tree.intersect_any(ray3d(vec3d::zero(), vec3d::neg_x()), intersect)));
+    }
+
+    TEST_CASE("bvh.coincident_primitives") {
+        // primitives with identical centers cannot be separated by a split plane
+        const auto boxes = std::vector<bbox3d>(37u, bbox3d(vec3d(-1, -1, -1), vec3d(1, 1, 1)));
+        const auto tree = bvh<double>(std::begin(boxes), std::end(boxes), [](const bbox3d& b) { return b; }, 4u);
+        check_bvh_structure(tree, boxes.size());
+
+        const auto r = ray3d(vec3d(-5, 0, 0), vec3d::pos_x());
+        const auto [distance, primitive] = tree.intersect_closest(r, [&](const std::size_t i) { return intersect_ray_bbox(r, boxes[i]); });
+        CHECK(distance == approx(4.0));
+        CHECK(primitive < boxes.size());
+    }
+
+    TEST_CASE("bvh.intersect_closest") {
+        const auto triangles = make_triangles(1000u);
+        const auto tree = bvh<double>(std::begin(triangles), std::end(triangles), triangle_bounds);
+        check_bvh_structure(tree, triangles.size());
+
+        std::size_t hits = 0u;
+        for (const auto& r : make_rays(200u)) {
+            const auto intersect = [&](const std::size_t i) {
+                const auto& t = triangles[i];
+                return intersect_ray_triangle(r, t[0], t[1], t[2]);
+            };
+
+            auto expectedDistance = nan<double>();
+            auto expectedPrimitive = triangles.size();
+            for (std::size_t i = 0u; i < triangles.size(); ++i) {
+                const auto distance = intersect(i);
+                if (distance >= 0.0 && !(distance >= expectedDistance)) {
+                    expectedDistance = distance;
+                    expectedPrimitive = i;
+                }
+            }
+
+            const auto [distance, primitive] = tree.intersect_closest(r, intersect);
+            if (expectedPrimitive == triangles.size()) {
+                CHECK(is_nan(distance));
+                CHECK(primitive == triangles.size());
+            } else {
+                ++hits;
+                CHECK(distance == approx(expectedDistance));
+                CHECK(primitive == expectedPrimitive);
+            }
+        }
+        CHECK(hits > 0u);
+    }
+
+    TEST_CASE("bvh.intersect_any") {
+        const auto triangles = make_triangles(1000u);
+        const auto tree = bvh<double>(std::begin(triangles), std::end(triangles), triangle_bounds, 2u);
+        check_bvh_structure(tree, triangles.size());
+
+        for (const auto& r : make_rays(200u)) {
+            const auto intersect = [&](const std::size_t i) {
+                const auto& t = triangles[i];
+                return intersect_ray_triangle(r, t[0], t[1], t[2]);
+            };
+
+            for (const auto maxDistance : { 50.0, 150.0 }) {
+                auto expected = false;
+                for (std::size_t i = 0u; i < triangles.size() && !expected; ++i) {
+                    const auto distance = intersect(i);
+                    expected = distance >= 0.0 && distance <= maxDistance;
+                }
+
+                const auto [hit, primitive] = tree.intersect_any(r, intersect, maxDistance);
+                CHECK(hit == expected);
+                if (hit) {
+                    CHECK(intersect(primitive) <= maxDistance);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("bvh.build_linear") {
+        const auto empty = std::vector<bbox3d>();
+        CHECK(bvh<double>::build_linear(std::begin(empty), std::end(empty), [](const bbox3d& b) { return b; }).empty());
+
+        const auto single = std::vector<bbox3d>{ bbox3d(vec3d(1, -1, -1), vec3d(2, 1, 1)) };
+        const auto singleTree = bvh<double>::build_linear(std::begin(single), std::end(single), [](const bbox3d& b) { return b; });
+        CHECK(singleTree.nodes().size() == 1u);
+        CHECK(singleTree.bounds() == single.front());
+
+        // primitives with identical codes are separated by their position
+        const auto coincident = std::vector<bbox3d>(37u, bbox3d(vec3d(-1, -1, -1), vec3d(1, 1, 1)));
+        const auto coincidentTree = bvh<double>::build_linear(std::begin(coincident), std::end(coincident), [](const bbox3d& b) { return b; });
+        check_bvh_structure(coincidentTree, coincident.size());
+        CHECK(coincidentTree.nodes().size() == 2u * coincident.size() - 1u);
+
+        const auto triangles = make_triangles(3000u);
+        for (const auto maxLeafSize : { std::size_t(1u), std::size_t(4u) }) {
+            const auto tree = bvh<double>::build_linear(std::begin(triangles), std::end(triangles), triangle_bounds, maxLeafSize);
+            check_bvh_structure(tree, triangles.size());
+            for (const auto& n : tree.nodes()) {
+                CHECK(n.count <= maxLeafSize);
+            }
+
+            // the result does not depend on the number of threads
+            const auto other = bvh<double>::build_linear(std::begin(triangles), std::end(triangles), triangle_bounds, maxLeafSize, 3u);
+            CHECK(other.primitives() == tree.primitives());
+            CHECK(other.nodes().size() == tree.nodes().size());
+
+            for (const auto& r : make_rays(100u)) {
+                const auto intersect = [&](const std::size_t i) {
+                    const auto& t = triangles[i];
+                    return intersect_ray_triangle(r, t[0], t[1], t[2]);
+                };
+
+                auto expectedDistance = nan<double>();
+                for (std::size_t i = 0u; i < triangles.size(); ++i) {
+                    const auto distance = intersect(i);
+                    if (distance >= 0.0 && !(distance >= expectedDistance)) {
+                        expectedDistance = distance;
+                    }
+                }
+
+                const auto distance = std::get<0>(tree.intersect_closest(r, intersect));
+                if (is_nan(expectedDistance)) {
+                    CHECK(is_nan(distance));
+                } else {
+                    // the intersection may be contracted differently inside the tree traversal
+                    CHECK(distance == approx(expectedDistance));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/frustum.h>
+#include <vecmath/mat.h>
+#include <vecmath/mat_ext.h>
+#include <vecmath/plane.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    // a frustum looking down the negative z axis from (0, 0, 10), with near and far planes at z = 9 and z = -90
+    template <typename T>
+    static frustum<T> make_perspective_frustum() {
+        const auto projection = perspective_matrix<T>(T(90.0), T(1.0), T(100.0), 400, 300);
+        const auto view = translation_matrix(vec<T,3>(T(0.0), T(0.0), T(-10.0)));
+        return frustum<T>(projection * view);
+    }
+
+    TEST_CASE("frustum.from_ortho_matrix") {
+        CER_CHECK(frustumd().contains(vec3d(1000, -1000, 1000)));
+
+        constexpr auto f = frustumd(ortho_matrix(1.0, 3.0, -4.0, 3.0, 4.0, -3.0));
+        CER_CHECK(f.planes[0] == plane3d(-4.0, vec3d::pos_x()));
+        CER_CHECK(f.planes[1] == plane3d(-4.0, vec3d::neg_x()));
+        CER_CHECK(f.planes[2] == plane3d(-3.0, vec3d::pos_y()));
+        CER_CHECK(f.planes[3] == plane3d(-3.0, vec3d::neg_y()));
+        CER_CHECK(f.planes[4] == plane3d(1.0, vec3d::neg_z()));
+        CER_CHECK(f.planes[5] == plane3d(-3.0, vec3d::pos_z()));
+
+        CER_CHECK(f.contains(vec3d(0, 0, -1)));
+        CER_CHECK(f.contains(vec3d(4, 3, -3)));
+        CER_CHECK_FALSE(f.contains(vec3d(0, 0, 0)));
+        CER_CHECK_FALSE(f.contains(vec3d(4.5, 0, -2)));
+        CER_CHECK_FALSE(f.contains(vec3d(0, 0, -3.5)));
+    }
+
+    TEST_CASE("frustum.from_perspective_matrix") {
+        const auto f = make_perspective_frustum<double>();
+        for (const auto& p : f.planes) {
+            CHECK(length(p.normal) == approx(1.0));
+        }
+        CHECK(f.planes[4].point_distance(vec3d(0, 0, 10)) == approx(-1.0));
+        CHECK(f.planes[5].point_distance(vec3d(0, 0, 10)) == approx(100.0));
+
+        CHECK(f.contains(vec3d(0, 0, 0)));
+        CHECK(f.contains(vec3d(0, 0, -89)));
+        CHECK_FALSE(f.contains(vec3d(0, 0, -91)));
+        CHECK_FALSE(f.contains(vec3d(0, 0, 9.5)));
+        CHECK_FALSE(f.contains(vec3d(0, 50, 0)));
+        CHECK_FALSE(f.contains(vec3d(-50, 0, 0)));
+    }
+
+    TEST_CASE("frustum.classify") {
+        const auto f = make_perspective_frustum<double>();
+        CHECK(f.classify(bbox3d(vec3d(-1, -1, -1), vec3d(1, 1, 1))) == frustum_status::inside);
+        CHECK(f.classify(bbox3d(vec3d(-1, -1, -100), vec3d(1, 1, -80))) == frustum_status::intersecting);
+        CHECK(f.classify(bbox3d(vec3d(-1, -1, 11), vec3d(1, 1, 12))) == frustum_status::outside);
+        CHECK(f.classify(bbox3d(vec3d(50, -1, -1), vec3d(51, 1, 1))) == frustum_status::outside);
+
+        // only the far plane is intersected
+        std::uint8_t mask = frustumd::all_planes;
+        CHECK(f.classify(bbox3d(vec3d(-1, -1, -100), vec3d(1, 1, -80)), mask) == frustum_status::intersecting);
+        CHECK(mask == 1u << 5u);
+
+        // planes that are not in the mask are not tested
+        mask = 1u << 4u;
+        CHECK(f.classify(bbox3d(vec3d(-1, -1, -100), vec3d(1, 1, -80)), mask) == frustum_status::inside);
+        CHECK(mask == 0u);
+
+        CHECK(f.classify(vec3d(0, 0, 0), 1.0) == frustum_status::inside);
+        CHECK(f.classify(vec3d(0, 0, -90), 1.0) == frustum_status::intersecting);
+        CHECK(f.classify(vec3d(0, 0, 12), 1.0) == frustum_status::outside);
+    }
+
+    template <typename T>
+    static void check_batched_classify(const std::size_t count) {
+        const auto f = make_perspective_frustum<T>();
+        const auto boxes = random_boxes<T>(count, 23u, { T(-150.0), T(150.0) }, { T(0.0), T(40.0) });
+
+        std::vector<frustum_status> results(count);
+        f.classify(boxes.data(), count, results.data());
+
+        std::size_t statusCounts[3] = {};
+        for (std::size_t i = 0u; i < count; ++i) {
+            CHECK(results[i] == f.classify(boxes[i]));
+            ++statusCounts[static_cast<std::size_t>(results[i])];
+        }
+        if (count > 100u) {
+            CHECK(statusCounts[0] > 0u);
+            CHECK(statusCounts[1] > 0u);
+            CHECK(statusCounts[2] > 0u);
+        }
+
+        std::mt19937 rng(29u);
+        std::uniform_int_distribution<unsigned> planes(0u, frustum<T>::all_planes);
+        std::vector<std::uint8_t> masks(count);
+        for (auto& mask : masks) {
+            mask = static_cast<std::uint8_t>(planes(rng));
+        }
+        auto expectedMasks = masks;
+
+        f.classify(boxes.data(), count, results.data(), masks.data());
+        for (std::size_t i = 0u; i < count; ++i) {
+            CHECK(results[i] == f.classify(boxes[i], expectedMasks[i]));
+            CHECK(masks[i] == expectedMasks[i]);
+        }
+    }
+
+    TEST_CASE("frustum.classify_batched") {
+        check_batched_classify<float>(1003u);
+        check_batched_classify<double>(1003u);
+        check_batched_classify<float>(3u);
+    }
+}
@@ -26,8 +26,14 @@
 #include <vecmath/quat.h>
 #include <vecmath/constexpr_util.h>
 #include <vecmath/intersection.h>
+#include <vecmath/mat_ext.h>
+#include <vecmath/obb.h>
+#include <vecmath/bbox.h>
 
 #include <array>
+#include <cmath>
+#include <random>
+#include <tuple>
 
 #include <catch2/catch.hpp>
 
@@ -180,6 +186,155 @@ namespace vm {
 
     }
 
+    TEST_CASE("intersection.intersect_ray_obb") {
+        // a unit cube rotated by 45 degrees about the Z axis and moved to (5, 0, 0)
+        const auto rotation = rotation_matrix_3x3(quatd(vec3d::pos_z(), to_radians(45.0)));
+        const auto box = obb3d(vec3d(5.0, 0.0, 0.0), rotation, vec3d(1.0, 1.0, 1.0));
+
+        CHECK(intersect_ray_obb(ray3d(vec3d::zero(), vec3d::pos_x()), box) == approx(5.0 - std::sqrt(2.0)));
+        CHECK(is_nan(intersect_ray_obb(ray3d(vec3d::zero(), vec3d::neg_x()), box)));
+        CHECK(is_nan(intersect_ray_obb(ray3d(vec3d(0.0, 1.5, 0.0), vec3d::pos_x()), box)));
+        CHECK(intersect_ray_obb(ray3d(vec3d(0.0, 1.0, 0.0), vec3d::pos_x()), box) == approx(5.0 - std::sqrt(2.0) + 1.0));
+
+        // the origin is inside the box
+        CHECK(intersect_ray_obb(ray3d(vec3d(5.0, 0.0, 0.0), normalize(vec3d(0.0, 1.0, 1.0))), box) == approx(std::sqrt(2.0)));
+
+        // an axis aligned box behaves like a bounding box
+        std::mt19937 rng(8u);
+        std::uniform_real_distribution<double> dist(-20.0, 20.0);
+        const auto bounds = bbox3d(vec3d(-5.0, -2.0, 1.0), vec3d(3.0, 4.0, 7.0));
+        for (size_t i = 0; i < 1000u; ++i) {
+            const auto r = ray3d(vec3d(dist(rng), dist(rng), dist(rng)), normalize(vec3d(dist(rng), dist(rng), dist(rng))));
+            const auto expected = intersect_ray_bbox(r, bounds);
+            const auto actual = intersect_ray_obb(r, obb3d(bounds));
+            CHECK(is_nan(expected) == is_nan(actual));
+            if (!is_nan(expected)) {
+                CHECK(actual == approx(expected));
+            }
+        }
+    }
+
+    TEST_CASE("intersection.intersect_ray_bbox_interval") {
+        constexpr auto bounds = bbox3f(vec3f(-12.0f, -3.0f,  4.0f), vec3f(  8.0f,  9.0f,  8.0f));
+
+        constexpr auto miss = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f::zero(), vec3f(1.0f, 1.0f, -2.0f))), bounds);
+        CER_CHECK(std::get<0>(miss) > std::get<1>(miss));
+
+        // distances are measured in multiples of the ray direction
+        constexpr auto hit = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f::zero(), vec3f(1.0f, 1.0f, 2.0f))), bounds);
+        CER_CHECK(std::get<0>(hit) == approx(2.0f));
+        CER_CHECK(std::get<1>(hit) == approx(4.0f));
+
+        const auto axisAligned = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f::zero(), vec3f::pos_z())), bounds);
+        CHECK(std::get<0>(axisAligned) == approx(4.0f));
+        CHECK(std::get<1>(axisAligned) == approx(8.0f));
+
+        // the origin is inside the box
+        const auto inside = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f(0.0f, 0.0f, 6.0f), vec3f::neg_z())), bounds);
+        CHECK(std::get<0>(inside) == 0.0f);
+        CHECK(std::get<1>(inside) == approx(2.0f));
+
+        // the interval is clipped
+        const auto clipped = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f::zero(), vec3f::pos_z())), bounds, 0.0f, 3.0f);
+        CHECK(std::get<0>(clipped) > std::get<1>(clipped));
+
+        // a ray on a face of the box, parallel to it
+        const auto grazing = intersect_ray_bbox_interval(ray_precomputed3f(ray3f(vec3f(-20.0f, 9.0f, 6.0f), vec3f::pos_x())), bounds);
+        CHECK(std::get<0>(grazing) == approx(8.0f));
+        CHECK(std::get<1>(grazing) == approx(28.0f));
+
+        std::mt19937 rng(7u);
+        std::uniform_real_distribution<double> dist(-20.0, 20.0);
+        const auto box = bbox3d(vec3d(-5.0, -2.0, 1.0), vec3d(3.0, 4.0, 7.0));
+        for (size_t i = 0; i < 1000u; ++i) {
+            const auto r = ray3d(vec3d(dist(rng), dist(rng), dist(rng)), normalize(vec3d(dist(rng), dist(rng), dist(rng))));
+            if (box.contains(r.origin)) {
+                continue;
+            }
+
+            const auto expected = intersect_ray_bbox(r, box);
+            const auto [near, far] = intersect_ray_bbox_interval(ray_precomputed3d(r), box);
+            if (is_nan(expected)) {
+                CHECK(near > far);
+            } else {
+                CHECK(near <= far);
+                CHECK(near == approx(expected, 1e-9));
+            }
+        }
+    }
+
+    template <typename T, size_t N>
+    static void testIntersectRayBBoxPacket() {
+        std::mt19937 rng(11u);
+        std::uniform_real_distribution<T> dist(T(-20.0), T(20.0));
+        std::uniform_int_distribution<int> axis(0, 3);
+
+        const auto randomRay = [&]() {
+            auto direction = vec<T,3>(dist(rng), dist(rng), dist(rng));
+            // produce axis parallel rays, including negative zeros
+            const auto a = axis(rng);
+            if (a < 3) {
+                direction[static_cast<size_t>(a)] = dist(rng) < T(0.0) ? T(-0.0) : T(0.0);
+            }
+            return ray<T,3>(vec<T,3>(dist(rng), dist(rng), dist(rng)), direction);
+        };
+        const auto randomBox = [&]() {
+            const auto a = vec<T,3>(dist(rng), dist(rng), dist(rng));
+            const auto b = vec<T,3>(dist(rng), dist(rng), dist(rng));
+            return bbox<T,3>(min(a, b), max(a, b));
+        };
+
+        for (size_t k = 0; k < 200u; ++k) {
+            const auto r = randomRay();
+            const auto precomputed = ray_precomputed<T,3>(r);
+
+            bbox<T,3> boxes[N];
+            for (size_t j = 0; j < N; ++j) {
+                boxes[j] = randomBox();
+            }
+            // a partially filled packet must not report hits for its empty lanes
+            const auto count = k % 2u == 0u ? N : N - 1u;
+            const auto packet = bbox_packet<T,3,N>(boxes, count);
+
+            T near[N];
+            const auto mask = intersect_ray_bbox_packet(precomputed, packet, T(0.0), T(30.0), near);
+            for (size_t j = 0; j < count; ++j) {
+                const auto [n, f] = intersect_ray_bbox_interval(precomputed, boxes[j], T(0.0), T(30.0));
+                CHECK(((mask >> j) & 1u) == static_cast<unsigned>(n <= f));
+                if (n <= f) {
+                    CHECK(near[j] == n);
+                }
+            }
+            CHECK((mask >> count) == 0u);
+        }
+
+        for (size_t k = 0; k < 200u; ++k) {
+            ray<T,3> rays[N];
+            for (size_t j = 0; j < N; ++j) {
+                rays[j] = randomRay();
+            }
+            const auto packet = ray_packet<T,3,N>(rays);
+            const auto box = randomBox();
+
+            T near[N];
+            const auto mask = intersect_ray_bbox_packet(packet, box, T(0.0), T(30.0), near);
+            for (size_t j = 0; j < N; ++j) {
+                const auto [n, f] = intersect_ray_bbox_interval(ray_precomputed<T,3>(rays[j]), box, T(0.0), T(30.0));
+                CHECK(((mask >> j) & 1u) == static_cast<unsigned>(n <= f));
+                if (n <= f) {
+                    CHECK(near[j] == n);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("intersection.intersect_ray_bbox_packet") {
+        testIntersectRayBBoxPacket<float,4>();
+        testIntersectRayBBoxPacket<float,8>();
+        testIntersectRayBBoxPacket<double,4>();
+        testIntersectRayBBoxPacket<double,8>();
+    }
+
     TEST_CASE("intersection.intersect_ray_sphere") {
         const ray3f ray(vec3f::zero(), vec3f::pos_z());
 
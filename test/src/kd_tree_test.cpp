@@ -0,0 +1,203 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/distance.h>
+#include <vecmath/kd_tree.h>
+#include <vecmath/ray.h>
+#include <vecmath/scalar.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename T, std::size_t S>
+    static std::vector<vec<T,S>> make_kd_tree_points(const std::size_t count, const unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<T> position(T(-100.0), T(100.0));
+        std::vector<vec<T,S>> result(count);
+        for (std::size_t j = 0u; j < count; ++j) {
+            for (std::size_t i = 0u; i < S; ++i) {
+                // snap some points to a grid to create points with equal coordinates and distances
+                result[j][i] = j % 3u == 0u ? snap(position(rng), T(8.0)) : position(rng);
+            }
+        }
+        return result;
+    }
+
+    template <typename T, std::size_t S>
+    static void check_kd_tree_queries(const std::size_t count) {
+        const auto points = make_kd_tree_points<T,S>(count, 3u);
+        const auto tree = kd_tree<T,S>(std::begin(points), std::end(points));
+        CHECK(tree.size() == points.size());
+        CHECK(tree.bounds() == bbox<T,S>::merge_all(std::begin(points), std::end(points)));
+
+        std::mt19937 rng(7u);
+        std::uniform_real_distribution<T> position(T(-120.0), T(120.0));
+        std::uniform_real_distribution<T> radius(T(0.0), T(30.0));
+        for (std::size_t q = 0u; q < 100u; ++q) {
+            vec<T,S> p, direction;
+            for (std::size_t i = 0u; i < S; ++i) {
+                p[i] = position(rng);
+                direction[i] = position(rng);
+            }
+            // some queries hit points exactly
+            if (q % 10u == 0u) {
+                p = points[q % points.size()];
+            }
+
+            // all points ordered by distance and index
+            std::vector<std::tuple<T, std::size_t>> byDistance;
+            for (std::size_t i = 0u; i < points.size(); ++i) {
+                byDistance.emplace_back(squared_distance(p, points[i]), i);
+            }
+            std::sort(std::begin(byDistance), std::end(byDistance));
+
+            const auto [nearestDistance, nearest] = tree.find_nearest(p);
+            CHECK(nearest == std::get<1>(byDistance.front()));
+            CHECK(nearestDistance == distance(p, points[nearest]));
+
+            for (const auto k : { std::size_t(1u), std::size_t(5u), std::size_t(20u) }) {
+                std::vector<std::size_t> expected;
+                for (std::size_t i = 0u; i < k && i < byDistance.size(); ++i) {
+                    expected.push_back(std::get<1>(byDistance[i]));
+                }
+                CHECK(tree.find_k_nearest(p, k) == expected);
+            }
+
+            const auto r = radius(rng);
+            std::vector<std::size_t> expectedInRadius;
+            std::set<std::size_t> expectedSet;
+            for (const auto& [distance2, i] : byDistance) {
+                if (distance2 <= r * r) {
+                    expectedInRadius.push_back(i);
+                    expectedSet.insert(i);
+                }
+            }
+            CHECK(tree.find_k_nearest(p, 1000u, r) == expectedInRadius);
+
+            std::multiset<std::size_t> inRadius;
+            tree.query_radius(p, r, [&](const std::size_t i) {
+                inRadius.insert(i);
+                return true;
+            });
+            CHECK(inRadius == std::multiset<std::size_t>(std::begin(expectedSet), std::end(expectedSet)));
+
+            const auto ray = vm::ray<T,S>(p, normalize(direction));
+            auto expectedRayDistance = std::numeric_limits<T>::infinity();
+            auto expectedRayPoint = points.size();
+            for (std::size_t i = 0u; i < points.size(); ++i) {
+                const auto d = squared_distance(ray, points[i]).distance;
+                if (d < expectedRayDistance) {
+                    expectedRayDistance = d;
+                    expectedRayPoint = i;
+                }
+            }
+
+            const auto [rayDistance, rayPoint] = tree.find_closest_to_ray(ray);
+            CHECK(rayPoint == expectedRayPoint);
+            CHECK(rayDistance.distance == distance(ray, points[expectedRayPoint]).distance);
+            CHECK(rayDistance.position == distance(ray, points[expectedRayPoint]).position);
+
+            const auto [limitedDistance, limitedPoint] = tree.find_closest_to_ray(ray, sqrt(expectedRayDistance) / T(2.0));
+            if (expectedRayDistance > T(0.0)) {
+                CHECK(is_nan(limitedDistance.distance));
+                CHECK(limitedPoint == points.size());
+            }
+        }
+    }
+
+    TEST_CASE("kd_tree.empty") {
+        const auto tree = kd_tree<double,3>();
+        CHECK(tree.empty());
+
+        const auto [distance, index] = tree.find_nearest(vec3d::zero());
+        CHECK(is_nan(distance));
+        CHECK(index == 0u);
+        CHECK(tree.find_k_nearest(vec3d::zero(), 3u).empty());
+
+        const auto [rayDistance, rayIndex] = tree.find_closest_to_ray(ray3d(vec3d::zero(), vec3d::pos_x()));
+        CHECK(is_nan(rayDistance.distance));
+        CHECK(rayIndex == 0u);
+
+        auto visited = false;
+        tree.query_radius(vec3d::zero(), 10.0, [&](const std::size_t) {
+            visited = true;
+            return true;
+        });
+        CHECK_FALSE(visited);
+    }
+
+    TEST_CASE("kd_tree.duplicate_points") {
+        const auto points = std::vector<vec3d>(50u, vec3d(1, 2, 3));
+        const auto tree = kd_tree<double,3>(std::begin(points), std::end(points));
+
+        // ties are resolved by index
+        CHECK(std::get<1>(tree.find_nearest(vec3d::zero())) == 0u);
+        CHECK(tree.find_k_nearest(vec3d::zero(), 3u) == std::vector<std::size_t>{ 0u, 1u, 2u });
+        CHECK(std::get<1>(tree.find_closest_to_ray(ray3d(vec3d::zero(), vec3d::pos_x()))) == 0u);
+
+        // a point at exactly the maximum distance is found
+        CHECK(std::get<1>(tree.find_nearest(vec3d(1, 2, 4), 1.0)) == 0u);
+        CHECK(std::get<1>(tree.find_nearest(vec3d(1, 2, 4), 0.5)) == points.size());
+    }
+
+    TEST_CASE("kd_tree.transformation") {
+        struct vertex {
+            vec3f position;
+            int id;
+        };
+        const auto vertices = std::vector<vertex>{ { vec3f(0, 0, 0), 1 }, { vec3f(5, 0, 0), 2 }, { vec3f(0, 5, 0), 3 } };
+        const auto tree = kd_tree<float,3>(std::begin(vertices), std::end(vertices), [](const vertex& v) { return v.position; });
+        CHECK(std::get<1>(tree.find_nearest(vec3f(4, 1, 0))) == 1u);
+
+        const auto [distance, index] = tree.find_closest_to_ray(ray3f(vec3f(1, 4, 1), vec3f::neg_z()));
+        CHECK(index == 2u);
+        CHECK(distance.position == 1.0f);
+        CHECK(distance.distance == approx(std::sqrt(2.0f)));
+    }
+
+    TEST_CASE("kd_tree.queries") {
+        check_kd_tree_queries<double,3>(2000u);
+        check_kd_tree_queries<float,3>(1000u);
+        check_kd_tree_queries<double,2>(1000u);
+        check_kd_tree_queries<double,3>(5u);
+    }
+
+    TEST_CASE("kd_tree.query_radius_stop") {
+        const auto points = make_kd_tree_points<double,3>(1000u, 5u);
+        const auto tree = kd_tree<double,3>(std::begin(points), std::end(points));
+        std::size_t count = 0u;
+        tree.query_radius(vec3d::zero(), 1000.0, [&](const std::size_t) {
+            return ++count < 10u;
+        });
+        CHECK(count == 10u);
+    }
+}
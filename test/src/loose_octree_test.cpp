@@ -0,0 +1,150 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/loose_octree.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    static void check_octree_queries(const loose_octree<double, std::size_t>& octree, const std::vector<bbox3d>& boxes, const std::vector<bool>& present) {
+        std::mt19937 rng(19u);
+        std::uniform_real_distribution<double> extent(0.0, 30.0);
+
+        for (std::size_t q = 0u; q < 50u; ++q) {
+            const auto b = random_box<double>(rng, { -70.0, 70.0 }, { 0.0, 30.0 });
+            const auto min = b.min;
+            const auto radius = extent(rng);
+
+            std::multiset<std::size_t> boxHits;
+            octree.query(b, [&](const std::size_t id) {
+                boxHits.insert(octree.data(id));
+                return true;
+            });
+
+            std::multiset<std::size_t> radiusHits;
+            octree.query_radius(min, radius, [&](const std::size_t id) {
+                radiusHits.insert(octree.data(id));
+                return true;
+            });
+
+            std::multiset<std::size_t> expectedBoxHits;
+            std::multiset<std::size_t> expectedRadiusHits;
+            for (std::size_t i = 0u; i < boxes.size(); ++i) {
+                if (present[i] && boxes[i].intersects(b)) {
+                    expectedBoxHits.insert(i);
+                }
+                if (present[i] && squared_length(max(boxes[i].min - min, vec3d::zero(), min - boxes[i].max)) <= radius * radius) {
+                    expectedRadiusHits.insert(i);
+                }
+            }
+
+            CHECK(boxHits == expectedBoxHits);
+            CHECK(radiusHits == expectedRadiusHits);
+        }
+    }
+
+    TEST_CASE("loose_octree.insert_remove") {
+        auto octree = loose_octree<double, int>(bbox3d(vec3d(0, 0, 0), vec3d(16, 8, 8)), 4u);
+        CHECK(octree.bounds() == bbox3d(vec3d(0, 0, 0), vec3d(16, 16, 16)));
+        CHECK(octree.empty());
+
+        // a point is stored at the maximum depth, which creates a path of nodes from the root
+        const auto a = octree.insert(vec3d(1, 1, 1), 1);
+        CHECK(octree.node_count() == 5u);
+
+        // a box as large as the octree is stored in the root
+        const auto b = octree.insert(bbox3d(vec3d(0, 0, 0), vec3d(16, 16, 16)), 2);
+        CHECK(octree.node_count() == 5u);
+
+        // a box that is larger than the octree is stored outside of it
+        const auto c = octree.insert(bbox3d(vec3d(-1, 0, 0), vec3d(17, 1, 1)), 3);
+        CHECK(octree.node_count() == 5u);
+        CHECK(octree.size() == 3u);
+        CHECK(octree.data(c) == 3);
+
+        octree.remove(a);
+        CHECK_FALSE(octree.is_valid(a));
+        CHECK(octree.node_count() == 1u);
+
+        octree.remove(b);
+        CHECK(octree.node_count() == 0u);
+
+        std::vector<std::size_t> hits;
+        octree.query(bbox3d(vec3d(16.5, 0, 0), vec3d(17, 1, 1)), [&](const std::size_t id) {
+            hits.push_back(id);
+            return true;
+        });
+        CHECK(hits == std::vector<std::size_t>{ c });
+
+        octree.remove(c);
+        CHECK(octree.empty());
+    }
+
+    TEST_CASE("loose_octree.query") {
+        auto boxes = random_boxes<double>(3000u, 17u, { -60.0, 60.0 }, { 0.0, 0.0 });
+        // sizes vary from points to boxes larger than the octree
+        std::mt19937 rng(18u);
+        std::uniform_real_distribution<double> exponent(-6.0, 6.0);
+        for (std::size_t i = 0u; i < boxes.size(); ++i) {
+            if (i % 5u != 0u) {
+                boxes[i] = boxes[i].expand(std::exp2(exponent(rng)));
+            }
+        }
+        auto octree = loose_octree<double, std::size_t>(bbox3d(50.0));
+        std::vector<bool> present(boxes.size(), true);
+        std::vector<std::size_t> ids;
+        for (std::size_t i = 0u; i < boxes.size(); ++i) {
+            ids.push_back(octree.insert(boxes[i], i));
+        }
+        check_octree_queries(octree, boxes, present);
+
+        for (std::size_t i = 0u; i < boxes.size(); i += 3u) {
+            octree.remove(ids[i]);
+            present[i] = false;
+        }
+        CHECK(octree.size() == 2000u);
+        check_octree_queries(octree, boxes, present);
+
+        // stop early
+        std::size_t count = 0u;
+        octree.query(bbox3d(1000.0), [&](const std::size_t) {
+            ++count;
+            return count < 10u;
+        });
+        CHECK(count == 10u);
+
+        for (std::size_t i = 0u; i < boxes.size(); ++i) {
+            if (present[i]) {
+                octree.remove(ids[i]);
+            }
+        }
+        CHECK(octree.empty());
+        CHECK(octree.node_count() == 0u);
+    }
+}
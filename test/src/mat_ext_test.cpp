@@ -20,13 +20,18 @@
 #include <vecmath/approx.h>
 #include <vecmath/mat.h>
 #include <vecmath/mat_ext.h>
+#include <vecmath/quat.h>
 #include <vecmath/mat_io.h>
 #include <vecmath/vec.h>
 #include <vecmath/vec_io.h>
 
 #include "test_utils.h"
 
+#include <cmath>
 #include <cstdlib>
+#include <iterator>
+#include <list>
+#include <vector>
 #include <ctime>
 
 #include <catch2/catch.hpp>
@@ -232,6 +237,91 @@ namespace vm {
         CER_CHECK(o[2] == approx(r[2]));
     }
 
+    template <typename T>
+    static std::vector<vec<T,3>> make_points(const std::size_t count) {
+        std::vector<vec<T,3>> result;
+        for (std::size_t i = 0u; i < count; ++i) {
+            const auto t = static_cast<T>(i);
+            result.emplace_back(t * static_cast<T>(0.5) - static_cast<T>(3.0), static_cast<T>(7.0) - t, t * t / static_cast<T>(16.0));
+        }
+        return result;
+    }
+
+    template <typename T>
+    static void check_transform_points(const mat<T,4,4>& m) {
+        // a count that is not a multiple of any pack width
+        const auto points = make_points<T>(37u);
+
+        auto out = std::vector<vec<T,3>>(points.size());
+        transform_points(m, points.data(), points.size(), out.data());
+
+        auto inPlace = points;
+        transform_points(m, inPlace.data(), inPlace.size());
+
+        auto list = std::list<vec<T,3>>();
+        transform_points(m, std::begin(points), std::end(points), std::back_inserter(list));
+        REQUIRE(list.size() == points.size());
+
+        auto it = std::begin(list);
+        for (std::size_t i = 0u; i < points.size(); ++i, ++it) {
+            CHECK(out[i] == m * points[i]);
+            CHECK(inPlace[i] == m * points[i]);
+            CHECK(*it == m * points[i]);
+        }
+    }
+
+    TEST_CASE("mat_ext.transform_points") {
+        const auto affine = translation_matrix(vec3d(1, -2, 3)) * rotation_matrix(vec3d(1, 2, 3), 0.7) * scaling_matrix(vec3d(2, 3, 4));
+        const auto projective = perspective_matrix(90.0, 1.0, 100.0, 1024, 768) * affine;
+
+        check_transform_points(affine);
+        check_transform_points(projective);
+        check_transform_points(mat4x4f(affine));
+        check_transform_points(mat4x4f(projective));
+    }
+
+    TEST_CASE("mat_ext.transform_points_lower_dimension") {
+        const auto m = mat3x3d(
+            2, 1, 4,
+            0, 3, 5,
+            0, 0, 1);
+        const auto points = std::vector<vec2d> { vec2d(1, 2), vec2d(-3, 4), vec2d(5, -6) };
+
+        vec2d out[3];
+        CHECK(transform_points(m, std::begin(points), std::end(points), out) == std::end(out));
+        for (std::size_t i = 0u; i < points.size(); ++i) {
+            CHECK(out[i] == m * points[i]);
+        }
+    }
+
+    TEST_CASE("mat_ext.transform_points_empty") {
+        auto points = std::vector<vec3f>();
+        transform_points(mat4x4f::identity(), points.data(), points.size());
+        CHECK(points.empty());
+    }
+
+    TEST_CASE("mat_ext.transform_directions") {
+        const auto m = translation_matrix(vec3d(1, -2, 3)) * rotation_matrix(vec3d(1, 2, 3), 0.7) * scaling_matrix(vec3d(2, 3, 4));
+        const auto directions = make_points<double>(11u);
+
+        auto out = std::vector<vec3d>(directions.size());
+        transform_directions(m, directions.data(), directions.size(), out.data());
+
+        auto inPlace = directions;
+        transform_directions(m, inPlace.data(), inPlace.size());
+
+        auto list = std::list<vec3d>();
+        transform_directions(m, std::begin(directions), std::end(directions), std::back_inserter(list));
+        REQUIRE(list.size() == directions.size());
+
+        auto it = std::begin(list);
+        for (std::size_t i = 0u; i < directions.size(); ++i, ++it) {
+            CHECK(out[i] == strip_translation(m) * directions[i]);
+            CHECK(inPlace[i] == strip_translation(m) * directions[i]);
+            CHECK(*it == strip_translation(m) * directions[i]);
+        }
+    }
+
     TEST_CASE("mat_ext.rotation_matrix_with_euler_angles") {
         CHECK(rotation_matrix(to_radians(90.0), 0.0, 0.0) == approx(mat4x4d::rot_90_x_ccw()));
         CHECK(rotation_matrix(0.0, to_radians(90.0), 0.0) == approx(mat4x4d::rot_90_y_ccw()));
@@ -281,6 +371,73 @@ namespace vm {
         }
     }
 
+    TEST_CASE("mat_ext.rotation_matrix_3x3_with_quaternion") {
+        constexpr auto q = quatd(0.5, vec3d(0.5, -0.5, 0.5));
+        CER_CHECK(rotation_matrix_3x3(q) == extract_minor(rotation_matrix(q), 3u, 3u));
+        CHECK(rotation_matrix_3x3(quatd(vec3d::pos_x(), to_radians(90.0))) == approx(extract_minor(mat4x4d::rot_90_x_ccw(), 3u, 3u)));
+    }
+
+    template <typename T>
+    static std::vector<quat<T>> make_rotations() {
+        std::vector<quat<T>> result;
+
+        // rotations by 180 degrees about the coordinate axes and the identity exercise each branch of Shepperd's method
+        result.push_back(quat<T>(vec<T,3>::pos_x(), to_radians(T(180.0))));
+        result.push_back(quat<T>(vec<T,3>::pos_y(), to_radians(T(180.0))));
+        result.push_back(quat<T>(vec<T,3>::pos_z(), to_radians(T(180.0))));
+        result.push_back(quat<T>(vec<T,3>::pos_z(), T(0.0)));
+
+        // a count that is not a multiple of any pack width
+        for (std::size_t i = 0u; i < 33u; ++i) {
+            const auto f = static_cast<T>(i);
+            const auto axis = normalize(vec<T,3>(T(1.0) + f, T(3.0) - f, f * f / T(8.0) - T(2.0)));
+            result.push_back(quat<T>(axis, f * T(0.19)));
+        }
+        return result;
+    }
+
+    template <typename T>
+    static void check_rotation_matrix_to_quat() {
+        const auto quats = make_rotations<T>();
+        for (const auto& q : quats) {
+            const auto m = rotation_matrix_3x3(q);
+            const auto p = rotation_matrix_to_quat(m);
+            CHECK(std::abs(dot(p, q)) == approx(T(1.0), T(1e-6)));
+            CHECK(rotation_matrix_3x3(p) == approx<mat<T,3,3>>(m, T(1e-6)));
+            CHECK(rotation_matrix_to_quat(rotation_matrix(q)).r == p.r);
+        }
+    }
+
+    TEST_CASE("mat_ext.rotation_matrix_to_quat") {
+        check_rotation_matrix_to_quat<float>();
+        check_rotation_matrix_to_quat<double>();
+    }
+
+    template <typename T>
+    static void check_rotation_matrix_conversion_batch() {
+        const auto quats = make_rotations<T>();
+
+        auto matrices = std::vector<mat<T,3,3>>(quats.size());
+        rotation_matrix_3x3(quats.data(), quats.size(), matrices.data());
+
+        auto converted = std::vector<quat<T>>(quats.size());
+        rotation_matrix_to_quat(matrices.data(), matrices.size(), converted.data());
+
+        for (std::size_t i = 0u; i < quats.size(); ++i) {
+            // the batched and the scalar conversions may be contracted into fused multiply-add instructions differently
+            CHECK(is_equal(matrices[i], rotation_matrix_3x3(quats[i]), T(0.00001)));
+
+            const auto expected = rotation_matrix_to_quat(matrices[i]);
+            CHECK(converted[i].r == approx(expected.r, T(0.00001)));
+            CHECK(is_equal(converted[i].v, expected.v, T(0.00001)));
+        }
+    }
+
+    TEST_CASE("mat_ext.rotation_matrix_conversion_batch") {
+        check_rotation_matrix_conversion_batch<float>();
+        check_rotation_matrix_conversion_batch<double>();
+    }
+
     TEST_CASE("mat_ext.translation_matrix") {
         constexpr auto v = vec3d(2, 3, 4);
         constexpr auto t = translation_matrix(v);
@@ -300,6 +457,52 @@ namespace vm {
         CER_CHECK(strip_translation(t * s) == approx(s));
     }
 
+    TEST_CASE("mat_ext.invert_affine") {
+        constexpr auto m = translation_matrix(vec3d(2, -3, 4)) * scaling_matrix(vec3d(2, 3, -4)) * shear_matrix(1.0, 0.5, 0.0, 0.0, 0.25, 0.0);
+        constexpr auto result = invert_affine(m);
+        CER_CHECK(std::get<0>(result))
+        CER_CHECK(std::get<1>(result) == approx(std::get<1>(invert(m))))
+        CER_CHECK(is_affine(std::get<1>(result)))
+
+        const auto r = rotation_matrix(vec3d(1, 2, 3), 0.7);
+        const auto c = coordinate_system_matrix(vec3d::pos_y(), vec3d::pos_z(), vec3d::pos_x(), vec3d(1, 2, 3));
+        CHECK(std::get<1>(invert_affine(r * m)) == approx(std::get<1>(invert(r * m))));
+        CHECK(std::get<1>(invert_affine(c)) == approx(std::get<1>(invert(c))));
+
+        constexpr auto s = mat3x3d(
+            2, 1, 4,
+            0, 3, 5,
+            0, 0, 1);
+        CER_CHECK(std::get<1>(invert_affine(s)) == approx(std::get<1>(invert(s))))
+
+        CER_CHECK_FALSE(std::get<0>(invert_affine(scaling_matrix(vec3d(1, 0, 1)))))
+
+        // the determinant of the upper left part is below the pivot threshold, but every pivot is above it
+        const auto small = translation_matrix(vec3d(2, -3, 4)) * scaling_matrix(vec3d::fill(1e-6));
+        const auto [invertible, inverse] = invert_affine(small);
+        CHECK(invertible);
+        CHECK(small * inverse == approx(mat4x4d::identity()));
+    }
+
+    TEST_CASE("mat_ext.invert_rigid") {
+        constexpr auto m = translation_matrix(vec3d(2, -3, 4)) * mat4x4d::rot_90_x_cw() * mat4x4d::rot_180_z();
+        CER_CHECK(invert_rigid(m) == approx(std::get<1>(invert(m))))
+        CER_CHECK(invert_rigid(mat4x4d::identity()) == mat4x4d::identity())
+
+        const auto r = translation_matrix(vec3d(-1, 5, 2)) * rotation_matrix(normalize(vec3d(1, 2, 3)), 0.7);
+        CHECK(invert_rigid(r) == approx(std::get<1>(invert(r))));
+        CHECK(r * invert_rigid(r) == approx(mat4x4d::identity()));
+
+        const auto f = mat4x4f(r);
+        CHECK(invert_rigid(f) == approx(std::get<1>(invert(f))));
+
+        constexpr auto s = mat3x3d(
+            0, -1,  5,
+            1,  0, -2,
+            0,  0,  1);
+        CER_CHECK(invert_rigid(s) == approx(std::get<1>(invert(s))))
+    }
+
     TEST_CASE("mat_ext.scaling_matrix") {
         CER_CHECK(
             scaling_matrix(vec3d(2, 3, 4)) ==
@@ -26,6 +26,7 @@
 #include "test_utils.h"
 
 #include <sstream>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
@@ -441,6 +442,30 @@ namespace vm {
         CHECK_FALSE(is_zero(mat4x4d::identity(), vm::Cd::almost_zero()));
     }
 
+    TEST_CASE("mat.is_affine") {
+        CER_CHECK(is_affine(mat4x4d::identity()));
+        CER_CHECK(is_affine(mat4x4d(
+            1, 2, 3, 4,
+            5, 6, 7, 8,
+            9, 10, 11, 12,
+            0, 0, 0, 1)));
+        CER_CHECK(is_affine(mat3x3d(
+            1, 2, 3,
+            4, 5, 6,
+            0, 0, 1)));
+        CER_CHECK_FALSE(is_affine(mat4x4d::zero()));
+        CER_CHECK_FALSE(is_affine(mat4x4d(
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 1, 1)));
+        CER_CHECK_FALSE(is_affine(mat4x4d(
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 2)));
+    }
+
     TEST_CASE("mat.operator_equal") {
         constexpr auto m = mat4x4d(
              1,  2,  3,  4,
@@ -585,6 +610,29 @@ namespace vm {
         CER_CHECK(lhs * rhs == exp)
     }
 
+    TEST_CASE("mat.operator_multiply_matrix_float") {
+        // the runtime result for 4x4 float matrices may be computed using SIMD instructions, and it must match the
+        // result computed at compile time up to differences caused by contraction into fused multiply-add
+        constexpr auto lhs = mat4x4f(
+            0.1f,  -2.3f,  3.7f,  4.1f,
+            5.9f,   6.2f, -7.3f,  0.8f,
+           -9.5f,  10.1f, 11.3f, -0.7f,
+            0.0f,   0.0f,  0.0f,  1.0f);
+        constexpr auto rhs = mat4x4f(
+            1.3f,  0.7f, -0.2f,  12.5f,
+           -0.4f,  2.9f,  0.3f, -33.1f,
+            0.6f, -0.1f,  1.7f,   0.9f,
+            0.0f,  0.0f,  0.0f,   1.0f);
+        constexpr auto exp = lhs * rhs;
+
+        // the constant evaluated products may be contracted differently than the SIMD products
+        const auto& lhsRef = lhs;
+        const auto& rhsRef = rhs;
+        CHECK(is_equal(lhsRef * rhsRef, exp, 0.001f));
+        CHECK(is_equal(rhsRef * lhsRef, rhs * lhs, 0.001f));
+        CHECK(lhsRef * mat4x4f::identity() == lhs);
+    }
+
     TEST_CASE("mat.operator_multiply_scalar_right") {
         CER_CHECK(
             mat4x4d(
@@ -652,6 +700,25 @@ namespace vm {
             to_cartesian_coords(exp));
     }
 
+    TEST_CASE("mat.operator_multiply_vector_right_float") {
+        // the runtime result for 4x4 float matrices may be computed using SIMD instructions, and it must match the
+        // result computed at compile time up to differences caused by contraction into fused multiply-add
+        constexpr auto m = mat4x4f(
+            0.1f,  -2.3f,  3.7f,  4.1f,
+            5.9f,   6.2f, -7.3f,  0.8f,
+           -9.5f,  10.1f, 11.3f, -0.7f,
+            0.3f,  -0.2f,  0.1f,  1.5f);
+        constexpr auto v4 = vec4f(1.7f, -2.9f, 0.3f, 1.0f);
+        constexpr auto v3 = vec3f(1.7f, -2.9f, 0.3f);
+        constexpr auto exp4 = m * v4;
+        constexpr auto exp3 = m * v3;
+
+        const auto& mRef = m;
+        CHECK(is_equal(mRef * v4, exp4, 0.0001f));
+        CHECK(is_equal(mRef * v3, exp3, 0.0001f));
+        CHECK(is_equal(mRef * v3, to_cartesian_coords(exp4), 0.0001f));
+    }
+
     TEST_CASE("mat.operator_multiply_vector_left") {
         constexpr auto v =  vec4d(1, 2, 3, 1);
         CER_CHECK(v * mat4x4d::identity() == approx(v));
@@ -814,6 +881,83 @@ namespace vm {
         CER_CHECK(compute_adjugate(m3) == approx(r3));
     }
 
+    TEST_CASE("mat.compute_determinant_large") {
+        constexpr auto p = mat<double,5,5>(
+            0, 1, 0, 0, 0,
+            1, 0, 0, 0, 0,
+            0, 0, 0, 0, 1,
+            0, 0, 1, 0, 0,
+            0, 0, 0, 1, 0);
+        CER_CHECK(compute_determinant(p) == approx(-1.0));
+        CER_CHECK(compute_determinant(mat<double,5,5>::zero()) == approx(0.0));
+
+        constexpr auto t = mat<double,6,6>(
+            1, 7, -3,  2,  9, 4,
+            0, 2,  5, -1,  3, 8,
+            0, 0,  3,  6, -2, 1,
+            0, 0,  0,  4,  7, 5,
+            0, 0,  0,  0,  5, 2,
+            0, 0,  0,  0,  0, 6);
+        CER_CHECK(compute_determinant(t) == approx(720.0));
+        CER_CHECK(compute_determinant(transpose(t)) == approx(720.0));
+
+        // block diagonal matrix composed of the matrices m2 and m3 from the test above
+        constexpr auto b = mat<double,8,8>(
+            65, 12, -3, -5,  0,  0,  0,  0,
+            -5,  1,  0,  0,  0,  0,  0,  0,
+            19, 10, 11,  8,  0,  0,  0,  0,
+             0,  1, -8,  3,  0,  0,  0,  0,
+             0,  0,  0,  0,  3,  2, -1,  4,
+             0,  0,  0,  0,  2,  1,  5,  7,
+             0,  0,  0,  0,  0,  5,  2, -6,
+             0,  0,  0,  0, -1,  2,  1,  0);
+        CER_CHECK(compute_determinant(b) == approx(15661.0 * -418.0));
+    }
+
+    TEST_CASE("mat.compute_determinant_large_integer") {
+        constexpr auto m = mat<int,5,5>(
+            3, 1, 1, 1, 1,
+            1, 3, 1, 1, 1,
+            1, 1, 3, 1, 1,
+            1, 1, 1, 3, 1,
+            1, 1, 1, 1, 3);
+        CER_CHECK(compute_determinant(m) == 112);
+
+        constexpr auto p = mat<int,5,5>(
+            0, 1, 0, 0, 0,
+            1, 0, 0, 0, 0,
+            0, 0, 0, 0, 1,
+            0, 0, 1, 0, 0,
+            0, 0, 0, 1, 0);
+        CER_CHECK(compute_determinant(p) == -1);
+        CER_CHECK(compute_determinant(mat<int,5,5>::zero()) == 0);
+
+        constexpr auto t = mat<int,6,6>(
+            0, 2,  5, -1,  3, 8,
+            1, 7, -3,  2,  9, 4,
+            0, 0,  3,  6, -2, 1,
+            0, 0,  0,  4,  7, 5,
+            0, 0,  0,  0,  5, 2,
+            0, 0,  0,  0,  0, 6);
+        CER_CHECK(compute_determinant(t) == -720);
+    }
+
+    TEST_CASE("mat.compute_determinant_large_small_scale") {
+        // no pivot is rejected for being small, so the determinant is not flushed to 0
+        constexpr auto m = mat<double,5,5>(
+            3, 1, 1, 1, 1,
+            1, 3, 1, 1, 1,
+            1, 1, 3, 1, 1,
+            1, 1, 1, 3, 1,
+            1, 1, 1, 1, 3) * 1.0e-16;
+        CER_CHECK(compute_determinant(m) == approx(112.0e-80, 1.0e-90));
+        CER_CHECK(compute_determinant(m * 1.0e-16) == approx(112.0e-160, 1.0e-170));
+
+        auto singular = m;
+        singular[2] = vec<double,5>::zero();
+        CHECK(compute_determinant(singular) == 0.0);
+    }
+
 #define CER_CHECK_INVERTIBLE(exp, mat) { constexpr auto _i_r = invert((mat));  CER_CHECK(std::get<0>(_i_r)) CER_CHECK(std::get<1>(_i_r) == approx(exp)); }
 #define CER_CHECK_NOT_INVERTIBLE(mat)  { constexpr auto _i_r = invert((mat));  CER_CHECK_FALSE(std::get<0>(_i_r)) }
 
@@ -851,6 +995,117 @@ namespace vm {
         CER_CHECK_NOT_INVERTIBLE(m1)
     }
 
+    TEST_CASE("mat.invert_2x2") {
+        constexpr auto m = mat2x2d(
+            4, 7,
+            2, 6);
+        constexpr auto r = mat2x2d(
+             0.6, -0.7,
+            -0.2,  0.4);
+
+        CER_CHECK_INVERTIBLE(mat2x2d::identity(), mat2x2d::identity())
+        CER_CHECK_INVERTIBLE(r, m)
+        CER_CHECK_NOT_INVERTIBLE(mat2x2d::zero())
+        CER_CHECK_NOT_INVERTIBLE(mat2x2d(1, 2, 2, 4))
+    }
+
+    TEST_CASE("mat.invert_3x3") {
+        constexpr auto m = mat3x3d(
+            2, 0, -1,
+            5, 1,  0,
+            0, 1,  3);
+        constexpr auto r = mat3x3d(
+              3, -1,  1,
+            -15,  6, -5,
+              5, -2,  2);
+
+        CER_CHECK_INVERTIBLE(mat3x3d::identity(), mat3x3d::identity())
+        CER_CHECK_INVERTIBLE(r, m)
+        CER_CHECK_NOT_INVERTIBLE(mat3x3d::zero())
+        CER_CHECK_NOT_INVERTIBLE(mat3x3d(1, 2, 3, 4, 5, 6, 7, 8, 9))
+    }
+
+    TEST_CASE("mat.invert_matches_lup") {
+        // the closed form inverse must agree with the inverse computed from an LUP decomposition
+        const auto check = [](const auto& m) {
+            using M = std::decay_t<decltype(m)>;
+
+            const auto [invertible, inverse] = invert(m);
+            CHECK(invertible);
+            CHECK(m * inverse == approx(M::identity()));
+
+            for (std::size_t i = 0u; i < M::cols; ++i) {
+                const auto [solvable, column] = lup_solve(m, M::identity()[i]);
+                CHECK(solvable);
+                CHECK(inverse[i] == approx(column));
+            }
+        };
+
+        check(mat2x2d(
+             3, -2,
+             1,  5));
+        check(mat3x3d(
+             1,  2, -1,
+            -3,  4,  2,
+             5,  0,  7));
+        check(mat4x4d(
+            65, 12, -3, -5,
+            -5,  1,  0,  0,
+            19, 10, 11,  8,
+             0,  1, -8,  3));
+        check(mat4x4f(
+             2, 0.5f, -1, 10,
+            -1,    3,  0, -4,
+             0,    1,  4,  2,
+             0,    0,  0,  1));
+    }
+
+    TEST_CASE("mat.invert_small_scale") {
+        // the determinants are below the pivot threshold, but every pivot is above it
+        const auto check = [](const auto& m) {
+            using M = std::decay_t<decltype(m)>;
+
+            const auto [invertible, inverse] = invert(m);
+            CHECK(invertible);
+            CHECK(m * inverse == approx(M::identity()));
+        };
+
+        check(mat2x2d(
+            1e-8, 0,
+            0, 1e-8));
+        check(mat3x3d(
+            1e-6, 0, 0,
+            0, 1e-6, 0,
+            0, 0, 1e-6));
+        check(mat4x4d(
+            1e-6, 0, 0, 0,
+            0, 1e-6, 0, 0,
+            0, 0, 1e-6, 0,
+            0, 0, 0, 1));
+
+        CER_CHECK_NOT_INVERTIBLE(mat2x2d(
+            1e-16, 0,
+            0, 1e-8))
+        CER_CHECK_NOT_INVERTIBLE(mat3x3d(
+            1e-6, 0, 0,
+            0, 1e-6, 0,
+            0, 0, 0))
+    }
+
+    TEST_CASE("mat.invert_5x5") {
+        constexpr auto m = mat<double,5,5>(
+            2, 0, 0, 0, 1,
+            0, 3, 0, 0, 0,
+            0, 0, 4, 0, 0,
+            0, 0, 0, 5, 0,
+            1, 0, 0, 0, 1);
+
+        constexpr auto result = invert(m);
+        CER_CHECK(std::get<0>(result))
+        CER_CHECK(m * std::get<1>(result) == approx(mat<double,5,5>::identity()));
+        CER_CHECK_NOT_INVERTIBLE((mat<double,5,5>::zero()))
+    }
+
     TEST_CASE("mat.lup_solve") {
         constexpr auto A = mat4x4d(
              0.93629336358419923, -0.27509584731824366,  0.21835066314633442,  87.954817941228995,
@@ -869,4 +1124,73 @@ namespace vm {
         CER_CHECK(x2 == approx(x));
         CER_CHECK(A * x2 == approx(b));
     }
+
+    TEST_CASE("mat.lu_decomposition") {
+        constexpr auto A = mat4x4d(
+            65, 12, -3, -5,
+            -5,  1,  0,  0,
+            19, 10, 11,  8,
+             0,  1, -8,  3);
+        constexpr auto decomp = lu_decomposition<double,4>(A);
+        CER_CHECK(decomp.is_valid())
+        CER_CHECK(decomp.determinant() == approx(15661.0))
+        CER_CHECK(decomp.inverse() == approx(std::get<1>(invert(A))))
+
+        constexpr auto x = vec4d(20, -60, 32, 1);
+        CER_CHECK(decomp.solve(A * x) == approx(x))
+
+        // P*A = L*U
+        const auto& lu = decomp.lu();
+        auto L = mat4x4d::identity();
+        auto U = mat4x4d::zero();
+        auto P = mat4x4d::zero();
+        for (std::size_t r = 0u; r < 4u; ++r) {
+            for (std::size_t c = 0u; c < 4u; ++c) {
+                if (c < r) {
+                    L[c][r] = lu[c][r];
+                } else {
+                    U[c][r] = lu[c][r];
+                }
+            }
+            P[decomp.permutation()[r]][r] = 1.0;
+        }
+        CHECK(P * A == approx(L * U));
+    }
+
+    TEST_CASE("mat.lu_decomposition_solve_many") {
+        constexpr auto A = mat3x3d(
+            2, 1, -1,
+           -3, -1, 2,
+           -2, 1, 2);
+        const auto decomp = lu_decomposition<double,3>(A);
+        REQUIRE(decomp.is_valid());
+
+        const auto xs = std::vector<vec3d> { vec3d(2, 3, -1), vec3d(0, 0, 0), vec3d(-4, 7, 0.5), vec3d(1, 1, 1) };
+        auto bs = std::vector<vec3d>();
+        for (const auto& x : xs) {
+            bs.push_back(A * x);
+        }
+
+        auto solutions = std::vector<vec3d>(bs.size());
+        CHECK(decomp.solve_many(std::begin(bs), std::end(bs), std::begin(solutions)) == std::end(solutions));
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            CHECK(solutions[i] == approx(xs[i]));
+        }
+
+        // in place
+        decomp.solve_many(std::begin(bs), std::end(bs), std::begin(bs));
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            CHECK(bs[i] == approx(xs[i]));
+        }
+    }
+
+    TEST_CASE("mat.lu_decomposition_singular") {
+        constexpr auto decomp = lu_decomposition<double,4>(mat4x4d(
+             1,  2,  3,  4,
+             5,  6,  7,  8,
+             9, 10, 11, 12,
+            13, 14, 15, 16));
+        CER_CHECK_FALSE(decomp.is_valid())
+        CER_CHECK(decomp.determinant() == 0.0)
+    }
 }
@@ -0,0 +1,92 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/morton.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <cstdint>
+#include <random>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    TEST_CASE("morton.count_leading_zeros") {
+        CER_CHECK(detail::count_leading_zeros(1u) == 63u);
+        CER_CHECK(detail::count_leading_zeros(0x8000000000000000u) == 0u);
+        CER_CHECK(detail::count_leading_zeros(0x00000000FFFFFFFFu) == 32u);
+        CER_CHECK(detail::count_leading_zeros(0x0000123400000000u) == 19u);
+    }
+
+    TEST_CASE("morton.morton_code_30") {
+        constexpr auto bounds = bbox3d(vec3d(-1, -1, -1), vec3d(1, 1, 1));
+        CER_CHECK(morton_code_30(vec3d(-1, -1, -1), bounds) == 0u);
+        CER_CHECK(morton_code_30(vec3d(1, 1, 1), bounds) == 0x3FFFFFFFu);
+        CER_CHECK(morton_code_30(vec3d(0, -1, -1), bounds) == 0x20000000u);
+        CER_CHECK(morton_code_30(vec3d(-1, 0, -1), bounds) == 0x10000000u);
+        CER_CHECK(morton_code_30(vec3d(-1, -1, 0), bounds) == 0x08000000u);
+
+        // points outside of the bounds are clamped
+        CER_CHECK(morton_code_30(vec3d(-2, -1, -1), bounds) == 0u);
+        CER_CHECK(morton_code_30(vec3d(5, 5, 5), bounds) == 0x3FFFFFFFu);
+
+        // a degenerate axis contributes no bits
+        constexpr auto flat = bbox3d(vec3d(0, 0, 2), vec3d(1, 1, 2));
+        CER_CHECK(morton_code_30(vec3d(1, 1, 2), flat) == 0x36DB6DB6u);
+    }
+
+    TEST_CASE("morton.morton_code_63") {
+        constexpr auto bounds = bbox3f(vec3f(0, 0, 0), vec3f(4, 4, 4));
+        CER_CHECK(morton_code_63(vec3f(0, 0, 0), bounds) == 0u);
+        CER_CHECK(morton_code_63(vec3f(4, 4, 4), bounds) == 0x7FFFFFFFFFFFFFFFu);
+        CER_CHECK(morton_code_63(vec3f(2, 0, 0), bounds) == 0x4000000000000000u);
+        CER_CHECK(morton_code_63(vec3f(0, 0, 1), bounds) == 0x0200000000000000u);
+    }
+
+    TEST_CASE("morton.interleaving") {
+        // the code is obtained by interleaving the bits of the quantized components
+        std::mt19937 rng(3u);
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        const auto bounds = bbox3d(vec3d::zero(), vec3d::one());
+        for (std::size_t i = 0u; i < 1000u; ++i) {
+            const auto p = vec3d(dist(rng), dist(rng), dist(rng));
+            std::uint64_t q[3];
+            for (std::size_t c = 0u; c < 3u; ++c) {
+                q[c] = static_cast<std::uint64_t>(p[c] * 2097152.0);
+            }
+
+            std::uint64_t expected63 = 0u;
+            std::uint64_t expected30 = 0u;
+            for (unsigned b = 0u; b < 21u; ++b) {
+                for (std::size_t c = 0u; c < 3u; ++c) {
+                    const auto bit = (q[c] >> b) & 1u;
+                    expected63 |= bit << (3u * b + 2u - c);
+                    if (b >= 11u) {
+                        expected30 |= bit << (3u * (b - 11u) + 2u - c);
+                    }
+                }
+            }
+
+            CHECK(morton_code_63(p, bounds) == expected63);
+            CHECK(morton_code_30(p, bounds) == expected30);
+        }
+    }
+}
@@ -0,0 +1,295 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/affine.h>
+#include <vecmath/bbox.h>
+#include <vecmath/mat.h>
+#include <vecmath/mat_ext.h>
+#include <vecmath/mat_io.h>
+#include <vecmath/obb.h>
+#include <vecmath/quat.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename T>
+    static std::array<vec<T,3>, 8> obb_vertices(const obb<T,3>& b) {
+        std::array<vec<T,3>, 8> result;
+        for (std::size_t i = 0u; i < 8u; ++i) {
+            result[i] = b.center;
+            for (std::size_t k = 0u; k < 3u; ++k) {
+                const auto sign = (i >> k) & 1u ? T(1.0) : T(-1.0);
+                result[i] = result[i] + b.orientation[k] * (sign * b.half_extents[k]);
+            }
+        }
+        return result;
+    }
+
+    // the largest gap between the projections of the vertices of the given boxes onto the 15 candidate separating
+    // axes, which is positive if and only if the boxes are separated
+    template <typename T>
+    static T obb_separation(const obb<T,3>& a, const obb<T,3>& b) {
+        std::vector<vec<T,3>> axes;
+        for (std::size_t i = 0u; i < 3u; ++i) {
+            axes.push_back(a.orientation[i]);
+            axes.push_back(b.orientation[i]);
+            for (std::size_t j = 0u; j < 3u; ++j) {
+                const auto axis = cross(a.orientation[i], b.orientation[j]);
+                if (squared_length(axis) > T(0.0001)) {
+                    axes.push_back(normalize(axis));
+                }
+            }
+        }
+
+        const auto va = obb_vertices(a);
+        const auto vb = obb_vertices(b);
+        auto result = std::numeric_limits<T>::lowest();
+        for (const auto& axis : axes) {
+            const auto project = [&](const std::array<vec<T,3>, 8>& vertices) {
+                auto min = dot(vertices[0], axis), max = min;
+                for (const auto& v : vertices) {
+                    min = std::min(min, dot(v, axis));
+                    max = std::max(max, dot(v, axis));
+                }
+                return std::make_tuple(min, max);
+            };
+            const auto [minA, maxA] = project(va);
+            const auto [minB, maxB] = project(vb);
+            result = std::max(result, std::max(minB - maxA, minA - maxB));
+        }
+        return result;
+    }
+
+    template <typename T>
+    static mat<T,3,3> random_rotation(std::mt19937& rng) {
+        std::uniform_real_distribution<T> dist(T(-1.0), T(1.0));
+        std::uniform_real_distribution<T> angle(T(0.0), constants<T>::two_pi());
+        auto axis = vec<T,3>(dist(rng), dist(rng), dist(rng));
+        if (squared_length(axis) < T(0.01)) {
+            axis = vec<T,3>::pos_z();
+        }
+        return rotation_matrix_3x3(quat<T>(normalize(axis), angle(rng)));
+    }
+
+    TEST_CASE("obb.constructor_default") {
+        constexpr auto b = obb3d();
+        CER_CHECK(b.center == vec3d::zero());
+        CER_CHECK(b.orientation == mat3x3d::identity());
+        CER_CHECK(b.half_extents == vec3d::zero());
+    }
+
+    TEST_CASE("obb.constructor_with_bbox") {
+        constexpr auto b = obb3d(bbox3d(vec3d(-2.0, 0.0, 1.0), vec3d(4.0, 2.0, 2.0)));
+        CER_CHECK(b.center == vec3d(1.0, 1.0, 1.5));
+        CER_CHECK(b.orientation == mat3x3d::identity());
+        CER_CHECK(b.half_extents == vec3d(3.0, 1.0, 0.5));
+        CER_CHECK(b.bounds() == bbox3d(vec3d(-2.0, 0.0, 1.0), vec3d(4.0, 2.0, 2.0)));
+        CER_CHECK(b.volume() == 12.0);
+    }
+
+    TEST_CASE("obb.contains") {
+        const auto rotation = rotation_matrix_3x3(quatd(vec3d::pos_z(), to_radians(45.0)));
+        const auto b = obb3d(vec3d(1.0, 0.0, 0.0), rotation, vec3d(2.0, 1.0, 1.0));
+
+        CHECK(b.contains(vec3d(1.0, 0.0, 0.0)));
+        CHECK(b.contains(vec3d(2.0, 1.0, 0.5)));
+        CHECK(b.contains(vec3d(-0.4, -1.4, 0.0)));
+        CHECK_FALSE(b.contains(vec3d(2.0, -1.0, 0.0)));
+        CHECK_FALSE(b.contains(vec3d(1.0, 0.0, 1.5)));
+    }
+
+    TEST_CASE("obb.bounds") {
+        const auto rotation = rotation_matrix_3x3(quatd(vec3d::pos_z(), to_radians(45.0)));
+        const auto b = obb3d(vec3d(1.0, 2.0, 3.0), rotation, vec3d(2.0, 1.0, 1.0));
+
+        const auto bounds = b.bounds();
+        const auto vertices = obb_vertices(b);
+        const auto expected = bbox3d::merge_all(std::begin(vertices), std::end(vertices));
+        CHECK(bounds.min == approx(expected.min));
+        CHECK(bounds.max == approx(expected.max));
+    }
+
+    TEST_CASE("obb.transform") {
+        const auto box = bbox3d(vec3d(-1.0, -2.0, 0.0), vec3d(3.0, 2.0, 1.0));
+        const auto rotation = rotation_matrix(vec3d(1.0, 2.0, 3.0) / length(vec3d(1.0, 2.0, 3.0)), to_radians(30.0));
+        const auto transform = translation_matrix(vec3d(5.0, -1.0, 2.0)) * rotation * scaling_matrix(vec3d(2.0, 0.5, 3.0));
+
+        for (const auto& b : { obb3d(box, transform), obb3d(box, affine3d(transform)) }) {
+            // the orientation is a rotation
+            CHECK(b.orientation * transpose(b.orientation) == approx(mat3x3d::identity()));
+            CHECK(compute_determinant(b.orientation) == approx(1.0));
+
+            // rotation and axis aligned scaling are transformed exactly
+            CHECK(b.half_extents == approx(vec3d(4.0, 1.0, 1.5)));
+            CHECK(b.center == approx(transform * box.center()));
+            CHECK(b.volume() == approx(box.volume() * 3.0));
+
+            // the result is much tighter than the transformed bounding box
+            CHECK(b.volume() < box.transform(transform).volume());
+            CHECK(b.bounds().min == approx(box.transform(transform).min));
+            CHECK(b.bounds().max == approx(box.transform(transform).max));
+        }
+    }
+
+    TEST_CASE("obb.transform_shear") {
+        const auto box = bbox3d(vec3d(-1.0, -1.0, -1.0), vec3d(1.0, 1.0, 1.0));
+        const auto shear = mat4x4d(
+            1.0, 0.5, 0.0, 0.0,
+            0.0, 1.0, 0.0, 0.0,
+            0.0, 0.0, 1.0, 0.0,
+            0.0, 0.0, 0.0, 1.0);
+        const auto b = obb3d(box, shear);
+
+        CHECK(b.orientation * transpose(b.orientation) == approx(mat3x3d::identity()));
+        box.for_each_vertex([&](const vec3d& v) {
+            const auto t = shear * v;
+            CHECK(obb3d(b.center, b.orientation, b.half_extents + vec3d::fill(0.0001)).contains(t));
+        });
+    }
+
+    TEST_CASE("obb.transform_collapse") {
+        const auto box = bbox3d(vec3d(-1.0, -1.0, -1.0), vec3d(1.0, 1.0, 1.0));
+        const auto b = obb3d(box, scaling_matrix(vec3d(2.0, 0.0, 1.0)));
+
+        CHECK(b.orientation == approx(mat3x3d::identity()));
+        CHECK(b.half_extents == approx(vec3d(2.0, 0.0, 1.0)));
+    }
+
+    TEST_CASE("obb.intersects") {
+        const auto a = obb3d(vec3d::zero(), rotation_matrix_3x3(quatd(vec3d::pos_z(), to_radians(45.0))), vec3d(1.0, 1.0, 1.0));
+
+        // separated by an axis of a
+        CHECK_FALSE(a.intersects(obb3d(vec3d(2.0, 2.0, 0.0), mat3x3d::identity(), vec3d(0.5, 0.5, 0.5))));
+        CHECK(a.intersects(obb3d(vec3d(1.2, 1.2, 0.0), mat3x3d::identity(), vec3d(0.5, 0.5, 0.5))));
+
+        // separated by an axis of b
+        CHECK_FALSE(a.intersects(obb3d(vec3d(0.0, 0.0, 1.6), mat3x3d::identity(), vec3d(5.0, 5.0, 0.5))));
+        CHECK(a.intersects(obb3d(vec3d(0.0, 0.0, 1.4), mat3x3d::identity(), vec3d(5.0, 5.0, 0.5))));
+
+        // separated only by the cross product of two edges
+        const auto edgeA = obb3d(vec3d::zero(), rotation_matrix_3x3(quatd(vec3d::pos_x(), to_radians(45.0))), vec3d(1.0, 1.0, 1.0));
+        const auto edgeB = [](const double z) {
+            return obb3d(vec3d(0.0, 0.0, z), rotation_matrix_3x3(quatd(vec3d::pos_y(), to_radians(45.0))), vec3d(1.0, 1.0, 1.0));
+        };
+        CHECK(edgeA.intersects(edgeB(2.0 * std::sqrt(2.0) - 0.01)));
+        CHECK_FALSE(edgeA.intersects(edgeB(2.0 * std::sqrt(2.0) + 0.01)));
+        CHECK(obb_separation(edgeA, obb3d(vec3d::zero(), mat3x3d::identity(), vec3d(1.0, 1.0, 1.0))) < 0.0);
+        CHECK(obb_separation(edgeA, edgeB(2.0 * std::sqrt(2.0) + 0.01)) > 0.0);
+
+        // identical orientations produce parallel edges and degenerate cross products
+        CHECK(a.intersects(a));
+        CHECK(a.intersects(obb3d(vec3d(0.0, 0.0, 1.9), a.orientation, a.half_extents)));
+        CHECK_FALSE(a.intersects(obb3d(vec3d(0.0, 0.0, 2.1), a.orientation, a.half_extents)));
+    }
+
+    TEST_CASE("obb.intersects_bbox") {
+        const auto boxes = random_boxes<float>(2000u, 24u, { -10.0f, 10.0f }, { 0.1f, 5.0f });
+        for (std::size_t i = 0u; i < boxes.size(); i += 2u) {
+            const auto& a = boxes[i];
+            const auto& b = boxes[i + 1u];
+            CHECK(obb3f(a).intersects(obb3f(b)) == a.intersects(b));
+        }
+    }
+
+    TEST_CASE("obb.intersects_random") {
+        std::mt19937 rng(25u);
+        std::uniform_real_distribution<double> position(-4.0, 4.0);
+        std::uniform_real_distribution<double> extent(0.1, 3.0);
+
+        std::size_t overlapping = 0u;
+        std::size_t separated = 0u;
+        for (std::size_t i = 0u; i < 5000u; ++i) {
+            const auto make = [&]() {
+                return obb3d(vec3d(position(rng), position(rng), position(rng)), random_rotation<double>(rng), vec3d(extent(rng), extent(rng), extent(rng)));
+            };
+            const auto a = make();
+            const auto b = make();
+            const auto separation = obb_separation(a, b);
+            if (separation > 0.001) {
+                CHECK_FALSE(a.intersects(b));
+                CHECK_FALSE(b.intersects(a));
+                ++separated;
+            } else if (separation < -0.001) {
+                CHECK(a.intersects(b));
+                CHECK(b.intersects(a));
+                ++overlapping;
+            }
+        }
+        CHECK(overlapping > 1000u);
+        CHECK(separated > 1000u);
+    }
+
+    TEST_CASE("obb.fit") {
+        std::mt19937 rng(26u);
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+        // points uniformly distributed in a rotated, elongated box far away from the origin
+        const auto rotation = rotation_matrix_3x3(quatd(normalize(vec3d(1.0, -1.0, 2.0)), to_radians(40.0)));
+        const auto expected = obb3d(vec3d(1000.0, -500.0, 200.0), rotation, vec3d(10.0, 3.0, 1.0));
+        std::vector<vec3d> points;
+        for (std::size_t i = 0u; i < 2000u; ++i) {
+            const auto local = vec3d(unit(rng), unit(rng), unit(rng)) * expected.half_extents;
+            points.push_back(expected.center + expected.orientation * local);
+        }
+
+        const auto b = obb3d::fit(std::begin(points), std::end(points));
+        CHECK(b.orientation * transpose(b.orientation) == approx(mat3x3d::identity()));
+        CHECK(compute_determinant(b.orientation) == approx(1.0));
+
+        const auto slack = obb3d(b.center, b.orientation, b.half_extents + vec3d::fill(0.000001));
+        for (const auto& p : points) {
+            CHECK(slack.contains(p));
+        }
+
+        // the axes are sorted by variance, and the long axis is found accurately
+        CHECK(std::abs(dot(b.orientation[0], expected.orientation[0])) > 0.999);
+        CHECK(b.half_extents[0] >= b.half_extents[1]);
+        CHECK(b.half_extents[1] >= b.half_extents[2]);
+        CHECK(b.volume() == Approx(expected.volume()).epsilon(0.1));
+        CHECK(b.volume() < bbox3d::merge_all(std::begin(points), std::end(points)).volume() / 4.0);
+    }
+
+    TEST_CASE("obb.fit_degenerate") {
+        const auto single = std::vector<vec3f>{ vec3f(1.0f, 2.0f, 3.0f) };
+        const auto point = obb3f::fit(std::begin(single), std::end(single));
+        CHECK(point.center == vec3f(1.0f, 2.0f, 3.0f));
+        CHECK(point.half_extents == vec3f::zero());
+
+        // collinear points with a transformation
+        const auto values = std::vector<float>{ 0.0f, 1.0f, 4.0f };
+        const auto line = obb3f::fit(std::begin(values), std::end(values), [](const float f) { return vec3f(f, f, 0.0f); });
+        CHECK(line.center == approx(vec3f(2.0f, 2.0f, 0.0f)));
+        CHECK(line.half_extents == approx(vec3f(2.0f * std::sqrt(2.0f), 0.0f, 0.0f)));
+        CHECK(std::abs(dot(line.orientation[0], normalize(vec3f(1.0f, 1.0f, 0.0f)))) == approx(1.0f));
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/bbox.h>
+#include <vecmath/bbox_io.h>
+#include <vecmath/parallel.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename T, std::size_t S>
+    static std::vector<vec<T,S>> randomPoints(const std::size_t count) {
+        std::mt19937 rng(5u);
+        std::uniform_real_distribution<T> dist(T(-100.0), T(100.0));
+        std::vector<vec<T,S>> result(count);
+        for (auto& point : result) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                point[c] = dist(rng);
+            }
+        }
+        return result;
+    }
+
+    template <typename T, std::size_t S>
+    static void testParallelMergeAll(const std::size_t count) {
+        const auto points = randomPoints<T,S>(count);
+        const auto expected = bbox<T,S>::merge_all(std::begin(points), std::end(points));
+
+        CHECK(parallel_merge_all(points.data(), points.size()) == expected);
+        CHECK(parallel_merge_all(points.data(), points.size(), 1u) == expected);
+        CHECK(parallel_merge_all(points.data(), points.size(), 3u) == expected);
+        CHECK(parallel_merge_all(points.data(), points.data() + points.size()) == expected);
+        CHECK(parallel_merge_all(std::begin(points), std::end(points)) == expected);
+    }
+
+    TEST_CASE("parallel.parallel_merge_all") {
+        testParallelMergeAll<float,3>(1u);
+        testParallelMergeAll<float,3>(7u);
+        testParallelMergeAll<float,3>(200003u);
+        testParallelMergeAll<double,3>(200003u);
+        testParallelMergeAll<float,2>(100001u);
+        testParallelMergeAll<double,4>(100001u);
+    }
+
+    TEST_CASE("parallel.parallel_merge_all_with_transformation") {
+        const auto points = randomPoints<double,3>(150000u);
+        const auto get = [](const vec3d& p) { return vec3d(p.x(), -p.y(), 2.0 * p.z()); };
+        CHECK(parallel_merge_all(std::begin(points), std::end(points), get, 2u) == bbox3d::merge_all(std::begin(points), std::end(points), get));
+    }
+
+    TEST_CASE("parallel.parallel_add") {
+        const auto points = randomPoints<float,3>(100000u);
+
+        bbox3f::builder builder;
+        builder.add(vec3f(1000.0f, 0.0f, 0.0f));
+        parallel_add(builder, std::begin(points), std::end(points));
+
+        bbox3f::builder expected;
+        expected.add(vec3f(1000.0f, 0.0f, 0.0f));
+        expected.add(std::begin(points), std::end(points));
+
+        CHECK(builder.bounds() == expected.bounds());
+
+        // adding an empty range leaves the builder unchanged
+        bbox3f::builder empty;
+        parallel_add(empty, std::begin(points), std::begin(points));
+        CHECK_FALSE(empty.initialized());
+    }
+
+    TEST_CASE("parallel.parallel_average") {
+        const auto points = randomPoints<double,3>(300007u);
+        const auto expected = average(std::begin(points), std::end(points));
+
+        const auto result = parallel_average(points.data(), points.size());
+        CHECK(result == approx<vec3d>(expected, 1e-9));
+
+        // the result does not depend on the number of threads
+        CHECK(parallel_average(points.data(), points.size(), 1u) == result);
+        CHECK(parallel_average(points.data(), points.size(), 3u) == result);
+
+        const auto get = [](const vec3d& p) { return p * 2.0; };
+        CHECK(parallel_average(std::begin(points), std::end(points), get, 2u) == approx<vec3d>(expected * 2.0, 1e-9));
+
+        const auto small = std::vector<vec2f>{ vec2f(1.0f, 2.0f), vec2f(3.0f, 4.0f), vec2f(5.0f, 9.0f) };
+        CHECK(parallel_average(std::begin(small), std::end(small)) == approx(vec2f(3.0f, 5.0f)));
+    }
+
+    template <typename K>
+    static void testParallelRadixSort(const std::size_t count, const K maxKey) {
+        std::mt19937_64 rng(7u);
+        std::uniform_int_distribution<K> dist(K(0), maxKey);
+
+        std::vector<K> keys(count);
+        std::vector<std::size_t> values(count);
+        std::vector<std::pair<K, std::size_t>> expected(count);
+        for (std::size_t i = 0u; i < count; ++i) {
+            keys[i] = dist(rng);
+            values[i] = i;
+            expected[i] = std::make_pair(keys[i], i);
+        }
+        std::stable_sort(std::begin(expected), std::end(expected), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        for (const auto threadCount : { std::size_t(1u), std::size_t(3u) }) {
+            auto sortedKeys = keys;
+            auto sortedValues = values;
+            parallel_radix_sort(sortedKeys.data(), sortedValues.data(), count, threadCount);
+
+            auto equal = true;
+            for (std::size_t i = 0u; i < count; ++i) {
+                equal = equal && sortedKeys[i] == expected[i].first && sortedValues[i] == expected[i].second;
+            }
+            CHECK(equal);
+        }
+    }
+
+    TEST_CASE("parallel.parallel_radix_sort") {
+        testParallelRadixSort<std::uint32_t>(0u, 100u);
+        testParallelRadixSort<std::uint32_t>(1u, 100u);
+        testParallelRadixSort<std::uint32_t>(1000u, 100u);
+        testParallelRadixSort<std::uint32_t>(200003u, 0xFFFFFFFFu);
+        testParallelRadixSort<std::uint64_t>(200003u, 0xFFFFFFFFFFFFFFFFu);
+        // many duplicates and digits that are equal for all keys
+        testParallelRadixSort<std::uint64_t>(150001u, 0x3FFu);
+        testParallelRadixSort<std::uint16_t>(70000u, 0xFFFFu);
+    }
+
+    TEST_CASE("parallel.exceptions") {
+        const auto points = randomPoints<double,3>(200000u);
+        const auto get = [](const vec3d& p) {
+            if (p.x() > 99.99) {
+                throw std::runtime_error("invalid point");
+            }
+            return p;
+        };
+        CHECK_THROWS_AS(parallel_merge_all(std::begin(points), std::end(points), get, 2u), std::runtime_error);
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/quat.h>
+#include <vecmath/quat_ext.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+#include <vecmath/scalar.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename T>
+    static std::vector<quat<T>> make_random_quats(const std::size_t count) {
+        auto rng = std::mt19937(11u);
+        auto dist = std::normal_distribution<double>();
+
+        std::vector<quat<T>> result;
+        for (std::size_t i = 0u; i < count; ++i) {
+            result.push_back(quat<T>(normalize(quatd(dist(rng), vec3d(dist(rng), dist(rng), dist(rng))))));
+        }
+        return result;
+    }
+
+    /**
+     * Returns the angle in degrees of the rotation that takes the given unit quaternions onto each other.
+     */
+    template <typename T>
+    static double angular_distance(const quat<T>& lhs, const quat<T>& rhs) {
+        const auto d = quatd(lhs).conjugate() * quatd(rhs);
+        return to_degrees(2.0 * std::atan2(length(d.v), std::abs(d.r)));
+    }
+
+    template <std::size_t Bits, typename T>
+    static double max_angular_error(const std::vector<quat<T>>& quats) {
+        auto result = 0.0;
+        for (const auto& q : quats) {
+            result = std::max(result, angular_distance(q, decompress_quat<T>(compress_quat<Bits>(q))));
+        }
+        return result;
+    }
+
+    TEST_CASE("quat_ext.compressed_quat_size") {
+        CHECK(sizeof(compressed_quat<32>) == 4u);
+        CHECK(sizeof(compressed_quat<48>) == 6u);
+        CHECK(compressed_quat<32>::component_bits == 10u);
+        CHECK(compressed_quat<48>::component_bits == 15u);
+    }
+
+    TEST_CASE("quat_ext.compressed_quat_value") {
+        constexpr auto q = compressed_quat<48>(0x123456789ABCu);
+        CER_CHECK(q.value() == 0x123456789ABCu);
+        CER_CHECK(q.bytes[0] == 0xBCu);
+        CER_CHECK(q.bytes[5] == 0x12u);
+
+        // excess bits are dropped
+        CER_CHECK(compressed_quat<32>(0x123456789ABCu).value() == 0x56789ABCu);
+        CER_CHECK(compressed_quat<32>(1u) == compressed_quat<32>(1u));
+        CER_CHECK(compressed_quat<32>(1u) != compressed_quat<32>(2u));
+    }
+
+    TEST_CASE("quat_ext.compress_quat") {
+        const auto q = quatd(normalize(vec3d(1.0, -2.0, 3.0)), to_radians(75.0));
+        const auto p = decompress_quat<double>(compress_quat<32>(q));
+        CHECK(p.r == approx(q.r, 1e-3));
+        CHECK(p.v == approx<vec3d>(q.v, 1e-3));
+        CHECK(dot(p, p) == approx(1.0, 1e-12));
+
+        // q and -q represent the same rotation and have the same encoding
+        CHECK(compress_quat<32>(q) == compress_quat<32>(quatd(-q.r, -q.v)));
+
+        // the omitted component is stored in the two most significant bits
+        CHECK(compress_quat<32>(quatd(vec3d::pos_y(), to_radians(180.0))).value() >> 30u == 2u);
+    }
+
+    TEST_CASE("quat_ext.compress_quat_max_angular_error") {
+        const auto quatsf = make_random_quats<float>(20000u);
+        const auto quatsd = make_random_quats<double>(20000u);
+
+        const auto error32f = max_angular_error<32>(quatsf);
+        const auto error48f = max_angular_error<48>(quatsf);
+        const auto error32d = max_angular_error<32>(quatsd);
+        const auto error48d = max_angular_error<48>(quatsd);
+        INFO("max angular error in degrees: 32 bits " << error32f << " / " << error32d << ", 48 bits " << error48f << " / " << error48d);
+
+        CHECK(error32f < 0.25);
+        CHECK(error32d < 0.25);
+        CHECK(error48f < 0.008);
+        CHECK(error48d < 0.008);
+    }
+
+    template <typename T, std::size_t Bits>
+    static void check_compress_quat_batch() {
+        // a count that is not a multiple of any pack width
+        auto quats = make_random_quats<T>(35u);
+        quats.push_back(quat<T>(T(1.0), vec<T,3>::zero()));
+        quats.push_back(quat<T>(vec<T,3>::pos_z(), to_radians(T(180.0))));
+
+        auto compressed = std::vector<compressed_quat<Bits>>(quats.size());
+        compress_quat(quats.data(), quats.size(), compressed.data());
+
+        auto decompressed = std::vector<quat<T>>(quats.size());
+        decompress_quat(compressed.data(), compressed.size(), decompressed.data());
+
+        for (std::size_t i = 0u; i < quats.size(); ++i) {
+            CHECK(compressed[i] == compress_quat<Bits>(quats[i]));
+
+            const auto expected = decompress_quat<T>(compressed[i]);
+            CHECK(decompressed[i].r == expected.r);
+            CHECK(decompressed[i].v == expected.v);
+        }
+    }
+
+    TEST_CASE("quat_ext.compress_quat_batch") {
+        check_compress_quat_batch<float, 32>();
+        check_compress_quat_batch<float, 48>();
+        check_compress_quat_batch<double, 32>();
+        check_compress_quat_batch<double, 48>();
+    }
+}
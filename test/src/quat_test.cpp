@@ -25,6 +25,15 @@
 
 #include "test_utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <random>
+#include <tuple>
+#include <vector>
+
 #include <catch2/catch.hpp>
 
 namespace vm {
@@ -192,4 +201,180 @@ namespace vm {
 
         CER_CHECK(q * x == approx(vec3f(cos_a, sin_a, 0)));
     }
+
+    TEST_CASE("quat.operator_multiply_vector_matches_quaternion_product") {
+        const auto q = quatd(normalize(vec3d(1.0, -2.0, 3.0)), to_radians(37.0));
+        for (const auto& v : { vec3d(1, 0, 0), vec3d(0, 1, 0), vec3d(-3, 2, 5), vec3d(0.25, -8, 1) }) {
+            const auto expected = (q * quatd(0.0, v) * q.conjugate()).v;
+            CHECK(q * v == approx(expected));
+        }
+    }
+
+    template <typename T>
+    static void check_rotate() {
+        const auto q = quat<T>(normalize(vec<T,3>(T(2.0), T(1.0), T(-1.0))), to_radians(T(123.0)));
+
+        // a count that is not a multiple of any pack width
+        std::vector<vec<T,3>> vectors;
+        for (std::size_t i = 0u; i < 37u; ++i) {
+            const auto t = static_cast<T>(i);
+            vectors.emplace_back(t * T(0.5) - T(3.0), T(7.0) - t, t * t / T(16.0));
+        }
+
+        auto out = std::vector<vec<T,3>>(vectors.size());
+        rotate(q, vectors.data(), vectors.size(), out.data());
+
+        auto inPlace = vectors;
+        rotate(q, inPlace.data(), inPlace.size());
+
+        auto list = std::list<vec<T,3>>();
+        rotate(q, std::begin(vectors), std::end(vectors), std::back_inserter(list));
+        REQUIRE(list.size() == vectors.size());
+
+        auto it = std::begin(list);
+        for (std::size_t i = 0u; i < vectors.size(); ++i, ++it) {
+            // the batched and the scalar rotation may be contracted into fused multiply-add instructions differently
+            CHECK(is_equal(out[i], q * vectors[i], T(0.0001)));
+            CHECK(is_equal(inPlace[i], q * vectors[i], T(0.0001)));
+            CHECK(is_equal(*it, q * vectors[i], T(0.0001)));
+        }
+    }
+
+    TEST_CASE("quat.rotate") {
+        check_rotate<float>();
+        check_rotate<double>();
+    }
+
+    TEST_CASE("quat.rotate_empty") {
+        const auto q = quatd(vec3d::pos_z(), to_radians(15.0));
+        rotate(q, static_cast<const vec3d*>(nullptr), 0u, static_cast<vec3d*>(nullptr));
+    }
+
+    template <typename T>
+    static T max_component_difference(const quat<T>& lhs, const quat<T>& rhs) {
+        auto result = std::abs(lhs.r - rhs.r);
+        for (std::size_t i = 0u; i < 3u; ++i) {
+            result = std::max(result, std::abs(lhs.v[i] - rhs.v[i]));
+        }
+        return result;
+    }
+
+    TEST_CASE("quat.dot") {
+        constexpr auto p = quatd(1.0, vec3d(2.0, 3.0, 4.0));
+        constexpr auto q = quatd(-2.0, vec3d(1.0, 0.5, 2.0));
+        CER_CHECK(dot(p, q) == 9.5);
+    }
+
+    TEST_CASE("quat.normalize") {
+        const auto q = normalize(quatd(1.0, vec3d(2.0, 3.0, 4.0)));
+        CHECK(dot(q, q) == approx(1.0));
+        CHECK(q.r == approx(1.0 / std::sqrt(30.0)));
+        CHECK(q.v == approx(vec3d(2.0, 3.0, 4.0) / std::sqrt(30.0)));
+    }
+
+    TEST_CASE("quat.nlerp") {
+        const auto p = quatd(vec3d::pos_z(), to_radians(10.0));
+        const auto q = quatd(vec3d::pos_z(), to_radians(50.0));
+
+        CHECK(max_component_difference(nlerp(p, q, 0.0), p) == approx(0.0));
+        CHECK(max_component_difference(nlerp(p, q, 1.0), q) == approx(0.0));
+
+        // the halfway point of equal length quaternions is exact
+        const auto h = nlerp(p, q, 0.5);
+        CHECK(dot(h, h) == approx(1.0));
+        CHECK(max_component_difference(h, quatd(vec3d::pos_z(), to_radians(30.0))) == approx(0.0));
+
+        // follows the shorter path
+        const auto n = quatd(-q.r, -q.v);
+        CHECK(max_component_difference(nlerp(p, n, 0.5), h) == approx(0.0));
+    }
+
+    TEST_CASE("quat.slerp") {
+        const auto axis = normalize(vec3d(1.0, 2.0, -1.0));
+        const auto p = quatd(axis, to_radians(10.0));
+        const auto q = quatd(axis, to_radians(130.0));
+
+        for (const auto t : { 0.0, 0.1, 0.25, 0.5, 0.9, 1.0 }) {
+            const auto expected = quatd(axis, to_radians(10.0 + t * 120.0));
+            CHECK(max_component_difference(slerp(p, q, t), expected) == approx(0.0, 1e-12));
+
+            // follows the shorter path
+            CHECK(max_component_difference(slerp(p, quatd(-q.r, -q.v), t), expected) == approx(0.0, 1e-12));
+        }
+
+        // nearly identical quaternions
+        const auto r = quatd(axis, to_radians(10.0000001));
+        CHECK(max_component_difference(slerp(p, r, 0.5), p) == approx(0.0));
+    }
+
+    template <typename T>
+    static void check_fast_slerp_error(const T maxError) {
+        auto rng = std::mt19937(7u);
+        auto dist = std::uniform_real_distribution<double>(-1.0, 1.0);
+        const auto random_quat = [&]() {
+            return normalize(quatd(dist(rng), vec3d(dist(rng), dist(rng), dist(rng))));
+        };
+
+        auto pairs = std::vector<std::tuple<quatd, quatd>>();
+        for (std::size_t i = 0u; i < 1000u; ++i) {
+            pairs.emplace_back(random_quat(), random_quat());
+        }
+
+        // identical, opposite and perpendicular quaternions
+        const auto p = random_quat();
+        pairs.emplace_back(p, p);
+        pairs.emplace_back(p, quatd(-p.r, -p.v));
+        pairs.emplace_back(quatd(1.0, vec3d::zero()), quatd(0.0, vec3d::pos_x()));
+
+        for (const auto& [q0, q1] : pairs) {
+            for (const auto t : { 0.0, 0.1, 0.3, 0.5, 0.7, 0.9, 1.0 }) {
+                const auto expected = quat<T>(slerp(q0, q1, t));
+                const auto actual = fast_slerp(quat<T>(q0), quat<T>(q1), static_cast<T>(t));
+                CHECK(max_component_difference(actual, expected) < maxError);
+            }
+        }
+    }
+
+    TEST_CASE("quat.fast_slerp") {
+        check_fast_slerp_error<float>(5e-7f);
+        check_fast_slerp_error<double>(1e-7);
+
+        constexpr auto p = quatd(1.0, vec3d::zero());
+        constexpr auto q = quatd(0.0, vec3d::pos_z());
+        constexpr auto h = fast_slerp(p, q, 0.5);
+        CER_CHECK(h.r == approx(0.70710678118654752, 1e-7));
+        CER_CHECK(h.v == approx<vec3d>(vec3d(0.0, 0.0, 0.70710678118654752), 1e-7));
+    }
+
+    template <typename T>
+    static void check_fast_slerp_batch() {
+        // a count that is not a multiple of any pack width
+        std::vector<quat<T>> q0;
+        std::vector<quat<T>> q1;
+        std::vector<T> t;
+        for (std::size_t i = 0u; i < 37u; ++i) {
+            const auto f = static_cast<T>(i);
+            q0.push_back(quat<T>(normalize(vec<T,3>(T(1.0), f, T(2.0))), f * T(0.1)));
+            q1.push_back(quat<T>(normalize(vec<T,3>(f, T(-1.0), T(0.5))), T(3.0) - f * T(0.2)));
+            t.push_back(f / T(36.0));
+        }
+
+        auto out = std::vector<quat<T>>(q0.size());
+        fast_slerp(q0.data(), q1.data(), t.data(), q0.size(), out.data());
+
+        auto inPlace = q0;
+        fast_slerp(inPlace.data(), q1.data(), t.data(), inPlace.size(), inPlace.data());
+
+        for (std::size_t i = 0u; i < q0.size(); ++i) {
+            const auto expected = fast_slerp(q0[i], q1[i], t[i]);
+            // the batched and the scalar interpolation may be contracted into fused multiply-add instructions differently
+            CHECK(max_component_difference(out[i], expected) <= T(0.00001));
+            CHECK(max_component_difference(inPlace[i], expected) <= T(0.00001));
+        }
+    }
+
+    TEST_CASE("quat.fast_slerp_batch") {
+        check_fast_slerp_batch<float>();
+        check_fast_slerp_batch<double>();
+    }
 }
@@ -0,0 +1,186 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/spatial_hash.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    template <typename Q>
+    static void check_spatial_hash_queries(const Q& query, const std::vector<bbox3d>& boxes, const std::vector<bool>& present) {
+        std::mt19937 rng(13u);
+        std::uniform_real_distribution<double> extent(0.0, 30.0);
+
+        for (std::size_t q = 0u; q < 50u; ++q) {
+            const auto b = random_box<double>(rng, { -60.0, 60.0 }, { 0.0, 30.0 });
+            const auto min = b.min;
+            const auto radius = extent(rng);
+
+            std::multiset<std::size_t> boxHits;
+            query.query(b, [&](const std::size_t id) {
+                boxHits.insert(id);
+                return true;
+            });
+
+            std::multiset<std::size_t> radiusHits;
+            query.query_radius(min, radius, [&](const std::size_t id) {
+                radiusHits.insert(id);
+                return true;
+            });
+
+            std::multiset<std::size_t> expectedBoxHits;
+            std::multiset<std::size_t> expectedRadiusHits;
+            for (std::size_t i = 0u; i < boxes.size(); ++i) {
+                if (present[i] && boxes[i].intersects(b)) {
+                    expectedBoxHits.insert(i);
+                }
+                if (present[i] && squared_length(max(boxes[i].min - min, vec3d::zero(), min - boxes[i].max)) <= radius * radius) {
+                    expectedRadiusHits.insert(i);
+                }
+            }
+
+            CHECK(boxHits == expectedBoxHits);
+            CHECK(radiusHits == expectedRadiusHits);
+        }
+    }
+
+    TEST_CASE("spatial_hash.flat_hash_table") {
+        std::mt19937_64 rng(3u);
+        std::uniform_int_distribution<std::uint64_t> keys(0u, 2000u);
+
+        detail::flat_hash_table table;
+        std::unordered_map<std::uint64_t, std::uint32_t> expected;
+        for (std::uint32_t i = 0u; i < 20000u; ++i) {
+            const auto key = keys(rng);
+            if (expected.count(key) > 0u) {
+                CHECK(table.erase(key));
+                expected.erase(key);
+            } else {
+                table.insert(key, i);
+                expected[key] = i;
+            }
+        }
+
+        CHECK(table.size() == expected.size());
+        CHECK(4u * table.size() <= 3u * table.capacity());
+        for (std::uint64_t key = 0u; key <= 2000u; ++key) {
+            const auto it = expected.find(key);
+            CHECK(table.find(key) == (it == expected.end() ? detail::flat_hash_table::no_value : it->second));
+        }
+        CHECK_FALSE(table.erase(5000u));
+
+        std::size_t count = 0u;
+        table.for_each([&](const std::uint64_t key, const std::uint32_t value) {
+            CHECK(expected.at(key) == value);
+            ++count;
+        });
+        CHECK(count == expected.size());
+    }
+
+    TEST_CASE("spatial_hash.insert_remove") {
+        auto grid = spatial_hash<double, int>(1.0);
+        CHECK(grid.empty());
+
+        const auto a = grid.insert(bbox3d(vec3d(-0.5, -0.5, -0.5), vec3d(0.5, 0.5, 0.5)), 1);
+        const auto b = grid.insert(vec3d(0.25, 0.25, 0.25), 2);
+        CHECK(grid.size() == 2u);
+        CHECK(grid.data(a) == 1);
+        CHECK(grid.data(b) == 2);
+        // the box overlaps the eight cells around the origin
+        CHECK(grid.cell_count() == 8u);
+
+        grid.remove(a);
+        CHECK_FALSE(grid.is_valid(a));
+        CHECK(grid.is_valid(b));
+        CHECK(grid.cell_count() == 1u);
+
+        grid.remove(b);
+        CHECK(grid.empty());
+        CHECK(grid.cell_count() == 0u);
+
+        // ids are reused
+        CHECK(grid.insert(vec3d::zero(), 3) < 2u);
+    }
+
+    TEST_CASE("spatial_hash.query") {
+        auto boxes = random_boxes<double>(3000u, 11u, { -50.0, 50.0 }, { 0.0, 4.0 });
+        // every fourth item is a point
+        for (std::size_t i = 0u; i < boxes.size(); i += 4u) {
+            boxes[i] = bbox3d(boxes[i].min, boxes[i].min);
+        }
+        auto grid = spatial_hash<double, std::size_t>(2.0);
+        std::vector<bool> present(boxes.size(), true);
+        for (std::size_t i = 0u; i < boxes.size(); ++i) {
+            CHECK(grid.insert(boxes[i], i) == i);
+        }
+        check_spatial_hash_queries(grid, boxes, present);
+
+        for (std::size_t i = 0u; i < boxes.size(); i += 3u) {
+            grid.remove(i);
+            present[i] = false;
+        }
+        CHECK(grid.size() == 2000u);
+        check_spatial_hash_queries(grid, boxes, present);
+
+        // a query that covers more cells than are occupied
+        std::size_t count = 0u;
+        grid.query(bbox3d(1000.0), [&](const std::size_t) {
+            ++count;
+            return true;
+        });
+        CHECK(count == grid.size());
+
+        // stop early
+        count = 0u;
+        grid.query(bbox3d(1000.0), [&](const std::size_t) {
+            ++count;
+            return count < 10u;
+        });
+        CHECK(count == 10u);
+    }
+
+    TEST_CASE("spatial_hash.far_coordinates") {
+        // coordinates beyond the range of the cell keys share the outermost cells
+        auto grid = spatial_hash<double, int>(1.0);
+        const auto a = grid.insert(vec3d(1e9, 0.0, 0.0), 1);
+        const auto b = grid.insert(vec3d(2e9, 0.0, 0.0), 2);
+        CHECK(grid.cell_count() == 1u);
+
+        std::vector<std::size_t> hits;
+        grid.query(bbox3d(vec3d(1.5e9, -1.0, -1.0), vec3d(3e9, 1.0, 1.0)), [&](const std::size_t id) {
+            hits.push_back(id);
+            return true;
+        });
+        CHECK(hits == std::vector<std::size_t>{ b });
+
+        grid.remove(a);
+        CHECK(grid.cell_count() == 1u);
+    }
+}
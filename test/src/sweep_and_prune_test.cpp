@@ -0,0 +1,210 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/sweep_and_prune.h>
+#include <vecmath/vec.h>
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    using pair_set = std::set<std::pair<std::size_t, std::size_t>>;
+
+    template <typename T, std::size_t S>
+    static pair_set collect_pairs(const sweep_and_prune<T,S>& sap) {
+        pair_set result;
+        sap.for_each_pair([&](const std::size_t a, const std::size_t b) {
+            CHECK(a < b);
+            result.insert(std::make_pair(a, b));
+        });
+        CHECK(result.size() == sap.pair_count());
+        return result;
+    }
+
+    template <typename T, std::size_t S>
+    static pair_set brute_force_pairs(const sweep_and_prune<T,S>& sap, const std::vector<std::size_t>& ids) {
+        pair_set result;
+        for (std::size_t i = 0u; i < ids.size(); ++i) {
+            for (std::size_t j = i + 1u; j < ids.size(); ++j) {
+                if (sap.bounds(ids[i]).intersects(sap.bounds(ids[j]))) {
+                    result.insert(std::make_pair(std::min(ids[i], ids[j]), std::max(ids[i], ids[j])));
+                }
+            }
+        }
+        return result;
+    }
+
+    TEST_CASE("sweep_and_prune.basic") {
+        sweep_and_prune<double,3> sap;
+        CHECK(sap.empty());
+
+        const auto a = sap.insert(bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(2.0, 2.0, 2.0)));
+        const auto b = sap.insert(bbox3d(vec3d(1.0, 1.0, 1.0), vec3d(3.0, 3.0, 3.0)));
+        const auto c = sap.insert(bbox3d(vec3d(1.0, 5.0, 1.0), vec3d(3.0, 6.0, 3.0)));
+        CHECK(sap.size() == 3u);
+
+        // pairs are only found by update
+        CHECK(sap.pair_count() == 0u);
+        sap.update();
+        CHECK(collect_pairs(sap) == pair_set{ std::make_pair(a, b) });
+
+        // touching boxes intersect
+        sap.move(c, bbox3d(vec3d(1.0, 3.0, 1.0), vec3d(3.0, 6.0, 3.0)));
+        sap.update();
+        CHECK(collect_pairs(sap) == pair_set{ std::make_pair(a, b), std::make_pair(b, c) });
+
+        // separating along one axis removes the pair
+        sap.move(b, bbox3d(vec3d(1.0, 1.0, 4.0), vec3d(3.0, 3.0, 5.0)));
+        sap.update();
+        CHECK(collect_pairs(sap).empty());
+
+        sap.move(b, bbox3d(vec3d(1.0, 1.0, 1.0), vec3d(3.0, 3.0, 3.0)));
+        sap.update();
+        CHECK(collect_pairs(sap) == pair_set{ std::make_pair(a, b), std::make_pair(b, c) });
+
+        sap.remove(b);
+        CHECK_FALSE(sap.is_valid(b));
+        CHECK(sap.size() == 2u);
+        CHECK(collect_pairs(sap).empty());
+
+        // removed ids are reused
+        const auto d = sap.insert(bbox3d(vec3d(-1.0, -1.0, -1.0), vec3d(0.0, 0.0, 0.0)));
+        CHECK(d == b);
+        sap.update();
+        CHECK(collect_pairs(sap) == pair_set{ std::make_pair(a, d) });
+    }
+
+    template <typename T, std::size_t S>
+    static void test_random_frames() {
+        std::mt19937 rng(17u);
+        std::uniform_real_distribution<T> step(T(-1.0), T(1.0));
+        std::uniform_int_distribution<int> action(0, 79);
+
+        const auto make_box = [&]() {
+            return random_box<T,S>(rng, { T(-50.0), T(50.0) }, { T(0.5), T(6.0) });
+        };
+
+        sweep_and_prune<T,S> sap;
+        std::vector<std::size_t> ids;
+        for (std::size_t i = 0u; i < 400u; ++i) {
+            ids.push_back(sap.insert(make_box()));
+        }
+
+        for (std::size_t frame = 0u; frame < 30u; ++frame) {
+            // a few insertions are sorted into place, many insertions cause the pairs to be found from scratch
+            if (frame == 15u) {
+                for (std::size_t i = 0u; i < 2u * sweep_and_prune<T,S>::rebuild_threshold; ++i) {
+                    ids.push_back(sap.insert(make_box()));
+                }
+            }
+
+            for (std::size_t k = 0u; k < ids.size(); ++k) {
+                const auto a = action(rng);
+                if (a == 0) {
+                    sap.remove(ids[k]);
+                    ids.erase(std::begin(ids) + static_cast<std::ptrdiff_t>(k));
+                } else if (a == 1) {
+                    ids.push_back(sap.insert(make_box()));
+                } else if (a == 2) {
+                    // teleport
+                    sap.move(ids[k], make_box());
+                } else {
+                    vec<T,S> delta;
+                    for (std::size_t i = 0u; i < S; ++i) {
+                        delta[i] = step(rng);
+                    }
+                    sap.move(ids[k], sap.bounds(ids[k]).translate(delta));
+                }
+            }
+
+            sap.update();
+            CHECK(collect_pairs(sap) == brute_force_pairs(sap, ids));
+        }
+    }
+
+    TEST_CASE("sweep_and_prune.random_frames") {
+        test_random_frames<double,3>();
+        test_random_frames<float,3>();
+        test_random_frames<float,2>();
+    }
+
+    template <typename F>
+    static double measure_milliseconds(F&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // run with the tag [.benchmark] on an optimized build
+    TEST_CASE("sweep_and_prune.benchmark", "[.benchmark]") {
+        for (const std::size_t count : { 10000u, 30000u, 100000u }) {
+            // extents 1-8 in a cube sized for constant density
+            const auto side = 10.0f * std::cbrt(static_cast<float>(count));
+            const auto boxes = random_boxes<float>(count, 19u, { 0.0f, side }, { 1.0f, 8.0f });
+
+            std::size_t bruteForcePairs = 0u;
+            const auto bruteForce = measure_milliseconds([&]() {
+                for (std::size_t i = 0u; i < boxes.size(); ++i) {
+                    for (std::size_t j = i + 1u; j < boxes.size(); ++j) {
+                        if (boxes[i].intersects(boxes[j])) {
+                            ++bruteForcePairs;
+                        }
+                    }
+                }
+            });
+
+            sweep_and_prune<float,3> sap;
+            std::vector<std::size_t> ids;
+            for (const auto& b : boxes) {
+                ids.push_back(sap.insert(b));
+            }
+            const auto initial = measure_milliseconds([&]() { sap.update(); });
+            CHECK(sap.pair_count() == bruteForcePairs);
+
+            std::cout << count << " boxes: brute force " << bruteForce << " ms, initial update " << initial << " ms";
+
+            // per-frame times average 10 frames of random motion
+            std::mt19937 rng(static_cast<unsigned>(count));
+            for (const auto step : { 0.5f, 0.05f }) {
+                std::uniform_real_distribution<float> delta(-step, step);
+                auto total = 0.0;
+                for (std::size_t frame = 0u; frame < 10u; ++frame) {
+                    for (const auto id : ids) {
+                        sap.move(id, sap.bounds(id).translate(vec3f(delta(rng), delta(rng), delta(rng))));
+                    }
+                    total += measure_milliseconds([&]() { sap.update(); });
+                }
+                std::cout << ", per frame with step " << step << " " << total / 10.0 << " ms";
+            }
+            std::cout << std::endl;
+        }
+    }
+}
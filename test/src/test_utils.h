@@ -19,6 +19,13 @@
 #pragma once
 
 #include <vecmath/forward.h>
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
 
 #define CE_CHECK(expr) { constexpr auto _r_r = (expr); CHECK(_r_r); }
 #define CER_CHECK(expr) CHECK(expr); CE_CHECK(expr);
@@ -26,3 +33,54 @@
 #define CE_CHECK_FALSE(expr) { constexpr auto _r_r = (expr); CHECK_FALSE(_r_r); }
 #define CER_CHECK_FALSE(expr) CHECK_FALSE(expr); CE_CHECK_FALSE(expr);
 
+
+namespace vm {
+    /**
+     * Returns a random box whose min corner components are uniformly distributed in the given position range and
+     * whose extents are uniformly distributed in the given extent range.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param rng the generator to draw from
+     * @param positionRange the range of the min corner components
+     * @param extentRange the range of the box extents
+     * @return the box
+     */
+    template <typename T, std::size_t S = 3>
+    bbox<T,S> random_box(std::mt19937& rng, const std::pair<T,T>& positionRange, const std::pair<T,T>& extentRange) {
+        std::uniform_real_distribution<T> position(positionRange.first, positionRange.second);
+        std::uniform_real_distribution<T> extent(extentRange.first, extentRange.second);
+
+        vec<T,S> min;
+        for (std::size_t i = 0u; i < S; ++i) {
+            min[i] = position(rng);
+        }
+        vec<T,S> max;
+        for (std::size_t i = 0u; i < S; ++i) {
+            max[i] = min[i] + extent(rng);
+        }
+        return bbox<T,S>(min, max);
+    }
+
+    /**
+     * Returns the given number of random boxes, see random_box.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @param count the number of boxes
+     * @param seed the seed of the generator
+     * @param positionRange the range of the min corner components
+     * @param extentRange the range of the box extents
+     * @return the boxes
+     */
+    template <typename T, std::size_t S = 3>
+    std::vector<bbox<T,S>> random_boxes(const std::size_t count, const unsigned seed, const std::pair<T,T>& positionRange, const std::pair<T,T>& extentRange) {
+        std::mt19937 rng(seed);
+        std::vector<bbox<T,S>> result;
+        result.reserve(count);
+        for (std::size_t i = 0u; i < count; ++i) {
+            result.push_back(random_box<T,S>(rng, positionRange, extentRange));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,287 @@
+/*
+ Copyright 2010-2019 Kristian Duske
+ Copyright 2015-2019 Eric Wasylishen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vecmath/forward.h>
+#include <vecmath/approx.h>
+#include <vecmath/mat.h>
+#include <vecmath/vec.h>
+#include <vecmath/vec_io.h>
+#include <vecmath/vec_soa.h>
+
+#include "test_utils.h"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace vm {
+    // 11 vectors, so that the kernels must handle a partial block for every pack width
+    static const auto lhsVecs = std::vector<vec3f> {
+        vec3f( 1.0f,  2.0f,  3.0f), vec3f(-0.5f,  0.3f,  7.1f), vec3f( 0.0f,  0.0f,  1.0f),
+        vec3f( 4.2f, -1.1f,  0.7f), vec3f( 9.0f,  8.0f, -7.0f), vec3f( 0.1f,  0.2f,  0.3f),
+        vec3f(-3.3f,  3.3f, -3.3f), vec3f( 1.5f,  0.0f, -2.5f), vec3f( 6.0f,  1.0f,  0.5f),
+        vec3f( 0.7f, -0.7f,  0.9f), vec3f(12.0f, -4.0f,  3.0f)
+    };
+
+    static const auto rhsVecs = std::vector<vec3f> {
+        vec3f( 3.0f,  2.0f,  1.0f), vec3f( 0.5f, -0.3f,  1.1f), vec3f( 1.0f,  0.0f,  0.0f),
+        vec3f(-4.2f,  1.1f,  2.7f), vec3f( 1.0f,  1.0f,  1.0f), vec3f( 0.3f, -0.2f,  0.1f),
+        vec3f( 3.3f,  3.3f,  3.3f), vec3f(-1.5f,  2.0f,  2.5f), vec3f( 0.0f,  1.0f,  8.5f),
+        vec3f( 0.7f,  0.7f, -0.9f), vec3f(-2.0f,  5.0f,  3.5f)
+    };
+
+    TEST_CASE("vec_soa.constructor_default") {
+        const auto soa = vec_soa<float,3>();
+        CHECK(soa.empty());
+        CHECK(soa.size() == 0u);
+    }
+
+    TEST_CASE("vec_soa.constructor_with_size") {
+        const auto soa = vec_soa<float,3>(5u);
+        CHECK(soa.size() == 5u);
+        for (std::size_t i = 0u; i < soa.size(); ++i) {
+            CHECK(soa[i] == vec3f::zero());
+        }
+    }
+
+    TEST_CASE("vec_soa.to_soa_to_aos") {
+        const auto soa = to_soa(std::begin(lhsVecs), std::end(lhsVecs));
+        CHECK(soa.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(soa[i] == lhsVecs[i]);
+            CHECK(soa.data(0)[i] == lhsVecs[i].x());
+            CHECK(soa.data(1)[i] == lhsVecs[i].y());
+            CHECK(soa.data(2)[i] == lhsVecs[i].z());
+        }
+
+        auto aos = std::vector<vec3f>();
+        to_aos(soa, std::back_inserter(aos));
+        CHECK(aos == lhsVecs);
+    }
+
+    TEST_CASE("vec_soa.to_soa_with_transformation") {
+        const auto soa = to_soa(std::begin(lhsVecs), std::end(lhsVecs), [](const vec3f& v) { return v.xy(); });
+        CHECK(soa.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(soa[i] == lhsVecs[i].xy());
+        }
+    }
+
+    TEST_CASE("vec_soa.push_back") {
+        auto soa = vec_soa<float,3>();
+        soa.push_back(vec3f(1, 2, 3));
+        soa.push_back(vec3f(4, 5, 6));
+
+        const auto& constSoa = soa;
+        CHECK(constSoa.size() == 2u);
+        CHECK(constSoa[0] == vec3f(1, 2, 3));
+        CHECK(constSoa[1] == vec3f(4, 5, 6));
+
+        soa.clear();
+        CHECK(soa.empty());
+    }
+
+    TEST_CASE("vec_soa.reference") {
+        auto soa = vec_soa<float,3>(3u);
+        soa[0] = vec3f(1, 2, 3);
+        soa[1][2] = 7.0f;
+        soa[2] = soa[0];
+
+        const auto& constSoa = soa;
+        CHECK(constSoa[0] == vec3f(1, 2, 3));
+        CHECK(constSoa[1] == vec3f(0, 0, 7));
+        CHECK(constSoa[2] == vec3f(1, 2, 3));
+
+        const vec3f v = soa[1];
+        CHECK(v == vec3f(0, 0, 7));
+    }
+
+    TEST_CASE("vec_soa.operator_binary_plus") {
+        const auto result = to_soa(std::begin(lhsVecs), std::end(lhsVecs)) + to_soa(std::begin(rhsVecs), std::end(rhsVecs));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == lhsVecs[i] + rhsVecs[i]);
+        }
+    }
+
+    TEST_CASE("vec_soa.operator_binary_minus") {
+        const auto result = to_soa(std::begin(lhsVecs), std::end(lhsVecs)) - to_soa(std::begin(rhsVecs), std::end(rhsVecs));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == lhsVecs[i] - rhsVecs[i]);
+        }
+    }
+
+    TEST_CASE("vec_soa.operator_multiply_scalar") {
+        const auto soa = to_soa(std::begin(lhsVecs), std::end(lhsVecs));
+        const auto right = soa * 1.7f;
+        const auto left = 1.7f * soa;
+        REQUIRE(right.size() == lhsVecs.size());
+        REQUIRE(left.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(right[i] == lhsVecs[i] * 1.7f);
+            CHECK(left[i] == 1.7f * lhsVecs[i]);
+        }
+    }
+
+    TEST_CASE("vec_soa.min_max") {
+        const auto lhs = to_soa(std::begin(lhsVecs), std::end(lhsVecs));
+        const auto rhs = to_soa(std::begin(rhsVecs), std::end(rhsVecs));
+        const auto minResult = min(lhs, rhs);
+        const auto maxResult = max(lhs, rhs);
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(minResult[i] == min(lhsVecs[i], rhsVecs[i]));
+            CHECK(maxResult[i] == max(lhsVecs[i], rhsVecs[i]));
+        }
+    }
+
+    // the kernels below may be contracted into fused multiply-add instructions differently than the scalar functions,
+    // so their results are compared with a tolerance
+
+    TEST_CASE("vec_soa.dot") {
+        const auto result = dot(to_soa(std::begin(lhsVecs), std::end(lhsVecs)), to_soa(std::begin(rhsVecs), std::end(rhsVecs)));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == approx(dot(lhsVecs[i], rhsVecs[i])));
+        }
+    }
+
+    TEST_CASE("vec_soa.cross") {
+        const auto result = cross(to_soa(std::begin(lhsVecs), std::end(lhsVecs)), to_soa(std::begin(rhsVecs), std::end(rhsVecs)));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == approx(cross(lhsVecs[i], rhsVecs[i])));
+        }
+    }
+
+    TEST_CASE("vec_soa.normalize") {
+        const auto result = normalize(to_soa(std::begin(lhsVecs), std::end(lhsVecs)));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == approx(normalize(lhsVecs[i])));
+        }
+    }
+
+    TEST_CASE("vec_soa.squared_distance") {
+        const auto result = squared_distance(to_soa(std::begin(lhsVecs), std::end(lhsVecs)), to_soa(std::begin(rhsVecs), std::end(rhsVecs)));
+        REQUIRE(result.size() == lhsVecs.size());
+        for (std::size_t i = 0u; i < lhsVecs.size(); ++i) {
+            CHECK(result[i] == approx(squared_distance(lhsVecs[i], rhsVecs[i])));
+        }
+    }
+
+    TEST_CASE("vec_soa.double_components") {
+        const auto lhs = vec_soa<double,4>(5u);
+        auto rhs = vec_soa<double,4>(5u);
+        for (std::size_t i = 0u; i < rhs.size(); ++i) {
+            rhs[i] = vec4d(double(i), 1.0, -2.0, 0.5);
+        }
+
+        const auto sum = lhs + rhs;
+        const auto sqDist = squared_distance(lhs, rhs);
+        for (std::size_t i = 0u; i < rhs.size(); ++i) {
+            CHECK(sum[i] == vec4d(double(i), 1.0, -2.0, 0.5));
+            CHECK(sqDist[i] == squared_length(vec4d(double(i), 1.0, -2.0, 0.5)));
+        }
+    }
+
+    template <typename T, std::size_t S>
+    static void check_lup_solve(const std::vector<mat<T,S,S>>& matrices, const std::vector<vec<T,S>>& rhs) {
+        std::array<vec_soa<T,S>, S> columns;
+        for (const auto& m : matrices) {
+            for (std::size_t c = 0u; c < S; ++c) {
+                columns[c].push_back(m[c]);
+            }
+        }
+        const auto b = to_soa(std::begin(rhs), std::end(rhs));
+
+        const auto [solved, x] = lup_solve(columns, b);
+        REQUIRE(solved.size() == matrices.size());
+        REQUIRE(x.size() == matrices.size());
+
+        for (std::size_t i = 0u; i < matrices.size(); ++i) {
+            const auto [expectedSolved, expectedX] = lup_solve(matrices[i], rhs[i]);
+            CHECK(solved[i] == expectedSolved);
+            if (expectedSolved) {
+                CHECK(x[i] == expectedX);
+            } else {
+                CHECK(x[i] == vec<T,S>::zero());
+            }
+        }
+    }
+
+    TEST_CASE("vec_soa.lup_solve") {
+        auto matrices = std::vector<mat3x3d>();
+        auto rhs = std::vector<vec3d>();
+        for (std::size_t i = 0u; i < 19u; ++i) {
+            const auto t = static_cast<double>(i);
+            // every fifth matrix is singular, and the varying magnitudes lead to different pivots in each system
+            const auto m = i % 5u == 3u
+                ? mat3x3d(1, 2, 3, 2, 4, 6, t, -t, 1)
+                : mat3x3d(
+                    std::sin(t),        3.0 - t,   0.5 * t,
+                    t * t / 10.0 - 2.0, std::cos(t), 1.0,
+                    -1.0,               t / 3.0,   std::sin(2.0 * t) + 0.1);
+            matrices.push_back(m);
+            rhs.push_back(vec3d(t, 1.0 - t, 2.0));
+        }
+
+        check_lup_solve(matrices, rhs);
+
+        auto matricesf = std::vector<mat3x3f>();
+        auto rhsf = std::vector<vec3f>();
+        for (std::size_t i = 0u; i < matrices.size(); ++i) {
+            matricesf.push_back(mat3x3f(matrices[i]));
+            rhsf.push_back(vec3f(rhs[i]));
+        }
+        check_lup_solve(matricesf, rhsf);
+    }
+
+    TEST_CASE("vec_soa.lup_solve_4x4") {
+        const auto matrices = std::vector<mat4x4d> {
+            mat4x4d(
+                 0.93629336358419923, -0.27509584731824366,  0.21835066314633442,  87.954817941228995,
+                 0.28962947762551555,  0.95642508584923236, -0.03695701352462509, 120.90975499501228,
+                -0.19866933079506122, -0.09784339500725571,  0.97517032720181584,  87.434439141401043,
+                 0,                    0,                    0,                     1),
+            mat4x4d(
+                65, 12, -3, -5,
+                -5,  1,  0,  0,
+                19, 10, 11,  8,
+                 0,  1, -8,  3),
+            mat4x4d::zero(),
+            mat4x4d(
+                 0,  0, -1,    0,
+                -1,  0,  0,    0,
+                 0,  1,  0, -128,
+                 0,  0,  0,    1),
+            mat4x4d::identity()
+        };
+        const auto rhs = std::vector<vec4d> { vec4d(1, 2, 3, 4), vec4d(-5, 6, 7, 8), vec4d(1, 1, 1, 1), vec4d(20, -60, 32, 1), vec4d(4, 3, 2, 1) };
+
+        check_lup_solve(matrices, rhs);
+    }
+
+    TEST_CASE("vec_soa.lup_solve_empty") {
+        const auto [solved, x] = lup_solve(std::array<vec_soa<double,3>, 3>(), vec_soa<double,3>());
+        CHECK(solved.empty());
+        CHECK(x.empty());
+    }
+}